@@ -0,0 +1,8 @@
+#version 120
+
+uniform sampler2D atlas;
+
+void main()
+{
+	gl_FragColor = gl_Color * texture2D(atlas, gl_TexCoord[0].xy);
+}
@@ -0,0 +1,21 @@
+#version 120
+
+//Offset (xy) and scale (zw) of the tile of the atlas the entity shows
+uniform mat4 worldViewProj;
+uniform vec4 tileTransform;
+
+//Lit like a fixed function pass: the ambient light plus the diffuse colour of the
+//first light, the light position in object space (w is 0 for a directional light)
+uniform vec4 ambient;
+uniform vec4 lightPosition;
+uniform vec4 lightDiffuse;
+
+void main()
+{
+	gl_Position = worldViewProj * gl_Vertex;
+	gl_TexCoord[0] = vec4(gl_MultiTexCoord0.xy * tileTransform.zw + tileTransform.xy, 0.0, 1.0);
+
+	vec3 toLight = normalize(lightPosition.xyz - gl_Vertex.xyz * lightPosition.w);
+	float diffuse = max(dot(normalize(gl_Normal), toLight), 0.0);
+	gl_FrontColor = clamp(ambient + lightDiffuse * diffuse, 0.0, 1.0);
+}
@@ -0,0 +1,425 @@
+//============================================================================
+// Name        : AssetCooker.cpp
+// Author      : Amrit Dhakal
+// Version     : 1.0
+// Copyright   : © Amrit Dhakal 2015. All right reserved. :D
+// Description : Offline optimisation of the game's meshes
+//============================================================================
+
+#include "AssetCooker.h"
+#include "VertexCache.h"
+
+#include <OgreDefaultHardwareBufferManager.h>
+#include <OgreProgressiveMeshGenerator.h>
+#include <algorithm>
+#include <string.h>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <dirent.h>
+#include <sys/stat.h>
+
+using namespace std;
+using namespace Ogre;
+
+//Meshes cooked, relative to the source directory, and whether they get LOD levels
+static const struct {
+	const char* dir;
+	const char* file;
+	bool lod;
+} MESHES[] = {
+	{"Numbers", "1.mesh", true},
+	{"Numbers", "2.mesh", true},
+	{"Numbers", "3.mesh", true},
+	{"Numbers", "4.mesh", true},
+	{"Numbers", "5.mesh", true},
+	{"Numbers", "6.mesh", true},
+	{"Numbers", "7.mesh", true},
+	{"Numbers", "8.mesh", true},
+	{"Detector", "Detector.mesh", true},
+	{"Mine", "Mine.mesh", false},
+	{"Flag", "Flag.mesh", false}
+};
+
+//Camera distances of the LOD levels and the fraction of vertices each one removes.
+//The camera looks at the board from about 650 units away.
+static const Real LOD_DISTANCES[] = {700, 900};
+static const Real LOD_REDUCTIONS[] = {0.5, 0.75};
+
+//Cache size the cache miss ratio of the manifest is measured with
+static const int MANIFEST_CACHE_SIZE = 16;
+
+/**
+ * Returns the size of the file in bytes, -1 if it does not exist
+ */
+static long fileSize(const string &path){
+	struct stat info;
+	if(stat(path.c_str(), &info) != 0){
+		return -1;
+	}
+	return info.st_size;
+}
+
+AssetCooker::AssetCooker(const string &sourceDir, const string &outputDir):
+					mSourceDir(sourceDir),
+					mOutputDir(outputDir)
+{
+}
+
+int AssetCooker::main(int argc, char *argv[]){
+	string source = argc > 0 ? argv[0] : "Media";
+	string output = argc > 1 ? argv[1] : "Media/Cooked";
+
+	//No plugins and no render system: meshes are kept in system memory buffers
+	Root* root = new Root("", "", "AssetCooker.log");
+	DefaultHardwareBufferManager* buffers = new DefaultHardwareBufferManager();
+
+	bool cooked;
+	{
+		AssetCooker cooker(source, output);
+		cooked = cooker.run();
+	}
+
+	MeshManager::getSingleton().removeAll();
+	delete buffers;
+	delete root;
+	return cooked ? 0 : 1;
+}
+
+bool AssetCooker::run(){
+	mkdir(mOutputDir.c_str(), 0755);
+	string manifestFile = mOutputDir + "/manifest.txt";
+	ofstream manifest(manifestFile.c_str());
+	if(!manifest.is_open()){
+		cerr << "File " << manifestFile << " could not be opened." << endl;
+		return false;
+	}
+	manifest << "#mesh\tvertices\tcooked_vertices\ttriangles\tacmr\tcooked_acmr\tlod_levels\tbytes\tcooked_bytes" << endl;
+
+	int numMeshes = sizeof(MESHES) / sizeof(MESHES[0]);
+	vector<string> dirs;
+	for(int i = 0; i < numMeshes; i++){
+		if(find(dirs.begin(), dirs.end(), MESHES[i].dir) == dirs.end()){
+			dirs.push_back(MESHES[i].dir);
+		}
+	}
+
+	bool success = true;
+	for(int i = 0; i < dirs.size(); i++){
+		mkdir((mOutputDir + "/" + dirs[i]).c_str(), 0755);
+		readMaterials(dirs[i]);
+		success = copyOtherFiles(dirs[i]) && success;
+	}
+	for(int i = 0; i < numMeshes; i++){
+		success = cook(MESHES[i].dir, MESHES[i].file, MESHES[i].lod, manifest) && success;
+	}
+	return success;
+}
+
+void AssetCooker::readMaterials(const string &dir){
+	string path = mSourceDir + "/" + dir;
+	DIR* directory = opendir(path.c_str());
+	if(!directory){
+		return;
+	}
+	while(dirent* entry = readdir(directory)){
+		string name = entry->d_name;
+		if(!StringUtil::endsWith(name, ".material")){
+			continue;
+		}
+		ifstream in((path + "/" + name).c_str());
+		string token;
+		MaterialUse* current = 0;
+		while(in >> token){
+			if(token == "material" && in >> token){
+				MaterialUse use = {false, false};
+				current = &(mMaterials[token] = use);
+			}
+			else if(current && token == "texture"){
+				current->textured = true;
+			}
+			else if(current && token == "vertexcolour"){
+				current->vertexColours = true;
+			}
+		}
+	}
+	closedir(directory);
+}
+
+bool AssetCooker::copyOtherFiles(const string &dir){
+	string path = mSourceDir + "/" + dir;
+	DIR* directory = opendir(path.c_str());
+	if(!directory){
+		cerr << "Directory " << path << " could not be opened." << endl;
+		return false;
+	}
+	bool success = true;
+	while(dirent* entry = readdir(directory)){
+		string name = entry->d_name;
+		if(name[0] == '.' || StringUtil::endsWith(name, ".mesh") || StringUtil::endsWith(name, ".mesh.xml")){
+			continue;
+		}
+		ifstream in((path + "/" + name).c_str(), ios::binary);
+		ofstream out((mOutputDir + "/" + dir + "/" + name).c_str(), ios::binary);
+		if(!in.is_open() || !out.is_open()){
+			cerr << "File " << name << " could not be copied." << endl;
+			success = false;
+			continue;
+		}
+		out << in.rdbuf();
+	}
+	closedir(directory);
+	return success;
+}
+
+map<VertexData*, AssetCooker::VertexUsers> AssetCooker::findVertexUsers(Mesh* mesh){
+	map<VertexData*, VertexUsers> users;
+	for(int i = 0; i < mesh->getNumSubMeshes(); i++){
+		SubMesh* sub = mesh->getSubMesh(i);
+		VertexData* vertexData = sub->useSharedVertices ? mesh->sharedVertexData : sub->vertexData;
+		VertexUsers &user = users[vertexData];
+		if(user.indexData.empty() && user.materials.empty()){
+			user.triangleLists = true;
+		}
+		user.indexData.push_back(sub->indexData);
+		user.materials.push_back(sub->getMaterialName());
+		if(sub->operationType != RenderOperation::OT_TRIANGLE_LIST){
+			user.triangleLists = false;
+		}
+	}
+	for(int i = 0; i < mesh->getNumSubMeshes(); i++){
+		SubMesh* sub = mesh->getSubMesh(i);
+		VertexData* vertexData = sub->useSharedVertices ? mesh->sharedVertexData : sub->vertexData;
+		for(int lod = 0; lod < sub->mLodFaceList.size(); lod++){
+			vector<IndexData*> &lists = users[vertexData].indexData;
+			if(find(lists.begin(), lists.end(), sub->mLodFaceList[lod]) == lists.end()){
+				lists.push_back(sub->mLodFaceList[lod]);
+			}
+		}
+	}
+	return users;
+}
+
+void AssetCooker::stripVertexElements(VertexData* vertexData, const vector<string> &materials){
+	//A material that was not found may read anything
+	bool textured = false;
+	bool vertexColours = false;
+	for(int i = 0; i < materials.size(); i++){
+		map<string, MaterialUse>::iterator it = mMaterials.find(materials[i]);
+		textured = textured || it == mMaterials.end() || it->second.textured;
+		vertexColours = vertexColours || it == mMaterials.end() || it->second.vertexColours;
+	}
+
+	//The materials are all fixed function, nothing reads tangents or binormals
+	VertexDeclaration* declaration = vertexData->vertexDeclaration->clone();
+	declaration->removeElement(VES_TANGENT);
+	declaration->removeElement(VES_BINORMAL);
+	if(!textured){
+		for(int i = 0; i < OGRE_MAX_TEXTURE_COORD_SETS; i++){
+			declaration->removeElement(VES_TEXTURE_COORDINATES, i);
+		}
+	}
+	if(!vertexColours){
+		declaration->removeElement(VES_DIFFUSE);
+		declaration->removeElement(VES_SPECULAR);
+	}
+
+	//Copies the elements left into buffers laid out for the declaration
+	VertexDeclaration* organised = declaration->getAutoOrganisedDeclaration(false, false, false);
+	HardwareBufferManager::getSingleton().destroyVertexDeclaration(declaration);
+	vertexData->reorganiseBuffers(organised);
+	vertexData->removeUnusedBuffers();
+}
+
+vector<uint32_t> AssetCooker::readIndices(IndexData* indexData){
+	vector<uint32_t> indices(indexData->indexCount);
+	if(indexData->indexCount == 0 || indexData->indexBuffer.isNull()){
+		return indices;
+	}
+	HardwareIndexBufferSharedPtr buffer = indexData->indexBuffer;
+	if(buffer->getType() == HardwareIndexBuffer::IT_32BIT){
+		buffer->readData(indexData->indexStart * 4, indices.size() * 4, &indices[0]);
+	}
+	else {
+		vector<uint16_t> shortIndices(indices.size());
+		buffer->readData(indexData->indexStart * 2, shortIndices.size() * 2, &shortIndices[0]);
+		copy(shortIndices.begin(), shortIndices.end(), indices.begin());
+	}
+	return indices;
+}
+
+void AssetCooker::writeIndices(IndexData* indexData, const vector<uint32_t> &indices){
+	if(indices.empty()){
+		return;
+	}
+	uint32_t largest = *max_element(indices.begin(), indices.end());
+	HardwareIndexBufferSharedPtr buffer;
+	if(largest > 0xffff){
+		buffer = HardwareBufferManager::getSingleton().createIndexBuffer(HardwareIndexBuffer::IT_32BIT,
+				indices.size(), HardwareBuffer::HBU_STATIC_WRITE_ONLY);
+		buffer->writeData(0, indices.size() * 4, &indices[0], true);
+	}
+	else {
+		vector<uint16_t> shortIndices(indices.begin(), indices.end());
+		buffer = HardwareBufferManager::getSingleton().createIndexBuffer(HardwareIndexBuffer::IT_16BIT,
+				indices.size(), HardwareBuffer::HBU_STATIC_WRITE_ONLY);
+		buffer->writeData(0, shortIndices.size() * 2, &shortIndices[0], true);
+	}
+	indexData->indexBuffer = buffer;
+	indexData->indexStart = 0;
+	indexData->indexCount = indices.size();
+}
+
+void AssetCooker::optimize(VertexData* vertexData, const vector<IndexData*> &indexData){
+	uint32_t numVertices = vertexData->vertexCount;
+
+	//Bytes of every vertex buffer
+	const VertexBufferBinding::VertexBufferBindingMap &bindings = vertexData->vertexBufferBinding->getBindings();
+	vector<unsigned short> sources;
+	vector<size_t> vertexSizes;
+	vector<vector<unsigned char> > bytes;
+	for(VertexBufferBinding::VertexBufferBindingMap::const_iterator it = bindings.begin(); it != bindings.end(); ++it){
+		size_t vertexSize = it->second->getVertexSize();
+		sources.push_back(it->first);
+		vertexSizes.push_back(vertexSize);
+		bytes.push_back(vector<unsigned char>(vertexSize * numVertices));
+		it->second->readData(vertexData->vertexStart * vertexSize, vertexSize * numVertices, &bytes.back()[0]);
+	}
+
+	//Vertices with the same bytes in every buffer are the same vertex
+	map<string, uint32_t> firstWithBytes;
+	vector<uint32_t> same(numVertices);
+	for(uint32_t v = 0; v < numVertices; v++){
+		string key;
+		for(int b = 0; b < bytes.size(); b++){
+			key.append((const char*)&bytes[b][v * vertexSizes[b]], vertexSizes[b]);
+		}
+		same[v] = firstWithBytes.insert(make_pair(key, v)).first->second;
+	}
+
+	vector<vector<uint32_t> > lists;
+	for(int i = 0; i < indexData.size(); i++){
+		lists.push_back(readIndices(indexData[i]));
+		vector<uint32_t> &indices = lists.back();
+		for(int j = 0; j < indices.size(); j++){
+			indices[j] = same[indices[j]];
+		}
+		optimizeVertexCache(indices, numVertices);
+	}
+
+	//Vertices are numbered by first use, the full detail lists coming first
+	vector<uint32_t> all;
+	for(int i = 0; i < lists.size(); i++){
+		all.insert(all.end(), lists[i].begin(), lists[i].end());
+	}
+	vector<uint32_t> order = optimizeVertexFetch(all, numVertices);
+	size_t offset = 0;
+	for(int i = 0; i < lists.size(); i++){
+		copy(all.begin() + offset, all.begin() + offset + lists[i].size(), lists[i].begin());
+		offset += lists[i].size();
+		writeIndices(indexData[i], lists[i]);
+	}
+
+	for(int b = 0; b < sources.size(); b++){
+		vector<unsigned char> reordered(vertexSizes[b] * order.size());
+		for(uint32_t v = 0; v < order.size(); v++){
+			memcpy(&reordered[v * vertexSizes[b]], &bytes[b][order[v] * vertexSizes[b]], vertexSizes[b]);
+		}
+		HardwareVertexBufferSharedPtr buffer = HardwareBufferManager::getSingleton().createVertexBuffer(
+				vertexSizes[b], order.size(), HardwareBuffer::HBU_STATIC_WRITE_ONLY);
+		buffer->writeData(0, reordered.size(), &reordered[0], true);
+		vertexData->vertexBufferBinding->setBinding(sources[b], buffer);
+	}
+	vertexData->vertexStart = 0;
+	vertexData->vertexCount = order.size();
+}
+
+void AssetCooker::generateLod(MeshPtr mesh){
+	LodConfig config;
+	config.mesh = mesh;
+	config.strategy = LodStrategyManager::getSingleton().getDefaultStrategy();
+	for(int i = 0; i < sizeof(LOD_DISTANCES) / sizeof(LOD_DISTANCES[0]); i++){
+		LodLevel level;
+		level.distance = LOD_DISTANCES[i];
+		level.reductionMethod = LodLevel::VRM_PROPORTIONAL;
+		level.reductionValue = LOD_REDUCTIONS[i];
+		config.levels.push_back(level);
+	}
+	ProgressiveMeshGenerator generator;
+	generator.generateLodLevels(config);
+}
+
+void AssetCooker::measure(Mesh* mesh, size_t &vertices, size_t &triangles, double &acmr){
+	vertices = mesh->sharedVertexData ? mesh->sharedVertexData->vertexCount : 0;
+	triangles = 0;
+	double misses = 0;
+	for(int i = 0; i < mesh->getNumSubMeshes(); i++){
+		SubMesh* sub = mesh->getSubMesh(i);
+		if(!sub->useSharedVertices){
+			vertices += sub->vertexData->vertexCount;
+		}
+		if(sub->operationType != RenderOperation::OT_TRIANGLE_LIST){
+			continue;
+		}
+		vector<uint32_t> indices = readIndices(sub->indexData);
+		triangles += indices.size() / 3;
+		misses += averageCacheMissRatio(indices, MANIFEST_CACHE_SIZE) * (indices.size() / 3);
+	}
+	acmr = triangles ? misses / triangles : 0;
+}
+
+bool AssetCooker::cook(const string &dir, const string &file, bool generateLodLevels, ostream &manifest){
+	string source = mSourceDir + "/" + dir + "/" + file;
+	string output = mOutputDir + "/" + dir + "/" + file;
+	if(fileSize(source) < 0){
+		cerr << "File " << source << " could not be opened." << endl;
+		return false;
+	}
+	try {
+		std::ifstream* in = OGRE_NEW_T(std::ifstream, MEMCATEGORY_GENERAL)(source.c_str(), std::ios::binary);
+		DataStreamPtr stream(OGRE_NEW FileStreamDataStream(source, in, true));
+		MeshPtr mesh = MeshManager::getSingleton().createManual(dir + "/" + file,
+				ResourceGroupManager::DEFAULT_RESOURCE_GROUP_NAME);
+		MeshSerializer serializer;
+		serializer.importMesh(stream, mesh.getPointer());
+
+		size_t vertices, triangles;
+		double acmr;
+		measure(mesh.getPointer(), vertices, triangles, acmr);
+
+		map<VertexData*, VertexUsers> users = findVertexUsers(mesh.getPointer());
+		for(map<VertexData*, VertexUsers>::iterator it = users.begin(); it != users.end(); ++it){
+			stripVertexElements(it->first, it->second.materials);
+		}
+
+		//Skinned vertices are left in place, their bone assignments refer to them by index
+		bool renumber = !mesh->hasSkeleton();
+		if(generateLodLevels && renumber){
+			generateLod(mesh);
+		}
+		if(renumber){
+			users = findVertexUsers(mesh.getPointer());
+			for(map<VertexData*, VertexUsers>::iterator it = users.begin(); it != users.end(); ++it){
+				if(it->second.triangleLists){
+					optimize(it->first, it->second.indexData);
+				}
+			}
+		}
+
+		//Edge lists are only used by stencil shadows, which the game does not have
+		mesh->freeEdgeList();
+		serializer.exportMesh(mesh.getPointer(), output);
+
+		size_t cookedVertices, cookedTriangles;
+		double cookedAcmr;
+		measure(mesh.getPointer(), cookedVertices, cookedTriangles, cookedAcmr);
+		manifest << dir << "/" << file << "\t" << vertices << "\t" << cookedVertices << "\t" << triangles
+				<< "\t" << acmr << "\t" << cookedAcmr << "\t" << mesh->getNumLodLevels() - 1
+				<< "\t" << fileSize(source) << "\t" << fileSize(output) << endl;
+		MeshManager::getSingleton().remove(mesh->getHandle());
+	} catch(Ogre::Exception &e){
+		cerr << "Mesh " << source << " could not be cooked: " << e.getFullDescription() << endl;
+		return false;
+	}
+	return true;
+}
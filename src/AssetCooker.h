@@ -0,0 +1,132 @@
+//============================================================================
+// Name        : AssetCooker.h
+// Author      : Amrit Dhakal
+// Version     : 1.0
+// Copyright   : © Amrit Dhakal 2015. All right reserved. :D
+// Description : Offline optimisation of the game's meshes
+//============================================================================
+
+#ifndef ASSETCOOKER_H_
+#define ASSETCOOKER_H_
+
+#include <Ogre.h>
+#include <map>
+#include <ostream>
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+/**
+ * Class AssetCooker rewrites the meshes of the game, without a window or render system:
+ * 		- vertex elements no material of the mesh reads are stripped
+ * 		- LOD levels are generated for the number meshes and the detector
+ * 		- identical vertices are merged
+ * 		- triangles are reordered for the post-transform vertex cache, and vertices
+ * 		  in the order the triangles use them
+ * The cooked meshes are written to the output directory, next to a copy of the
+ * materials and textures of each directory, with a manifest of what was done.
+ *
+ * Run with: MineSweeper --cook-assets [source] [output]
+ * 		source: media directory to read (default Media)
+ * 		output: directory to write (default Media/Cooked), which the Cooked= locations
+ * 				of resources.cfg load from while it is newer than the source media
+ */
+class AssetCooker {
+public:
+
+	/**
+	 * Constructor:
+	 * 		parameter:
+	 * 			sourceDir: media directory to read
+	 * 			outputDir: directory to write
+	 */
+	AssetCooker(const std::string &sourceDir, const std::string &outputDir);
+
+	/**
+	 * run: cooks every mesh and writes the manifest
+	 * 		return: true if every mesh was cooked
+	 */
+	bool run();
+
+	/**
+	 * main: parses the command line arguments following --cook-assets and runs the cooker
+	 * 		return: the exit code of the program
+	 */
+	static int main(int argc, char *argv[]);
+
+protected:
+
+	/**
+	 * What the passes of a material read from the vertices
+	 */
+	struct MaterialUse {
+		bool textured;
+		bool vertexColours;
+	};
+
+	/**
+	 * Index lists sharing one vertex data
+	 */
+	struct VertexUsers {
+		//Every LOD of every submesh, the full detail lists first
+		std::vector<Ogre::IndexData*> indexData;
+		std::vector<std::string> materials;
+		//False if a submesh is not a triangle list, the indices are then left alone
+		bool triangleLists;
+	};
+
+	/**
+	 * Reads which materials of the .material files in the directory use textures and vertex colours
+	 */
+	void readMaterials(const std::string &dir);
+
+	/**
+	 * Copies every file of the directory that is not a mesh to the output directory
+	 */
+	bool copyOtherFiles(const std::string &dir);
+
+	/**
+	 * Cooks one mesh and writes a line of the manifest
+	 */
+	bool cook(const std::string &dir, const std::string &file, bool generateLod, std::ostream &manifest);
+
+	/**
+	 * Groups the index lists of the mesh (every LOD) by the vertex data they use
+	 */
+	std::map<Ogre::VertexData*, VertexUsers> findVertexUsers(Ogre::Mesh* mesh);
+
+	/**
+	 * Removes the vertex elements none of the materials read
+	 */
+	void stripVertexElements(Ogre::VertexData* vertexData, const std::vector<std::string> &materials);
+
+	/**
+	 * Merges identical vertices, orders the triangles of each index list for the
+	 * vertex cache then the vertices by first use, dropping unused ones
+	 */
+	void optimize(Ogre::VertexData* vertexData, const std::vector<Ogre::IndexData*> &indexData);
+
+	/**
+	 * Adds LOD levels to the mesh
+	 */
+	void generateLod(Ogre::MeshPtr mesh);
+
+	/**
+	 * Counts the vertices of the mesh and measures the vertex cache of its full detail lists
+	 */
+	static void measure(Ogre::Mesh* mesh, size_t &vertices, size_t &triangles, double &acmr);
+
+	static std::vector<uint32_t> readIndices(Ogre::IndexData* indexData);
+	static void writeIndices(Ogre::IndexData* indexData, const std::vector<uint32_t> &indices);
+
+	//Directory read
+	std::string mSourceDir;
+
+	//Directory written
+	std::string mOutputDir;
+
+	//Materials read from the .material files, by name
+	std::map<std::string, MaterialUse> mMaterials;
+};
+
+#endif /* ASSETCOOKER_H_ */
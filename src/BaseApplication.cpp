@@ -16,11 +16,15 @@ http://www.ogre3d.org/wiki/
 */
 
 #include "BaseApplication.h"
+#include "Constants.h"
 
 #if OGRE_PLATFORM == OGRE_PLATFORM_APPLE
 #include <macUtils.h>
 #endif
 
+#include <dirent.h>
+#include <sys/stat.h>
+
 //---------------------------------------------------------------------------
 BaseApplication::BaseApplication(void)
     : mRoot(0),
@@ -37,7 +41,14 @@ BaseApplication::BaseApplication(void)
     mInputManager(0),
     mMouse(0),
     mKeyboard(0),
-    mOverlaySystem(0)
+    mInputThread(0),
+    mOverlaySystem(0),
+    mProduction(false),
+    mLastStartupPhase(0),
+    mFirstFrame(true),
+    mRedrawRequested(true),
+    mIdleFrame(false),
+    mKeysDown(0)
 {
 #if OGRE_PLATFORM == OGRE_PLATFORM_APPLE
     m_ResourcePath = Ogre::macBundlePath() + "/Contents/Resources/";
@@ -62,9 +73,25 @@ BaseApplication::~BaseApplication(void)
 //---------------------------------------------------------------------------
 bool BaseApplication::configure(void)
 {
+    // Use the settings saved in ogre.cfg if there are valid ones, so the
+    // configuration dialog is only shown the first time the game is run.
+    if(mRoot->restoreConfig())
+    {
+        mWindow = mRoot->initialise(true, "TutorialApplication Render Window");
+        return true;
+    }
+
+    // The production profile never blocks on the dialog: it takes the first
+    // render system with its default settings and saves them for next time.
+    if(mProduction && !mRoot->getAvailableRenderers().empty())
+    {
+        mRoot->setRenderSystem(mRoot->getAvailableRenderers().front());
+        mRoot->saveConfig();
+        mWindow = mRoot->initialise(true, "TutorialApplication Render Window");
+        return true;
+    }
+
     // Show the configuration dialog and initialise the system.
-    // You can skip this and use root.restoreConfig() to load configuration
-    // settings if you were sure there are valid ones saved in ogre.cfg.
     if(mRoot->showConfigDialog())
     {
         // If returned true, user clicked OK so initialise.
@@ -119,12 +146,12 @@ void BaseApplication::createFrameListener(void)
     mKeyboard = static_cast<OIS::Keyboard*>(mInputManager->createInputObject(OIS::OISKeyboard, true));
     mMouse = static_cast<OIS::Mouse*>(mInputManager->createInputObject(OIS::OISMouse, true));
 
-    mMouse->setEventCallback(this);
-    mKeyboard->setEventCallback(this);
-
     // Set initial mouse clipping size
     windowResized(mWindow);
 
+    // Sample input on its own thread, the events are handled in frameRenderingQueued
+    mInputThread = new InputThread(mKeyboard, mMouse, mRoot->getTimer(), INPUT_POLL_RATE);
+
     // Register as a Window listener
     Ogre::WindowEventUtilities::addWindowEventListener(mWindow, this);
 
@@ -171,6 +198,42 @@ void BaseApplication::createViewports(void)
     mCamera->setAspectRatio(Ogre::Real(vp->getActualWidth()) / Ogre::Real(vp->getActualHeight()));
 }
 //---------------------------------------------------------------------------
+// Returns the copy of a media directory cooked by MineSweeper --cook-assets (Media/X
+// is cooked to Media/Cooked/X), or the directory itself if it was not cooked or a
+// file of it changed after the cook
+static Ogre::String cookedLocation(const Ogre::String& source)
+{
+    Ogre::String name, parent;
+    Ogre::StringUtil::splitFilename(source, name, parent);
+    Ogre::String cooked = parent + "Cooked/" + name;
+    Ogre::String manifestFile = parent + "Cooked/manifest.txt";
+
+    struct stat manifest, info;
+    if (stat(manifestFile.c_str(), &manifest) != 0 || stat(cooked.c_str(), &info) != 0)
+    {
+        Ogre::LogManager::getSingleton().logMessage(source + " is not cooked, loading the source media");
+        return source;
+    }
+    bool stale = false;
+    if (DIR* dir = opendir(source.c_str()))
+    {
+        while (dirent* entry = readdir(dir))
+        {
+            Ogre::String file = source + "/" + entry->d_name;
+            if (stat(file.c_str(), &info) == 0 && S_ISREG(info.st_mode) && info.st_mtime > manifest.st_mtime)
+                stale = true;
+        }
+        closedir(dir);
+    }
+    if (stale)
+    {
+        Ogre::LogManager::getSingleton().logMessage(source + " changed after " + manifestFile
+            + " was written, loading the source media");
+        return source;
+    }
+    return cooked;
+}
+//---------------------------------------------------------------------------
 void BaseApplication::setupResources(void)
 {
     // Load resource paths from config file
@@ -191,6 +254,13 @@ void BaseApplication::setupResources(void)
             typeName = i->first;
             archName = i->second;
 
+            // Cooked=dir loads the cooked copy of dir while it is up to date
+            if (typeName == "Cooked")
+            {
+                typeName = "FileSystem";
+                archName = cookedLocation(archName);
+            }
+
 #if OGRE_PLATFORM == OGRE_PLATFORM_APPLE
             // OS X does not set the working directory relative to the app.
             // In order to make things portable on OS X we need to provide
@@ -214,8 +284,20 @@ void BaseApplication::loadResources(void)
     Ogre::ResourceGroupManager::getSingleton().initialiseAllResourceGroups();
 }
 //---------------------------------------------------------------------------
+void BaseApplication::logStartupPhase(const Ogre::String& phase)
+{
+    unsigned long now = mStartupTimer.getMilliseconds();
+    Ogre::LogManager::getSingletonPtr()->logMessage("*** Startup: " + phase + " took "
+        + Ogre::StringConverter::toString(now - mLastStartupPhase) + " ms ("
+        + Ogre::StringConverter::toString(now) + " ms since start) ***");
+    mLastStartupPhase = now;
+}
+//---------------------------------------------------------------------------
 void BaseApplication::go(void)
 {
+    mStartupTimer.reset();
+    mLastStartupPhase = 0;
+
 #ifdef _DEBUG
 #ifndef OGRE_STATIC_LIB
     mResourcesCfg = m_ResourcePath + "resources_d.cfg";
@@ -234,10 +316,24 @@ void BaseApplication::go(void)
 #endif
 #endif
 
+    if (mProduction)
+    {
+        mResourcesCfg = m_ResourcePath + "resources_production.cfg";
+        mPluginsCfg = m_ResourcePath + "plugins_production.cfg";
+    }
+
     if (!setup())
         return;
 
+#ifdef MINESWEEPER_PROFILING
+    // The profiler takes the time between two frames for the frame time
     mRoot->startRendering();
+#else
+    if (RENDER_ON_DEMAND)
+        renderLoop();
+    else
+        mRoot->startRendering();
+#endif
 
     // Clean up
     destroyScene();
@@ -246,15 +342,19 @@ void BaseApplication::go(void)
 bool BaseApplication::setup(void)
 {
     mRoot = new Ogre::Root(mPluginsCfg);
+    logStartupPhase("loading plugins (" + mPluginsCfg + ")");
 
     setupResources();
+    logStartupPhase("registering resource locations (" + mResourcesCfg + ")");
 
     bool carryOn = configure();
     if (!carryOn) return false;
+    logStartupPhase("configuring the render system");
 
     chooseSceneManager();
     createCamera();
     createViewports();
+    logStartupPhase("creating the scene manager, camera and viewport");
 
     // Set default mipmap level (NB some APIs ignore this)
     Ogre::TextureManager::getSingleton().setDefaultNumMipmaps(5);
@@ -263,11 +363,14 @@ bool BaseApplication::setup(void)
     createResourceListener();
     // Load resources
     loadResources();
+    logStartupPhase("initialising resource groups");
 
     // Create the scene
     createScene();
+    logStartupPhase("creating the scene");
 
     createFrameListener();
+    logStartupPhase("creating the input and overlays");
 
     return true;
 };
@@ -280,9 +383,14 @@ bool BaseApplication::frameRenderingQueued(const Ogre::FrameEvent& evt)
     if(mShutDown)
         return false;
 
-    // Need to capture/update each device
-    mKeyboard->capture();
-    mMouse->capture();
+    if (mFirstFrame)
+    {
+        mFirstFrame = false;
+        logStartupPhase("first frame");
+    }
+
+    // Handle the input captured since the last frame
+    mInputThread->dispatch(this, this);
 
     mTrayMgr->frameRenderingQueued(evt);
 
@@ -304,8 +412,62 @@ bool BaseApplication::frameRenderingQueued(const Ogre::FrameEvent& evt)
     return true;
 }
 //---------------------------------------------------------------------------
+void BaseApplication::renderLoop(void)
+{
+    // What Root::startRendering does, without drawing frames nobody would see change
+    mRoot->getRenderSystem()->_initRenderTargets();
+    mRoot->clearEventTimes();
+
+    Ogre::Timer* timer = mRoot->getTimer();
+    unsigned long idleInterval = 1000000 / RENDER_IDLE_FRAME_RATE;
+    unsigned long linger = (unsigned long)(RENDER_ACTIVE_LINGER * 1000000);
+    unsigned long lastFrame = 0;
+    unsigned long lastActive = timer->getMicroseconds();
+    bool lastFrameActive = false;
+    while (!mShutDown)
+    {
+        Ogre::WindowEventUtilities::messagePump();
+        if (mWindow->isClosed())
+            break;
+
+        unsigned long now = timer->getMicroseconds();
+        if (mRedrawRequested || isAnimating() || (mInputThread && mInputThread->hasEvents()))
+            lastActive = now;
+
+        // Keep drawing for a while after the last change, so what follows it (a camera
+        // slowing down, the result of a click) is shown
+        bool active = now - lastActive < linger;
+        if (active || now - lastFrame >= idleInterval)
+        {
+            // Only two frames drawn back to back measure how long a frame takes
+            mIdleFrame = !active || !lastFrameActive;
+            lastFrameActive = active;
+            mRedrawRequested = false;
+            lastFrame = now;
+            if (!mRoot->renderOneFrame())
+                break;
+        }
+        else if (mInputThread)
+        {
+            // Woken as soon as the input thread queues an event
+            mInputThread->waitForEvents(idleInterval - (now - lastFrame));
+        }
+    }
+}
+//---------------------------------------------------------------------------
+bool BaseApplication::isAnimating(void)
+{
+    return mKeysDown > 0;
+}
+//---------------------------------------------------------------------------
+unsigned long BaseApplication::getInputTime(void)
+{
+    return mInputThread ? mInputThread->getEventTime() : mRoot->getTimer()->getMicroseconds();
+}
+//---------------------------------------------------------------------------
 bool BaseApplication::keyPressed( const OIS::KeyEvent &arg )
 {
+    mKeysDown++;
     if (mTrayMgr->isDialogVisible()) return true;   // don't process any more keys if dialog is up
 
     if (arg.key == OIS::KC_F)   // toggle visibility of advanced frame stats
@@ -400,6 +562,8 @@ bool BaseApplication::keyPressed( const OIS::KeyEvent &arg )
 //---------------------------------------------------------------------------
 bool BaseApplication::keyReleased(const OIS::KeyEvent &arg)
 {
+    if (mKeysDown > 0)
+        mKeysDown--;
     mCameraMan->injectKeyUp(arg);
     return true;
 }
@@ -431,10 +595,18 @@ void BaseApplication::windowResized(Ogre::RenderWindow* rw)
     unsigned int width, height, depth;
     int left, top;
     rw->getMetrics(width, height, depth, left, top);
+    requestRedraw();
 
-    const OIS::MouseState &ms = mMouse->getMouseState();
-    ms.width = width;
-    ms.height = height;
+    if (mInputThread)
+    {
+        mInputThread->setWindowSize(width, height);
+    }
+    else
+    {
+        const OIS::MouseState &ms = mMouse->getMouseState();
+        ms.width = width;
+        ms.height = height;
+    }
 }
 //---------------------------------------------------------------------------
 // Unattach OIS before window shutdown (very important under Linux)
@@ -445,6 +617,9 @@ void BaseApplication::windowClosed(Ogre::RenderWindow* rw)
     {
         if(mInputManager)
         {
+            delete mInputThread;
+            mInputThread = 0;
+
             mInputManager->destroyInputObject(mMouse);
             mInputManager->destroyInputObject(mKeyboard);
 
@@ -26,6 +26,7 @@ http://www.ogre3d.org/wiki/
 #include <OgreSceneManager.h>
 #include <OgreRenderWindow.h>
 #include <OgreConfigFile.h>
+#include <OgreTimer.h>
 
 #if OGRE_PLATFORM == OGRE_PLATFORM_APPLE
 #  include <OIS/OISEvents.h>
@@ -45,6 +46,8 @@ http://www.ogre3d.org/wiki/
 #  include <SdkCameraMan.h>
 #endif
 
+#include "InputThread.h"
+
 #ifdef OGRE_STATIC_LIB
 #  define OGRE_STATIC_GL
 #  if OGRE_PLATFORM == OGRE_PLATFORM_WIN32
@@ -76,6 +79,9 @@ public:
 
     virtual void go(void);
 
+    // Load only what the game uses and never show the config dialog (call before go)
+    void setProductionProfile(bool production) { mProduction = production; }
+
 protected:
     virtual bool setup();
     virtual bool configure(void);
@@ -90,6 +96,21 @@ protected:
     virtual void loadResources(void);
     virtual bool frameRenderingQueued(const Ogre::FrameEvent& evt);
 
+    // Draws frames only while something changes, and at RENDER_IDLE_FRAME_RATE otherwise
+    void renderLoop(void);
+
+    // Does the picture change without input? While it does every frame is drawn
+    virtual bool isAnimating(void);
+
+    // Draws the next frame even if nothing moves
+    void requestRedraw(void) { mRedrawRequested = true; }
+
+    // Logs the time since the previous startup phase and since startup
+    void logStartupPhase(const Ogre::String& phase);
+
+    // Time (microseconds of the root timer) the input event being handled happened at
+    unsigned long getInputTime(void);
+
     virtual bool keyPressed(const OIS::KeyEvent &arg);
     virtual bool keyReleased(const OIS::KeyEvent &arg);
     virtual bool mouseMoved(const OIS::MouseEvent &arg);
@@ -122,10 +143,22 @@ protected:
     OIS::InputManager*          mInputManager;
     OIS::Mouse*                 mMouse;
     OIS::Keyboard*              mKeyboard;
+    InputThread*                mInputThread;   // Captures the devices between frames
 
     // Added for Mac compatibility
     Ogre::String                 m_ResourcePath;
 
+    // Startup profile
+    bool                        mProduction;
+    Ogre::Timer                 mStartupTimer;
+    unsigned long               mLastStartupPhase;
+    bool                        mFirstFrame;
+
+    // Render on demand
+    bool                        mRedrawRequested;
+    bool                        mIdleFrame;     // The time since the last frame was spent waiting
+    int                         mKeysDown;      // Keys held, the camera man moves while one is
+
 #ifdef OGRE_STATIC_LIB
     Ogre::StaticPluginLoader m_StaticPluginLoader;
 #endif
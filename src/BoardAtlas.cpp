@@ -0,0 +1,81 @@
+//============================================================================
+// Name        : BoardAtlas.cpp
+// Author      : Amrit Dhakal
+// Version     : 1.0
+// Copyright   : © Amrit Dhakal 2015. All right reserved. :D
+// Description : One texture and one material for every look of the board
+//============================================================================
+
+#include "BoardAtlas.h"
+#include "Constants.h"
+#include <iostream>
+#include <string.h>
+
+using namespace std;
+using namespace Ogre;
+
+//Images packed in the atlas, by tile (the white tile has none)
+static const char* TILE_IMAGES[BoardAtlas::NUM_TILES] = {"cell.png", "lighted.jpg", 0};
+
+//Tiles per row of the atlas
+static const int ATLAS_COLUMNS = 2;
+
+bool BoardAtlas::create(){
+	int atlasSize = BOARD_ATLAS_TILE_SIZE * ATLAS_COLUMNS;
+	uchar* pixels = OGRE_ALLOC_T(uchar, atlasSize * atlasSize * 4, MEMCATEGORY_GENERAL);
+	//Tiles without an image are white
+	memset(pixels, 0xFF, atlasSize * atlasSize * 4);
+	Image atlas;
+	atlas.loadDynamicImage(pixels, atlasSize, atlasSize, 1, PF_A8R8G8B8, true);
+
+	bool success = true;
+	for(int tile = 0; tile < NUM_TILES; tile++){
+		if(!TILE_IMAGES[tile]){
+			continue;
+		}
+		size_t left = (tile % ATLAS_COLUMNS) * BOARD_ATLAS_TILE_SIZE;
+		size_t top = (tile / ATLAS_COLUMNS) * BOARD_ATLAS_TILE_SIZE;
+		PixelBox destination = atlas.getPixelBox().getSubVolume(
+				Box(left, top, left + BOARD_ATLAS_TILE_SIZE, top + BOARD_ATLAS_TILE_SIZE));
+
+		try {
+			Image image;
+			image.load(TILE_IMAGES[tile], ResourceGroupManager::AUTODETECT_RESOURCE_GROUP_NAME);
+			image.resize(BOARD_ATLAS_TILE_SIZE, BOARD_ATLAS_TILE_SIZE);
+			PixelUtil::bulkPixelConversion(image.getPixelBox(), destination);
+		} catch(Ogre::Exception &e){
+			cerr << "File " << TILE_IMAGES[tile] << " could not be opened." << endl;
+			success = false;
+		}
+	}
+
+	//No mipmaps, the tiles would bleed into each other in the smaller levels
+	TextureManager::getSingleton().loadImage(BOARD_ATLAS_TEXTURE,
+			ResourceGroupManager::DEFAULT_RESOURCE_GROUP_NAME, atlas, TEX_TYPE_2D, 0);
+	return success;
+}
+
+void BoardAtlas::apply(Entity* entity, Tile tile){
+	Vector4 transform = getTransform(tile);
+	for(int i = 0; i < entity->getNumSubEntities(); i++){
+		SubEntity* sub = entity->getSubEntity(i);
+		if(sub->getMaterialName() != BOARD_MATERIAL){
+			sub->setMaterialName(BOARD_MATERIAL);
+		}
+		sub->setCustomParameter(BOARD_ATLAS_PARAMETER, transform);
+	}
+}
+
+Vector4 BoardAtlas::getTransform(Tile tile){
+	Real atlasSize = BOARD_ATLAS_TILE_SIZE * ATLAS_COLUMNS;
+	Real left = (tile % ATLAS_COLUMNS) * BOARD_ATLAS_TILE_SIZE;
+	Real top = (tile / ATLAS_COLUMNS) * BOARD_ATLAS_TILE_SIZE;
+	if(tile == WHITE){
+		//Every texture coordinate reads the middle of the tile
+		Real middle = BOARD_ATLAS_TILE_SIZE / 2;
+		return Vector4((left + middle) / atlasSize, (top + middle) / atlasSize, 0, 0);
+	}
+	//Half a texel is kept from each edge so the neighbouring tiles do not bleed in
+	return Vector4((left + 0.5) / atlasSize, (top + 0.5) / atlasSize,
+			(BOARD_ATLAS_TILE_SIZE - 1) / atlasSize, (BOARD_ATLAS_TILE_SIZE - 1) / atlasSize);
+}
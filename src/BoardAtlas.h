@@ -0,0 +1,62 @@
+//============================================================================
+// Name        : BoardAtlas.h
+// Author      : Amrit Dhakal
+// Version     : 1.0
+// Copyright   : © Amrit Dhakal 2015. All right reserved. :D
+// Description : One texture and one material for every look of the board
+//============================================================================
+
+#ifndef BOARDATLAS_H_
+#define BOARDATLAS_H_
+
+#include <Ogre.h>
+
+/**
+ * Class BoardAtlas packs the textures of the cells into one atlas, read by the single
+ * material Board/Atlas. Which tile an entity shows is a custom parameter of its
+ * sub entities, so lighting a cell or revealing a number never changes the material
+ * or the texture bound, and the board is drawn without state changes between cells.
+ *
+ * The atlas is a grid of 2x2 tiles, built when the scene is created from the images of
+ * the General resource group. The white tile is for the number meshes, which have no
+ * texture coordinates; the tile after it is left white. The atlas has no mipmaps: the
+ * smaller levels would blend the tiles together at their edges.
+ *
+ * The material is lit the way the fixed function passes it replaces were, by the
+ * ambient light and the diffuse colour of the first light, per vertex.
+ */
+class BoardAtlas {
+public:
+
+	/**
+	 * Tiles of the atlas, in the order they are packed
+	 */
+	enum Tile {
+		CELL,
+		LIGHTED,
+		WHITE,
+		NUM_TILES
+	};
+
+	/**
+	 * create: builds the atlas texture, must be called before any entity uses Board/Atlas
+	 * 		return: true if every image of the atlas was loaded
+	 */
+	static bool create();
+
+	/**
+	 * apply: makes the entity show a tile of the atlas, setting its material if needed
+	 * 		parameter:
+	 * 			entity: entity to change
+	 * 			tile: tile to show
+	 */
+	static void apply(Ogre::Entity* entity, Tile tile);
+
+	/**
+	 * getTransform: returns the offset (x, y) and scale (z, w) mapping the texture
+	 * coordinates of a mesh to the tile
+	 */
+	static Ogre::Vector4 getTransform(Tile tile);
+};
+
+#endif /* BOARDATLAS_H_ */
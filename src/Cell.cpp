@@ -9,6 +9,8 @@
 #include "BaseApplication.h"
 #include <iostream>
 #include "Constants.h"
+#include "Profiler.h"
+#include "BoardAtlas.h"
 
 #include <stdlib.h>
 
@@ -19,166 +21,122 @@ using namespace Ogre;
 const Ogre::uint32 Cell::INTERSECTABLE = 2;
 Cell::Cell(void)
 {
-	mSceneMgr = 0;
 	mEntity =  0;
 	mSceneNode = 0;
-	mPosition = 0;
 	mFlagNode = 0;
 	mNumberNode = 0;
 	mMineNode = 0;
 
 }
 
-Cell::~Cell(void){
-
-}
-
 void Cell::init(Ogre::SceneManager*  & sceneMgr){
-	mSceneMgr = sceneMgr;
-	mEntity =  mSceneMgr->createEntity("cube.mesh");
-	mSceneNode = mSceneMgr->getRootSceneNode()->createChildSceneNode();
+	mEntity =  sceneMgr->createEntity("cube.mesh");
+	mSceneNode = sceneMgr->getRootSceneNode()->createChildSceneNode();
 	mSceneNode->attachObject(mEntity);
-	mSceneNode->setPosition(mPosition);
-	mEntity->setMaterialName("Picture/Cell");
+	BoardAtlas::apply(mEntity, BoardAtlas::CELL);
 	mEntity->setQueryFlags(INTERSECTABLE);
-	mRevealed = false;
-	mIsReward = false;
-	mMinesAround = 0;
-	mIsFlagged = false;
-	mIsMine = false;
 }
 Vector3 Cell::getPosition(){
 	return mSceneNode->getPosition();
 }
 
+/**
+ * Destroys the node and the entities attached to it, which the scene manager would
+ * otherwise keep until it is destroyed itself
+ */
+static void destroyNode(SceneManager* sceneMgr, SceneNode* node){
+	while(node->numAttachedObjects() > 0){
+		MovableObject* object = node->detachObject((unsigned short)0);
+		sceneMgr->destroyMovableObject(object);
+	}
+	sceneMgr->destroySceneNode(node);
+}
+
 void Cell::removeFromScene(){
-	mSceneMgr->destroySceneNode(mSceneNode);
+	SceneManager* sceneMgr = mSceneNode->getCreator();
+	destroyNode(sceneMgr, mSceneNode);
 	if (mFlagNode) {
-		mSceneMgr->destroySceneNode(mFlagNode);
+		destroyNode(sceneMgr, mFlagNode);
 	}
 	if (mNumberNode) {
-		mSceneMgr->destroySceneNode(mNumberNode);
+		destroyNode(sceneMgr, mNumberNode);
 	}
 	if(mMineNode) {
-		mSceneMgr->destroySceneNode(mMineNode);
+		destroyNode(sceneMgr, mMineNode);
 	}
+	mSceneNode = 0;
+	mFlagNode = 0;
+	mNumberNode = 0;
+	mMineNode = 0;
+	mEntity = 0;
 }
 
-void Cell::flag(){
-	if(!mRevealed){
-		mIsFlagged = !mIsFlagged;
-		if(!mFlagNode){
-			Entity* flag = mSceneMgr->createEntity("Flag.mesh");
-			mFlagNode = mSceneMgr->getRootSceneNode()->createChildSceneNode();
-			mFlagNode->attachObject(flag);
+void Cell::showFlag(bool flagged){
+	if(!mFlagNode){
+		if(!flagged){
+			return;
+		}
+		SceneManager* sceneMgr = mSceneNode->getCreator();
+		Entity* flag = sceneMgr->createEntity("Flag.mesh");
+		mFlagNode = sceneMgr->getRootSceneNode()->createChildSceneNode();
+		mFlagNode->attachObject(flag);
 
-			double boxSize = flag->getBoundingBox().getSize().x * mFlagNode->getScale().x ;
+		double boxSize = flag->getBoundingBox().getSize().x * mFlagNode->getScale().x ;
 
-			double length = mEntity->getBoundingBox().getSize().z * mSceneNode->getScale().z;
+		double length = mEntity->getBoundingBox().getSize().z * mSceneNode->getScale().z;
 
-			double scaleAmt = (length/1.5)/boxSize;
+		double scaleAmt = (length/1.5)/boxSize;
 
-			mFlagNode->_setDerivedPosition(mSceneNode->_getDerivedPosition());
-			mFlagNode->scale(scaleAmt, scaleAmt, scaleAmt);
-			mFlagNode->translate(0,10,0);
-			mFlagNode->setVisible(false);
-		}
-		mFlagNode->flipVisibility();
+		mFlagNode->_setDerivedPosition(mSceneNode->_getDerivedPosition());
+		mFlagNode->scale(scaleAmt, scaleAmt, scaleAmt);
+		mFlagNode->translate(0,10,0);
 	}
+	mFlagNode->setVisible(flagged);
 }
 
 void Cell::light(bool isLighted){
-	if(isLighted){
-		mEntity->setMaterialName("Picture/Lighted");
-	}
-	else{
-		mEntity->setMaterialName("Picture/Cell");
-	}
-}
-
-int Cell::countFlagsAround(){
-	int count = 0;
-	for(int i = 0; i < mNeighbors.size(); i++){
-		if(mNeighbors[i]->isFlagged()){
-			count++;
-		}
-	}
-	return count;
+	BoardAtlas::apply(mEntity, isLighted ? BoardAtlas::LIGHTED : BoardAtlas::CELL);
 }
 
+void Cell::showRevealed(bool isMine, int minesAround){
+	PROFILE_SCOPE("Cell::showRevealed");
+	SceneManager* sceneMgr = mSceneNode->getCreator();
+	mSceneNode->setVisible(false);
+	if(isMine){
+		Ogre::Entity* revealEntity = sceneMgr->createEntity("Mine.mesh");
+		mMineNode = sceneMgr->getRootSceneNode()->createChildSceneNode();
+		mMineNode->attachObject(revealEntity);
 
+		double boxSize = revealEntity->getBoundingBox().getSize().z * mMineNode->getScale().z ;
 
-bool Cell::reveal(bool revealOnly, bool light){
-	if(!mIsFlagged){
-		if(!mRevealed){
-			mRevealed = true;
-			if(mIsMine){
-
-				mSceneNode->setVisible(false);
-				Ogre::Entity* revealEntity = mSceneMgr->createEntity("Mine.mesh");
-				mMineNode = mSceneMgr->getRootSceneNode()->createChildSceneNode();
-				mMineNode->attachObject(revealEntity);
-
-				double boxSize = revealEntity->getBoundingBox().getSize().z * mMineNode->getScale().z ;
+		double length = mEntity->getBoundingBox().getSize().z * mSceneNode->getScale().z;
 
-				double length = mEntity->getBoundingBox().getSize().z * mSceneNode->getScale().z;
+		double scaleAmt = (length)/boxSize;
 
-				double scaleAmt = (length)/boxSize;
-
-				mMineNode->_setDerivedPosition(mSceneNode->_getDerivedPosition());
-				mMineNode->scale(scaleAmt, scaleAmt, scaleAmt);
-				return false;
-			}
-			mSceneNode->setVisible(false);
-			if(mMinesAround != 0){
-				Ogre::Entity* revealEntity = mSceneMgr->createEntity(std::to_string(mMinesAround) + ".mesh");
-				mNumberNode = mSceneMgr->getRootSceneNode()->createChildSceneNode();
-				mNumberNode->attachObject(revealEntity);
-
-				double boxSize = revealEntity->getBoundingBox().getSize().z * mNumberNode->getScale().z ;
-
-				double length = mEntity->getBoundingBox().getSize().z * mSceneNode->getScale().z;
+		mMineNode->_setDerivedPosition(mSceneNode->_getDerivedPosition());
+		mMineNode->scale(scaleAmt, scaleAmt, scaleAmt);
+	}
+	else if(minesAround != 0){
+		//Names short enough for the string not to allocate
+		static const char* NUMBER_MESHES[] = {"0.mesh", "1.mesh", "2.mesh", "3.mesh", "4.mesh",
+				"5.mesh", "6.mesh", "7.mesh", "8.mesh"};
+		Ogre::Entity* revealEntity = sceneMgr->createEntity(NUMBER_MESHES[minesAround]);
+		BoardAtlas::apply(revealEntity, BoardAtlas::WHITE);
+		mNumberNode = sceneMgr->getRootSceneNode()->createChildSceneNode();
+		mNumberNode->attachObject(revealEntity);
 
-				double scaleAmt = (length/2)/boxSize;
+		double boxSize = revealEntity->getBoundingBox().getSize().z * mNumberNode->getScale().z ;
 
-				mNumberNode->_setDerivedPosition(mSceneNode->_getDerivedPosition());
-				mNumberNode->scale(scaleAmt, scaleAmt, scaleAmt);
-				mNumberNode->translate(-length/4, 0, length/4);
-				mNumberNode->pitch(Ogre::Degree(30));
-			}
-			if(mMinesAround == 0){
-				mSceneNode->showBoundingBox(true);
-				for(int i = 0; i < mNeighbors.size(); i++){
-					if(!mNeighbors[i]->reveal(true, false))
-						return false;
-				}
-			}
-			else {
-				return true;
-			}
+		double length = mEntity->getBoundingBox().getSize().z * mSceneNode->getScale().z;
 
-		}
-		else {
-
-			if(countFlagsAround() == mMinesAround && mMinesAround != 0 && !revealOnly){
-				for(int i = 0; i < mNeighbors.size(); i++){
-					if(!mNeighbors[i]->reveal(true, false))
-						return false;
-				}
-			}
-			else if(!revealOnly && light) {
-				for(int i = 0; i < mNeighbors.size(); i++){
-					if(!mNeighbors[i]->isFlagged())
-						mNeighbors[i]->light();
-				}
-			}
+		double scaleAmt = (length/2)/boxSize;
 
-		}
+		mNumberNode->_setDerivedPosition(mSceneNode->_getDerivedPosition());
+		mNumberNode->scale(scaleAmt, scaleAmt, scaleAmt);
+		mNumberNode->translate(-length/4, 0, length/4);
+		mNumberNode->pitch(Ogre::Degree(30));
+	}
+	else {
+		mSceneNode->showBoundingBox(true);
 	}
-
-	return true;
 }
-
-
-
-
@@ -8,15 +8,18 @@
 #define CELL_H_
 
 #include "BaseApplication.h"
-#include <vector>
 
+/**
+ * Class Cell holds the scene objects showing one cell of the board, nothing else: the
+ * state of the cell is its CellState in the game. The cells of a board are one array
+ * indexed by cell id (MineSweeper::mCells), so a Cell has no virtual functions and
+ * nothing to destroy but its scene objects (removeFromScene).
+ */
 class Cell{
 
 public:
 	Cell(void);
 
-	virtual ~Cell(void);
-
 	void init(Ogre::SceneManager*  & mSceneMgr);
 
 	/**
@@ -27,7 +30,7 @@ public:
 	Ogre::Vector3 getPosition(void);
 
 	/**
-	 * removeFromScene: remove the cell from the scene
+	 * removeFromScene: remove the cell from the scene, destroying its nodes and entities
 	 */
 	void removeFromScene();
 
@@ -36,7 +39,7 @@ public:
 	 *
 	 * return: the sceneNode associated with the cell
 	 */
-	Ogre::SceneNode* getSceneNode(void){
+	Ogre::SceneNode* getSceneNode(void) const {
 		return mSceneNode;
 	}
 
@@ -45,7 +48,7 @@ public:
 	 *
 	 * return: the entity associated with the cell
 	 */
-	Ogre::Entity* getEntity(){
+	Ogre::Entity* getEntity() const {
 		return mEntity;
 	}
 
@@ -66,64 +69,40 @@ public:
 	 * 		pos: the new position of the scene node
 	 */
 	void setPosition(Ogre::Vector3 pos){
-		mPosition = pos;
 		mSceneNode->setPosition(pos);
 	}
 
-	void setReward(){
-		mIsReward = true;
-	}
-	void setMinesAround(int mines){
-		mMinesAround = mines;
-	}
-
-	void setMine(){
-		mIsMine = true;
-	}
-
-	bool isReward(){
-		return mIsReward;
-	}
-	bool isMine(){
-		return mIsMine;
-	}
-	bool isRevelead(){
-		return mRevealed;
-	}
-	bool isFlagged(){
-		return mIsFlagged;
-	}
-	void flag();
-
-	int getNumMinesAround(){
-		return mMinesAround;
-	}
-	int countFlagsAround();
-
-	void setNeighbors(std::vector<Cell*> n){
-		mNeighbors = n;
-
-	}
-
-	Ogre::SceneNode* getNumberNode(){
+	Ogre::SceneNode* getNumberNode() const {
 		return mNumberNode;
 	}
 
-	Ogre::SceneNode* getMineNode(){
+	Ogre::SceneNode* getMineNode() const {
 		return mMineNode;
 	}
 
-	Ogre::SceneNode* getFlagNode(){
+	Ogre::SceneNode* getFlagNode() const {
 		return mFlagNode;
 	}
 
-	int getMinesAround(){
-		return mMinesAround;
-	}
-
+	/**
+	 * light: shows the cell highlighted, or back to normal
+	 */
 	void light(bool isLighted = true);
 
-	bool reveal(bool revealOnly = false, bool light = true);
+	/**
+	 * showFlag: shows or hides the flag on the cell
+	 */
+	void showFlag(bool flagged);
+
+	/**
+	 * showRevealed: replaces the cell with what it was hiding, the mine or the
+	 * number of mines around it (nothing if there are none)
+	 *
+	 * Parameter:
+	 * 		isMine: true if the cell is a mine
+	 * 		minesAround: number of mines around the cell
+	 */
+	void showRevealed(bool isMine, int minesAround);
 
 	static const Ogre::uint32 INTERSECTABLE;
 
@@ -140,27 +119,9 @@ protected:
 	Ogre::SceneNode* mNumberNode;
 
 	/**
-	 * Scenemanager managing the scene
-	 */
-	Ogre::SceneManager* mSceneMgr;
-
-	/**
-	 * SceneNode assocaited with the cell
+	 * SceneNode assocaited with the cell, its creator is the scene manager managing the scene
 	 */
 	Ogre::SceneNode* mSceneNode;
-
-	/**
-	 * current Position of the cell in the scene.
-	 */
-	Ogre::Vector3 mPosition;
-
-	bool mIsMine;
-	bool mRevealed = false;
-	bool mIsReward = false;
-	int mMinesAround;
-	bool mIsFlagged;
-	std::vector<Cell*> mNeighbors;
-
 };
 
 
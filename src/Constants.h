@@ -7,8 +7,7 @@
 #ifndef CONSTANTS_H_
 #define CONSTANTS_H_
 
-//Game Constants
-const int MAX_LEVEL = 10;
+#include "GameConstants.h"
 
 //SceneQueries
 const Ogre::uint32 REMOVEABLE = 4;
@@ -17,15 +16,15 @@ const Ogre::uint32 REMOVEABLE = 4;
 const int BOARD_WIDTH = 500;
 const int BOARD_HEIGHT = BOARD_WIDTH;
 
-//Level Information
-
-const int LEVEL_DIM[] = {0,10,10,12,12,14,14,16,16,20,20};
-const int NUM_MINES[] = {0,15,20,21,26,30,35,39,46,80,100};
-const int MAX_BONUS_TIME[] = {0,20,30,50,80,120,150,190,210,270,360};
-const int POINTS_PER_REVEAL[] = {0,1,2,3,4,5,7,9,12,18,30};
-
 //HighScore
 const std::string HIGHSCORE_FILE = ".highScores";
+const int NUM_HIGH_SCORES = 20;
+
+//Score distribution of every game played, per level
+const std::string SCORE_SKETCH_FILE = ".scoreSketches";
+
+//Columnar log of every finished game
+const std::string GAME_HISTORY_DIR = ".gameHistory";
 
 // Mines Around Number Mesh
 //const Ogre::String MINES_AROUND_MESH[] = {"","Mesh.mesh","", "Text.006_Text.011.mesh","Text.mesh","Text.003_Text.008.mesh","Text.004_Text.009.mesh", "Text.007_Text.012.mesh", "Mesh.007.mesh"};
@@ -41,7 +40,83 @@ const Ogre::Vector3 DETECTOR_HEAD_POSITION = Ogre::Vector3(-7, -1, 1);
 
 const Ogre::Vector3 GRAVITY = Ogre::Vector3(0, -9.81, 0);
 
+//Number of cells turned into rigid bodies per frame when the game over explosion starts
+const int PHYSICS_CELLS_PER_FRAME = 40;
+
+//Fixed physics step (seconds) and the most steps simulated in one frame
+const Ogre::Real PHYSICS_TIMESTEP = 1.0 / 60.0;
+const int PHYSICS_MAX_SUBSTEPS = 4;
+
+//Step the game over explosion on a worker thread while the frame is drawn
+const bool PHYSICS_ON_WORKER_THREAD = true;
+
+//Threads solving the islands of a physics step, 0 for one per core
+const int PHYSICS_SOLVER_THREADS = 0;
+
+//Explode the board into particles instead of rigid bodies at game over (toggled with E)
+const bool EXPLOSION_PARTICLES_DEFAULT = false;
+
+//Most debris particles alive at once, whatever the size of the board
+const int DEBRIS_MAX_PARTICLES = 2000;
+
+//Seconds a debris particle lives
+const Ogre::Real DEBRIS_LIFETIME = 4;
+
+//Bodies are removed once they leave this box around the board
+const Ogre::AxisAlignedBox PHYSICS_WORLD_BOUNDS = Ogre::AxisAlignedBox(-2000, -1000, -2000, 2000, 3000, 2000);
+
+//Bodies slower than these velocities are put to sleep
+const Ogre::Real PHYSICS_SLEEP_LINEAR_VELOCITY = 5;
+const Ogre::Real PHYSICS_SLEEP_ANGULAR_VELOCITY = 1;
+
+//Seconds after which the explosion stops drawing every frame, even if bodies still move
+const Ogre::Real PHYSICS_EXPLOSION_TIMEOUT = 15;
+
 const int CAMERA_SPEED = 200;
 
+//Times a second the keyboard and mouse are captured by the input thread
+const int INPUT_POLL_RATE = 1000;
+
+//Only draw frames while the picture changes: otherwise it is redrawn this many times a
+//second, and after a change every frame is drawn for this long (seconds)
+const bool RENDER_ON_DEMAND = true;
+const int RENDER_IDLE_FRAME_RATE = 4;
+const Ogre::Real RENDER_ACTIVE_LINGER = 0.5;
+
+//Material and texture of the board atlas, the custom parameter holding the tile of an
+//entity, and the size (pixels) every image is scaled to in the atlas
+const std::string BOARD_MATERIAL = "Board/Atlas";
+const std::string BOARD_ATLAS_TEXTURE = "BoardAtlas";
+const size_t BOARD_ATLAS_PARAMETER = 0;
+const int BOARD_ATLAS_TILE_SIZE = 256;
+
+//Resource group loaded in the background after the first frame (detector, mine and flag)
+const std::string DEFERRED_RESOURCE_GROUP = "Deferred";
+
+//Arena scenes are read in chunks of this many bytes, at most this many parsed commands
+//wait for the main thread, which applies at most this many a frame
+const size_t DOTSCENE_READ_SIZE = 64 * 1024;
+const size_t DOTSCENE_QUEUE_LIMIT = 4096;
+const int DOTSCENE_COMMANDS_PER_FRAME = 200;
+
+//Metrics are written to this file in the Prometheus text format every interval (seconds)
+const std::string METRICS_FILE = ".metrics.prom";
+const Ogre::Real METRICS_DUMP_INTERVAL = 5;
+
+//Directory and resource group the prebaked GUI fonts are kept in, the width (pixels) of
+//their glyph atlases and the codepoints baked
+const std::string GUI_CACHE_DIR = ".guicache";
+const std::string GUI_CACHE_GROUP = "GuiCache";
+const int GUI_CACHE_ATLAS_WIDTH = 512;
+const unsigned int GUI_CACHE_FIRST_CODEPOINT = 32;
+const unsigned int GUI_CACHE_LAST_CODEPOINT = 255;
+
+//With MINESWEEPER_PROFILING, a trace is written for frames slower than this (seconds)
+const double PROFILER_FRAME_BUDGET = 1.0 / 30.0;
+const std::string PROFILER_TRACE_PREFIX = "profile";
+
+//Memory reserved for the game state of a level (bytes), the cells of the largest board fit
+const size_t LEVEL_ARENA_SIZE = 64 * 1024;
+
 
 #endif /* CONSTANTS_H_ */
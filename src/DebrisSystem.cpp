@@ -0,0 +1,148 @@
+//============================================================================
+// Name        : DebrisSystem.cpp
+// Author      : Amrit Dhakal
+// Version     : 1.0
+// Copyright   : © Amrit Dhakal 2015. All right reserved. :D
+// Description : Particle debris for the game over explosion
+//============================================================================
+
+#include "DebrisSystem.h"
+#include "Constants.h"
+#include <algorithm>
+
+using namespace Ogre;
+
+//Colour of the debris of a cell and of a mine
+static const ColourValue CELL_DEBRIS_COLOUR = ColourValue(1, 1, 1);
+static const ColourValue MINE_DEBRIS_COLOUR = ColourValue(0.35, 0.1, 0.1);
+
+DebrisSystem::DebrisSystem(SceneManager* sceneMgr, int maxParticles):
+					mMaxParticles(maxParticles),
+					mCount(0),
+					mPosX(maxParticles), mPosY(maxParticles), mPosZ(maxParticles),
+					mVelX(maxParticles), mVelY(maxParticles), mVelZ(maxParticles),
+					mLife(maxParticles),
+					mColour(maxParticles),
+					mSceneMgr(sceneMgr)
+{
+	mBillboards = mSceneMgr->createBillboardSet(maxParticles);
+	mBillboards->setAutoextend(false);
+	mBillboards->setMaterialName("Debris/Chunk");
+	//Particles are culled at the world bounds, so the bounds never need to be recomputed
+	mBillboards->setBounds(PHYSICS_WORLD_BOUNDS, PHYSICS_WORLD_BOUNDS.getSize().length() / 2);
+	mNode = mSceneMgr->getRootSceneNode()->createChildSceneNode();
+	mNode->attachObject(mBillboards);
+}
+
+DebrisSystem::~DebrisSystem(){
+	mSceneMgr->destroySceneNode(mNode);
+	mSceneMgr->destroyBillboardSet(mBillboards);
+}
+
+bool DebrisSystem::spawn(const Vector3 &position, Real speed, const ColourValue &colour){
+	if(mCount == mMaxParticles){
+		return false;
+	}
+	mPosX[mCount] = position.x;
+	mPosY[mCount] = position.y;
+	mPosZ[mCount] = position.z;
+	mVelX[mCount] = Math::RangeRandom(-speed, speed);
+	mVelY[mCount] = Math::RangeRandom(0, 2 * speed);
+	mVelZ[mCount] = Math::RangeRandom(-speed, speed);
+	mLife[mCount] = DEBRIS_LIFETIME * Math::RangeRandom(0.5, 1);
+	mColour[mCount] = colour;
+	mCount++;
+	return true;
+}
+
+void DebrisSystem::remove(int i){
+	mCount--;
+	mPosX[i] = mPosX[mCount];
+	mPosY[i] = mPosY[mCount];
+	mPosZ[i] = mPosZ[mCount];
+	mVelX[i] = mVelX[mCount];
+	mVelY[i] = mVelY[mCount];
+	mVelZ[i] = mVelZ[mCount];
+	mLife[i] = mLife[mCount];
+	mColour[i] = mColour[mCount];
+}
+
+void DebrisSystem::explode(const Cell* cells, int numCells, Real cellSize){
+	clear();
+	if(numCells == 0){
+		return;
+	}
+	mBillboards->setDefaultDimensions(cellSize / 3, cellSize / 3);
+
+	//Mines get twice the share of a cell
+	int shares = numCells;
+	for(int i = 0; i < numCells; i++){
+		if(cells[i].getMineNode() != 0){
+			shares += 2;
+		}
+	}
+	int perShare = std::max(1, mMaxParticles / shares);
+	Real speed = cellSize * 8;
+
+	for(int i = 0; i < numCells; i++){
+		const Cell* cell = &cells[i];
+		Vector3 position = cell->getSceneNode()->_getDerivedPosition();
+		for(int p = 0; p < perShare; p++){
+			spawn(position, speed, CELL_DEBRIS_COLOUR);
+		}
+		if(cell->getMineNode() != 0){
+			for(int p = 0; p < 2 * perShare; p++){
+				spawn(position, 2 * speed, MINE_DEBRIS_COLOUR);
+			}
+			cell->getMineNode()->setVisible(false);
+		}
+		if(cell->getFlagNode() != 0){
+			cell->getFlagNode()->setVisible(false);
+		}
+		if(cell->getNumberNode() != 0){
+			cell->getNumberNode()->setVisible(false);
+		}
+		cell->getSceneNode()->setVisible(false);
+	}
+}
+
+void DebrisSystem::update(Real timeSinceLastFrame){
+	Real dt = timeSinceLastFrame;
+	//Debris falls faster than the rigid bodies so it leaves the screen within its life
+	Real gravity = GRAVITY.y * 50 * dt;
+	Vector3 min = PHYSICS_WORLD_BOUNDS.getMinimum();
+	Vector3 max = PHYSICS_WORLD_BOUNDS.getMaximum();
+
+	for(int i = 0; i < mCount; i++){
+		mVelY[i] += gravity;
+	}
+	for(int i = 0; i < mCount; i++){
+		mPosX[i] += mVelX[i] * dt;
+		mPosY[i] += mVelY[i] * dt;
+		mPosZ[i] += mVelZ[i] * dt;
+		mLife[i] -= dt;
+	}
+	for(int i = 0; i < mCount; ){
+		if(mLife[i] > 0 && mPosY[i] > min.y && mPosY[i] < max.y
+				&& mPosX[i] > min.x && mPosX[i] < max.x
+				&& mPosZ[i] > min.z && mPosZ[i] < max.z){
+			i++;
+		}
+		else {
+			remove(i);
+		}
+	}
+
+	//The billboard pool is refilled from the arrays; clear() hands every billboard back to it
+	mBillboards->clear();
+	for(int i = 0; i < mCount; i++){
+		ColourValue colour = mColour[i];
+		colour.a = std::min<Real>(1, mLife[i]);
+		mBillboards->createBillboard(mPosX[i], mPosY[i], mPosZ[i], colour);
+	}
+}
+
+void DebrisSystem::clear(){
+	mCount = 0;
+	mBillboards->clear();
+}
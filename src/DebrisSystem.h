@@ -0,0 +1,99 @@
+//============================================================================
+// Name        : DebrisSystem.h
+// Author      : Amrit Dhakal
+// Version     : 1.0
+// Copyright   : © Amrit Dhakal 2015. All right reserved. :D
+// Description : Particle debris for the game over explosion
+//============================================================================
+
+#ifndef DEBRISSYSTEM_H_
+#define DEBRISSYSTEM_H_
+
+#include <Ogre.h>
+#include <vector>
+#include "Cell.h"
+
+/**
+ * Class DebrisSystem is the cheap alternative to the rigid body explosion: the cells
+ * are hidden and replaced by a fixed budget of particles, drawn by a single billboard set.
+ * The particles are kept in one array per component and are not collided with each other,
+ * so a frame costs the same on every board size.
+ */
+class DebrisSystem {
+public:
+
+	/**
+	 * Constructor:
+	 * 		parameter:
+	 * 			sceneMgr: scene manager the billboard set is created in
+	 * 			maxParticles: most particles alive at once
+	 */
+	DebrisSystem(Ogre::SceneManager* sceneMgr, int maxParticles);
+
+	/**
+	 * Destructor
+	 */
+	~DebrisSystem();
+
+	/**
+	 * explode: hides the cells and everything on them and spreads the particle
+	 * budget over them, mines getting a darker and faster share
+	 * 		parameter:
+	 * 			cells: cells of the board
+	 * 			numCells: number of cells
+	 * 			cellSize: edge of a cell, the particles are a fraction of it
+	 */
+	void explode(const Cell* cells, int numCells, Ogre::Real cellSize);
+
+	/**
+	 * update: moves the particles by the frame time and removes the dead ones
+	 */
+	void update(Ogre::Real timeSinceLastFrame);
+
+	/**
+	 * clear: removes every particle
+	 */
+	void clear();
+
+	/**
+	 * getNumParticles: returns the number of particles alive
+	 */
+	int getNumParticles(){
+		return mCount;
+	}
+
+protected:
+
+	/**
+	 * Adds a particle at the position, returns false when the budget is used up
+	 */
+	bool spawn(const Ogre::Vector3 &position, Ogre::Real speed, const Ogre::ColourValue &colour);
+
+	/**
+	 * Moves the last particle into slot i
+	 */
+	void remove(int i);
+
+	//Most particles alive at once
+	int mMaxParticles;
+
+	//Number of particles alive, the first mCount entries of every array
+	int mCount;
+
+	//Positions, velocities and remaining life of the particles
+	std::vector<float> mPosX, mPosY, mPosZ;
+	std::vector<float> mVelX, mVelY, mVelZ;
+	std::vector<float> mLife;
+
+	//Colour of each particle, its alpha fades with its life
+	std::vector<Ogre::ColourValue> mColour;
+
+	Ogre::SceneManager* mSceneMgr;
+
+	//Draws every particle in one batch
+	Ogre::BillboardSet* mBillboards;
+
+	Ogre::SceneNode* mNode;
+};
+
+#endif /* DEBRISSYSTEM_H_ */
@@ -0,0 +1,482 @@
+//============================================================================
+// Name        : DotSceneLoader.cpp
+// Author      : Amrit Dhakal
+// Version     : 1.0
+// Copyright   : © Amrit Dhakal 2015. All right reserved. :D
+// Description : Streams DotScene files into the scene a batch per frame
+//============================================================================
+
+#include "DotSceneLoader.h"
+#include "Constants.h"
+
+#include <ctype.h>
+#include <stdlib.h>
+#include <string.h>
+#include <iostream>
+
+using namespace std;
+using namespace Ogre;
+
+DotSceneLoader::Command::Command(CommandType type, int node):
+					type(type),
+					node(node),
+					parent(-1),
+					vector(Vector3::ZERO),
+					orientation(Quaternion::IDENTITY),
+					lightType(Light::LT_POINT),
+					diffuse(ColourValue::White),
+					specular(ColourValue::Black),
+					attenuation(100000, 1, 0, 0),
+					billboardType(BBT_POINT),
+					billboardOrigin(BBO_CENTER),
+					castShadows(true),
+					visible(true)
+{
+}
+
+DotSceneLoader::DotSceneLoader(SceneManager* sceneMgr):
+					mSceneMgr(sceneMgr),
+					mRoot(0),
+					mFinished(false),
+					mNumNodes(0),
+					mNumLights(0),
+					mParsed(false),
+					mStop(false)
+{
+}
+
+DotSceneLoader::~DotSceneLoader(){
+	{
+		//Under the lock, or the parser could miss the notification between testing
+		//the predicate and going to sleep
+		lock_guard<mutex> lock(mMutex);
+		mStop = true;
+		mSpace.notify_all();
+	}
+	if(mThread.joinable()){
+		mThread.join();
+	}
+}
+
+bool DotSceneLoader::load(const String &sceneName, const String &groupName, SceneNode* root){
+	if(mThread.joinable()){
+		return false;
+	}
+	try {
+		mStream = ResourceGroupManager::getSingleton().openResource(sceneName, groupName);
+	} catch(Ogre::Exception &e){
+		cerr << "File " << sceneName << " could not be opened." << endl;
+		return false;
+	}
+	mRoot = root ? root : mSceneMgr->getRootSceneNode();
+	mThread = std::thread(&DotSceneLoader::parse, this);
+	return true;
+}
+
+bool DotSceneLoader::update(int maxCommands){
+	if(mFinished){
+		return true;
+	}
+
+	std::vector<String> prefetch;
+	bool parsed, queueEmpty;
+	{
+		lock_guard<mutex> lock(mMutex);
+		prefetch.swap(mPrefetch);
+		if(mPending.empty()){
+			mPending.swap(mQueue);
+			mSpace.notify_one();
+		}
+		parsed = mParsed;
+		queueEmpty = mQueue.empty();
+	}
+
+	//Meshes are read from disk while the commands before them are applied
+	ResourceBackgroundQueue &queue = ResourceBackgroundQueue::getSingleton();
+	for(int i = 0; i < prefetch.size(); i++){
+		mMeshTickets[prefetch[i]] = queue.prepare(MeshManager::getSingleton().getResourceType(), prefetch[i],
+				ResourceGroupManager::AUTODETECT_RESOURCE_GROUP_NAME);
+	}
+
+	for(int applied = 0; applied < maxCommands && !mPending.empty(); applied++){
+		if(!apply(mPending.front())){
+			break;
+		}
+		mPending.pop_front();
+	}
+
+	mFinished = parsed && queueEmpty && mPending.empty();
+	if(mFinished){
+		mMeshTickets.clear();
+	}
+	return mFinished;
+}
+
+String DotSceneLoader::getProperty(const String &nodeName, const String &property) const {
+	map<pair<String, String>, String>::const_iterator it = mProperties.find(make_pair(nodeName, property));
+	return it == mProperties.end() ? " " : it->second;
+}
+
+void DotSceneLoader::parse(){
+	std::string buffer;
+	std::vector<char> chunk(DOTSCENE_READ_SIZE);
+	while(!mStop && !mStream->eof()){
+		size_t read = mStream->read(&chunk[0], chunk.size());
+		if(read == 0){
+			break;
+		}
+		buffer.append(&chunk[0], read);
+		buffer.erase(0, tokenize(buffer));
+	}
+	mStream->close();
+
+	lock_guard<mutex> lock(mMutex);
+	mParsed = true;
+}
+
+size_t DotSceneLoader::tokenize(const std::string &buffer){
+	size_t position = 0;
+	while(!mStop){
+		//Text between the tags is not used by DotScene
+		size_t start = buffer.find('<', position);
+		if(start == std::string::npos){
+			return buffer.size();
+		}
+
+		size_t end;
+		if(buffer.compare(start, 4, "<!--") == 0){
+			end = buffer.find("-->", start);
+			if(end == std::string::npos){
+				return start;
+			}
+			position = end + 3;
+			continue;
+		}
+		if(buffer.compare(start, 9, "<![CDATA[") == 0){
+			end = buffer.find("]]>", start);
+			if(end == std::string::npos){
+				return start;
+			}
+			position = end + 3;
+			continue;
+		}
+
+		//The tag ends at the first > outside of quotes
+		char quote = 0;
+		for(end = start + 1; end < buffer.size(); end++){
+			if(quote){
+				quote = buffer[end] == quote ? 0 : quote;
+			}
+			else if(buffer[end] == '"' || buffer[end] == '\''){
+				quote = buffer[end];
+			}
+			else if(buffer[end] == '>'){
+				break;
+			}
+		}
+		if(end >= buffer.size()){
+			return start;
+		}
+		position = end + 1;
+
+		size_t i = start + 1;
+		if(buffer[i] == '?' || buffer[i] == '!'){
+			continue;
+		}
+		if(buffer[i] == '/'){
+			size_t nameEnd = i + 1;
+			while(nameEnd < end && !isspace(buffer[nameEnd])){
+				nameEnd++;
+			}
+			endElement(buffer.substr(i + 1, nameEnd - i - 1));
+			continue;
+		}
+
+		size_t tagEnd = end;
+		bool empty = buffer[end - 1] == '/';
+		if(empty){
+			tagEnd--;
+		}
+		size_t nameStart = i;
+		while(i < tagEnd && !isspace(buffer[i])){
+			i++;
+		}
+		String name = buffer.substr(nameStart, i - nameStart);
+
+		NameValuePairList attributes;
+		while(i < tagEnd){
+			while(i < tagEnd && isspace(buffer[i])){
+				i++;
+			}
+			size_t keyStart = i;
+			while(i < tagEnd && buffer[i] != '=' && !isspace(buffer[i])){
+				i++;
+			}
+			String key = buffer.substr(keyStart, i - keyStart);
+			while(i < tagEnd && (isspace(buffer[i]) || buffer[i] == '=')){
+				i++;
+			}
+			if(i >= tagEnd || (buffer[i] != '"' && buffer[i] != '\'')){
+				break;
+			}
+			size_t valueEnd = buffer.find(buffer[i], i + 1);
+			attributes[key] = decode(buffer.substr(i + 1, valueEnd - i - 1));
+			i = valueEnd + 1;
+		}
+
+		startElement(name, attributes);
+		if(empty){
+			endElement(name);
+		}
+	}
+	return position;
+}
+
+void DotSceneLoader::startElement(const String &name, const NameValuePairList &attributes){
+	String parent = mElements.empty() ? "" : mElements.back();
+	mElements.push_back(name);
+	int node = mOpenNodes.empty() ? -1 : mOpenNodes.back();
+
+	if(name == "node"){
+		Command command(CREATE_NODE, mNumNodes);
+		command.parent = node;
+		command.name = attribute(attributes, "name");
+		mOpenNodes.push_back(mNumNodes++);
+		push(command);
+	}
+	else if(parent == "node" && (name == "position" || name == "scale")){
+		Real fallback = name == "scale" ? 1 : 0;
+		Command command(name == "scale" ? SET_SCALE : SET_POSITION, node);
+		command.vector = Vector3(real(attributes, "x", fallback), real(attributes, "y", fallback),
+				real(attributes, "z", fallback));
+		push(command);
+	}
+	else if(parent == "node" && (name == "rotation" || name == "quaternion")){
+		Command command(SET_ORIENTATION, node);
+		command.orientation = Quaternion(real(attributes, "qw", real(attributes, "w", 1)),
+				real(attributes, "qx", real(attributes, "x")), real(attributes, "qy", real(attributes, "y")),
+				real(attributes, "qz", real(attributes, "z")));
+		push(command);
+	}
+	else if(parent == "node" && name == "entity"){
+		Command command(CREATE_ENTITY, node);
+		command.name = attribute(attributes, "name");
+		command.resource = attribute(attributes, "meshFile");
+		command.castShadows = attribute(attributes, "castShadows") != "false";
+		if(!mMeshesSeen[command.resource]){
+			mMeshesSeen[command.resource] = true;
+			lock_guard<mutex> lock(mMutex);
+			mPrefetch.push_back(command.resource);
+		}
+		push(command);
+	}
+	else if(name == "light"){
+		Command command(CREATE_LIGHT, node);
+		command.name = attribute(attributes, "name", "DotSceneLight" + StringConverter::toString(mNumLights++));
+		String type = attribute(attributes, "type");
+		if(type == "directional"){
+			command.lightType = Light::LT_DIRECTIONAL;
+		}
+		else if(type == "spot"){
+			command.lightType = Light::LT_SPOTLIGHT;
+		}
+		command.castShadows = attribute(attributes, "castShadows") != "false";
+		command.visible = attribute(attributes, "visible") != "false";
+		mOpenCommands.push_back(command);
+	}
+	else if(parent == "light" && !mOpenCommands.empty()){
+		Command &light = mOpenCommands.back();
+		if(name == "colourDiffuse" || name == "colourSpecular"){
+			ColourValue colour(real(attributes, "r"), real(attributes, "g"), real(attributes, "b"), 1);
+			(name == "colourDiffuse" ? light.diffuse : light.specular) = colour;
+		}
+		else if(name == "lightAttenuation"){
+			light.attenuation = Vector4(real(attributes, "range", light.attenuation.x),
+					real(attributes, "constant", light.attenuation.y), real(attributes, "linear", light.attenuation.z),
+					real(attributes, "quadratic", light.attenuation.w));
+		}
+		else if(name == "position"){
+			light.vector = Vector3(real(attributes, "x"), real(attributes, "y"), real(attributes, "z"));
+		}
+	}
+	else if(name == "billboardSet"){
+		Command command(CREATE_BILLBOARD_SET, node);
+		command.name = attribute(attributes, "name");
+		command.resource = attribute(attributes, "material", command.name);
+		String type = attribute(attributes, "type");
+		if(type == "orientedCommon"){
+			command.billboardType = BBT_ORIENTED_COMMON;
+		}
+		else if(type == "orientedSelf"){
+			command.billboardType = BBT_ORIENTED_SELF;
+		}
+		static const struct {
+			const char* name;
+			BillboardOrigin origin;
+		} ORIGINS[] = {
+			{"bottomLeft", BBO_BOTTOM_LEFT}, {"bottomCenter", BBO_BOTTOM_CENTER}, {"bottomRight", BBO_BOTTOM_RIGHT},
+			{"left", BBO_CENTER_LEFT}, {"right", BBO_CENTER_RIGHT},
+			{"topLeft", BBO_TOP_LEFT}, {"topCenter", BBO_TOP_CENTER}, {"topRight", BBO_TOP_RIGHT}
+		};
+		String origin = attribute(attributes, "origin");
+		for(int i = 0; i < sizeof(ORIGINS) / sizeof(ORIGINS[0]); i++){
+			if(origin == ORIGINS[i].name){
+				command.billboardOrigin = ORIGINS[i].origin;
+			}
+		}
+		command.vector = Vector3(real(attributes, "width", 100), real(attributes, "height", 100), 0);
+		mOpenCommands.push_back(command);
+	}
+	else if(parent == "billboardSet" && name == "billboard" && !mOpenCommands.empty()){
+		mOpenCommands.back().billboards.push_back(make_pair(Vector3::ZERO, ColourValue::White));
+	}
+	else if(parent == "billboard" && !mOpenCommands.empty() && !mOpenCommands.back().billboards.empty()){
+		pair<Vector3, ColourValue> &billboard = mOpenCommands.back().billboards.back();
+		if(name == "position"){
+			billboard.first = Vector3(real(attributes, "x"), real(attributes, "y"), real(attributes, "z"));
+		}
+		else if(name == "colourDiffuse"){
+			billboard.second = ColourValue(real(attributes, "r", 1), real(attributes, "g", 1), real(attributes, "b", 1), 1);
+		}
+	}
+	else if(parent == "userData" && name == "property" && node >= 0){
+		Command command(SET_PROPERTY, node);
+		command.name = attribute(attributes, "name");
+		command.resource = attribute(attributes, "data");
+		push(command);
+	}
+}
+
+void DotSceneLoader::endElement(const String &name){
+	if(!mElements.empty()){
+		mElements.pop_back();
+	}
+	if(name == "node" && !mOpenNodes.empty()){
+		mOpenNodes.pop_back();
+	}
+	else if((name == "light" || name == "billboardSet") && !mOpenCommands.empty()){
+		push(mOpenCommands.back());
+		mOpenCommands.pop_back();
+	}
+}
+
+void DotSceneLoader::push(const Command &command){
+	unique_lock<mutex> lock(mMutex);
+	mSpace.wait(lock, [this]{ return mQueue.size() < DOTSCENE_QUEUE_LIMIT || mStop; });
+	mQueue.push_back(command);
+}
+
+bool DotSceneLoader::apply(const Command &command){
+	SceneNode* node = command.node >= 0 && command.node < mNodes.size() ? mNodes[command.node] : mRoot;
+	try {
+		switch(command.type){
+		case CREATE_NODE: {
+			SceneNode* parent = command.parent >= 0 && command.parent < mNodes.size() ? mNodes[command.parent] : mRoot;
+			//A node that cannot be created leaves its contents to its parent
+			mNodes.push_back(parent);
+			mNodes.back() = command.name.empty() ? parent->createChildSceneNode()
+					: parent->createChildSceneNode(command.name);
+			break;
+		}
+		case SET_POSITION:
+			node->setPosition(command.vector);
+			break;
+		case SET_ORIENTATION:
+			node->setOrientation(command.orientation);
+			break;
+		case SET_SCALE:
+			node->setScale(command.vector);
+			break;
+		case CREATE_ENTITY: {
+			map<String, BackgroundProcessTicket>::iterator ticket = mMeshTickets.find(command.resource);
+			if(ticket != mMeshTickets.end() && !ResourceBackgroundQueue::getSingleton().isProcessComplete(ticket->second)){
+				return false;
+			}
+			Entity* entity = command.name.empty() ? mSceneMgr->createEntity(command.resource)
+					: mSceneMgr->createEntity(command.name, command.resource);
+			entity->setCastShadows(command.castShadows);
+			node->attachObject(entity);
+			break;
+		}
+		case CREATE_LIGHT: {
+			Light* light = mSceneMgr->createLight(command.name);
+			light->setType(command.lightType);
+			light->setDiffuseColour(command.diffuse);
+			light->setSpecularColour(command.specular);
+			light->setAttenuation(command.attenuation.x, command.attenuation.y, command.attenuation.z,
+					command.attenuation.w);
+			light->setPosition(command.vector);
+			light->setCastShadows(command.castShadows);
+			light->setVisible(command.visible);
+			node->attachObject(light);
+			break;
+		}
+		case CREATE_BILLBOARD_SET: {
+			unsigned int poolSize = max<size_t>(command.billboards.size(), 1);
+			BillboardSet* billboards = command.name.empty() ? mSceneMgr->createBillboardSet(poolSize)
+					: mSceneMgr->createBillboardSet(command.name, poolSize);
+			billboards->setBillboardType(command.billboardType);
+			billboards->setBillboardOrigin(command.billboardOrigin);
+			billboards->setMaterialName(command.resource);
+			billboards->setDefaultDimensions(command.vector.x, command.vector.y);
+			for(int i = 0; i < command.billboards.size(); i++){
+				billboards->createBillboard(command.billboards[i].first, command.billboards[i].second);
+			}
+			node->attachObject(billboards);
+			break;
+		}
+		case SET_PROPERTY:
+			mProperties[make_pair(node->getName(), command.name)] = command.resource;
+			break;
+		}
+	} catch(Ogre::Exception &e){
+		//We'll just log, and continue on gracefully
+		LogManager::getSingleton().logMessage("[DotSceneLoader] " + e.getDescription());
+	}
+	return true;
+}
+
+String DotSceneLoader::attribute(const NameValuePairList &attributes, const String &name, const String &fallback){
+	NameValuePairList::const_iterator it = attributes.find(name);
+	return it == attributes.end() ? fallback : it->second;
+}
+
+Real DotSceneLoader::real(const NameValuePairList &attributes, const String &name, Real fallback){
+	NameValuePairList::const_iterator it = attributes.find(name);
+	return it == attributes.end() ? fallback : StringConverter::parseReal(it->second, fallback);
+}
+
+String DotSceneLoader::decode(const std::string &text){
+	if(text.find('&') == std::string::npos){
+		return text;
+	}
+	static const struct {
+		const char* entity;
+		char character;
+	} ENTITIES[] = {{"&lt;", '<'}, {"&gt;", '>'}, {"&amp;", '&'}, {"&quot;", '"'}, {"&apos;", '\''}};
+	String decoded;
+	for(size_t i = 0; i < text.size(); i++){
+		bool replaced = false;
+		if(text[i] == '&'){
+			for(int e = 0; e < sizeof(ENTITIES) / sizeof(ENTITIES[0]) && !replaced; e++){
+				size_t length = strlen(ENTITIES[e].entity);
+				if(text.compare(i, length, ENTITIES[e].entity) == 0){
+					decoded += ENTITIES[e].character;
+					i += length - 1;
+					replaced = true;
+				}
+			}
+			size_t end = text.find(';', i);
+			if(!replaced && text.compare(i, 2, "&#") == 0 && end != std::string::npos){
+				bool hex = i + 2 < text.size() && (text[i + 2] == 'x' || text[i + 2] == 'X');
+				decoded += (char)strtol(text.c_str() + i + (hex ? 3 : 2), 0, hex ? 16 : 10);
+				i = end;
+				replaced = true;
+			}
+		}
+		if(!replaced){
+			decoded += text[i];
+		}
+	}
+	return decoded;
+}
@@ -0,0 +1,203 @@
+//============================================================================
+// Name        : DotSceneLoader.h
+// Author      : Amrit Dhakal
+// Version     : 1.0
+// Copyright   : © Amrit Dhakal 2015. All right reserved. :D
+// Description : Streams DotScene files into the scene a batch per frame
+//============================================================================
+
+#ifndef DOTSCENELOADER_H_
+#define DOTSCENELOADER_H_
+
+#include <Ogre.h>
+#include <OgreResourceBackgroundQueue.h>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * Class DotSceneLoader loads a DotScene (.scene) file without holding it in memory:
+ * 		- a worker thread reads the file in chunks and tokenizes the XML as it goes,
+ * 		  turning every element into a small command (create a node, attach an entity...)
+ * 		- the meshes of the entities are prepared by the resource background queue as
+ * 		  soon as the worker first sees them, while the rest of the file is parsed
+ * 		- update() applies the commands on the main thread, a bounded batch per frame,
+ * 		  waiting for an entity's mesh to be prepared before creating it
+ *
+ * Nodes may be nested. The queue between the threads is bounded, so the memory used
+ * does not grow with the size of the file.
+ */
+class DotSceneLoader {
+public:
+
+	/**
+	 * Constructor:
+	 * 		parameter:
+	 * 			sceneMgr: scene manager the scene is created in
+	 */
+	DotSceneLoader(Ogre::SceneManager* sceneMgr);
+
+	/**
+	 * Destructor: stops the worker thread, what was created stays in the scene
+	 */
+	~DotSceneLoader();
+
+	/**
+	 * load: starts streaming the file
+	 * 		parameter:
+	 * 			sceneName: .scene file
+	 * 			groupName: resource group of the file and of its meshes
+	 * 			root: node the scene is created under, the root scene node if 0
+	 * 		return: true if the file was opened
+	 */
+	bool load(const Ogre::String &sceneName, const Ogre::String &groupName, Ogre::SceneNode* root = 0);
+
+	/**
+	 * update: applies the commands parsed so far (call every frame on the main thread)
+	 * 		parameter:
+	 * 			maxCommands: most commands applied
+	 * 		return: true once the whole file has been applied
+	 */
+	bool update(int maxCommands);
+
+	/**
+	 * isFinished: returns true once the whole file has been applied
+	 */
+	bool isFinished() const {
+		return mFinished;
+	}
+
+	/**
+	 * getProperty: returns the user data property of a node, " " if it has none
+	 */
+	Ogre::String getProperty(const Ogre::String &nodeName, const Ogre::String &property) const;
+
+private:
+
+	enum CommandType {
+		CREATE_NODE,
+		SET_POSITION,
+		SET_ORIENTATION,
+		SET_SCALE,
+		CREATE_ENTITY,
+		CREATE_LIGHT,
+		CREATE_BILLBOARD_SET,
+		SET_PROPERTY
+	};
+
+	/**
+	 * One change of the scene, parsed on the worker thread
+	 */
+	struct Command {
+		CommandType type;
+
+		//Index of the node it applies to, in the order the nodes appear in the file
+		int node;
+
+		//CREATE_NODE: index of the parent node, -1 for the root
+		int parent;
+
+		Ogre::String name;
+
+		//CREATE_ENTITY: mesh, CREATE_BILLBOARD_SET: material, SET_PROPERTY: value
+		Ogre::String resource;
+
+		//Position or scale, billboard set: default width and height in x and y
+		Ogre::Vector3 vector;
+		Ogre::Quaternion orientation;
+
+		//CREATE_LIGHT
+		Ogre::Light::LightTypes lightType;
+		Ogre::ColourValue diffuse;
+		Ogre::ColourValue specular;
+		Ogre::Vector4 attenuation;
+
+		//CREATE_BILLBOARD_SET
+		Ogre::BillboardType billboardType;
+		Ogre::BillboardOrigin billboardOrigin;
+		std::vector<std::pair<Ogre::Vector3, Ogre::ColourValue> > billboards;
+
+		bool castShadows;
+		bool visible;
+
+		Command(CommandType type, int node);
+	};
+
+	/**
+	 * parse: reads and tokenizes the file (worker thread)
+	 */
+	void parse();
+
+	/**
+	 * tokenize: finds the tags of the buffer and passes them on (worker thread)
+	 * 		return: number of characters consumed, the rest is an incomplete tag
+	 */
+	size_t tokenize(const std::string &buffer);
+
+	/**
+	 * startElement, endElement: turn the elements into commands (worker thread)
+	 */
+	void startElement(const Ogre::String &name, const Ogre::NameValuePairList &attributes);
+	void endElement(const Ogre::String &name);
+
+	/**
+	 * push: hands a command to the main thread, waiting while the queue is full (worker thread)
+	 */
+	void push(const Command &command);
+
+	/**
+	 * apply: applies a command (main thread)
+	 * 		return: false if it has to wait for its mesh
+	 */
+	bool apply(const Command &command);
+
+	/**
+	 * attribute, real: return the value of an attribute, or the fallback if the element has none
+	 */
+	static Ogre::String attribute(const Ogre::NameValuePairList &attributes, const Ogre::String &name,
+			const Ogre::String &fallback = "");
+	static Ogre::Real real(const Ogre::NameValuePairList &attributes, const Ogre::String &name, Ogre::Real fallback = 0);
+
+	/**
+	 * decode: replaces the character and entity references of an attribute value
+	 */
+	static Ogre::String decode(const std::string &text);
+
+	Ogre::SceneManager* mSceneMgr;
+	Ogre::SceneNode* mRoot;
+
+	//File being read, only touched by the worker thread once it is started
+	Ogre::DataStreamPtr mStream;
+
+	//Main thread: nodes created, by index, and the preparation of every mesh
+	std::vector<Ogre::SceneNode*> mNodes;
+	std::map<Ogre::String, Ogre::BackgroundProcessTicket> mMeshTickets;
+	std::deque<Command> mPending;
+	std::map<std::pair<Ogre::String, Ogre::String>, Ogre::String> mProperties;
+	bool mFinished;
+
+	//Worker thread: elements and nodes open, lights and billboard sets being read, meshes seen
+	std::vector<Ogre::String> mElements;
+	std::vector<int> mOpenNodes;
+	std::vector<Command> mOpenCommands;
+	std::map<Ogre::String, bool> mMeshesSeen;
+	int mNumNodes;
+	int mNumLights;
+
+	//Shared, guarded by mMutex
+	std::mutex mMutex;
+	std::condition_variable mSpace;
+	std::deque<Command> mQueue;
+	std::vector<Ogre::String> mPrefetch;
+	bool mParsed;
+
+	std::atomic<bool> mStop;
+	std::thread mThread;
+};
+
+#endif /* DOTSCENELOADER_H_ */
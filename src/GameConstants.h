@@ -0,0 +1,31 @@
+//============================================================================
+// Name        : GameConstants.h
+// Author      : Amrit Dhakal
+// Version     : 1.0
+// Copyright   : © Amrit Dhakal 2015. All right reserved. :D
+// Description : Constants of the rules and the game servers, usable without Ogre
+//============================================================================
+#ifndef GAMECONSTANTS_H_
+#define GAMECONSTANTS_H_
+
+//Game Constants
+const int MAX_LEVEL = 10;
+
+//Level Information
+
+const int LEVEL_DIM[] = {0,10,10,12,12,14,14,16,16,20,20};
+const int NUM_MINES[] = {0,15,20,21,26,30,35,39,46,80,100};
+const int MAX_BONUS_TIME[] = {0,20,30,50,80,120,150,190,210,270,360};
+const int POINTS_PER_REVEAL[] = {0,1,2,3,4,5,7,9,12,18,30};
+
+//Length (seconds) of one tick of the game simulation, the most ticks run to catch up
+//after a slow frame, and whether the ticks run on a thread of their own
+const double SIMULATION_TICK = 1.0 / 60.0;
+const int SIMULATION_MAX_TICKS = 10;
+const bool SIMULATION_ON_WORKER_THREAD = true;
+
+//The session host keeps its games in chunks of this many, and reports every interval (seconds)
+const int SESSION_ARENA_CHUNK = 1024;
+const double SESSION_HOST_REPORT_INTERVAL = 5;
+
+#endif /* GAMECONSTANTS_H_ */
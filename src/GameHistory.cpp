@@ -0,0 +1,244 @@
+//============================================================================
+// Name        : GameHistory.cpp
+// Author      : Amrit Dhakal
+// Version     : 1.0
+// Copyright   : © Amrit Dhakal 2015. All right reserved. :D
+// Description : Append only, columnar log of every finished game
+//============================================================================
+
+#include "GameHistory.h"
+
+#include <iostream>
+#include <fstream>
+#include <stdio.h>
+#include <limits.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+using namespace std;
+
+//Indexes of the fixed columns in m_columns
+enum {
+	COLUMN_PLAYER,
+	COLUMN_SEED,
+	COLUMN_LEVEL,
+	COLUMN_SCORE,
+	COLUMN_MOVES,
+	COLUMN_FIRST_TIME
+};
+
+GameHistory::GameHistory(const string &directory, int numLevels):
+					m_directory(directory),
+					m_numLevels(numLevels),
+					m_mappedRows(0),
+					m_dirty(true)
+{
+	mkdir(m_directory.c_str(), 0755);
+
+	Column column = {"", 0, 0, 0};
+	const char* names[] = {"player", "seed", "level", "score", "moves"};
+	const size_t widths[] = {sizeof(uint32_t), sizeof(uint32_t), sizeof(uint8_t), sizeof(int32_t), sizeof(uint32_t)};
+	for(int i = 0; i < COLUMN_FIRST_TIME; i++){
+		column.name = names[i];
+		column.width = widths[i];
+		m_columns.push_back(column);
+	}
+	for(int level = 1; level <= m_numLevels; level++){
+		char name[16];
+		snprintf(name, sizeof(name), "time%02d", level);
+		column.name = name;
+		column.width = sizeof(float);
+		m_columns.push_back(column);
+	}
+	loadPlayers();
+	truncateColumns();
+}
+
+GameHistory::~GameHistory() {
+	unmapColumns();
+}
+
+void GameHistory::loadPlayers(){
+	ifstream in((m_directory + "/players.txt").c_str(), ios::in);
+	string name;
+	while(getline(in, name)){
+		m_playerIds[name] = m_players.size();
+		m_players.push_back(name);
+	}
+}
+
+uint32_t GameHistory::getPlayerId(const string &player){
+	map<string, uint32_t>::iterator it = m_playerIds.find(player);
+	if(it != m_playerIds.end()){
+		return it->second;
+	}
+	uint32_t id = m_players.size();
+	ofstream out((m_directory + "/players.txt").c_str(), ios::out | ios::app);
+	out << player << endl;
+	m_playerIds[player] = id;
+	m_players.push_back(player);
+	return id;
+}
+
+bool GameHistory::appendValue(const Column &column, const void *value){
+	string filename = m_directory + "/" + column.name + ".col";
+	int fd = open(filename.c_str(), O_WRONLY | O_APPEND | O_CREAT, 0644);
+	if(fd < 0){
+		cerr << "File " << filename << " could not be opened for writing." << endl;
+		return false;
+	}
+	bool written = write(fd, value, column.width) == (ssize_t)column.width;
+	close(fd);
+	return written;
+}
+
+bool GameHistory::append(const GameRecord &record){
+	uint32_t player = getPlayerId(record.player);
+	uint8_t level = record.level;
+	int32_t score = record.score;
+
+	bool written = appendValue(m_columns[COLUMN_PLAYER], &player)
+			&& appendValue(m_columns[COLUMN_SEED], &record.seed)
+			&& appendValue(m_columns[COLUMN_LEVEL], &level)
+			&& appendValue(m_columns[COLUMN_SCORE], &score)
+			&& appendValue(m_columns[COLUMN_MOVES], &record.moves);
+	for(int i = 0; written && i < m_numLevels; i++){
+		float time = i < record.levelTimes.size() ? record.levelTimes[i] : 0;
+		written = appendValue(m_columns[COLUMN_FIRST_TIME + i], &time);
+	}
+	if(!written){
+		//Drop the part of the row that was written
+		truncateColumns();
+	}
+	m_dirty = true;
+	return written;
+}
+
+void GameHistory::truncateColumns(){
+	size_t rows = (size_t)-1;
+	vector<size_t> sizes;
+	for(int i = 0; i < m_columns.size(); i++){
+		string filename = m_directory + "/" + m_columns[i].name + ".col";
+		struct stat info;
+		size_t size = stat(filename.c_str(), &info) == 0 ? info.st_size : 0;
+		sizes.push_back(size);
+		rows = min(rows, size / m_columns[i].width);
+	}
+	for(int i = 0; i < m_columns.size(); i++){
+		size_t size = rows * m_columns[i].width;
+		if(sizes[i] == size){
+			continue;
+		}
+		string filename = m_directory + "/" + m_columns[i].name + ".col";
+		cerr << "Column " << filename << " had an incomplete row, truncated to " << rows << " rows." << endl;
+		if(truncate(filename.c_str(), size) != 0){
+			cerr << "File " << filename << " could not be truncated." << endl;
+		}
+	}
+}
+
+void GameHistory::unmapColumns(){
+	for(int i = 0; i < m_columns.size(); i++){
+		if(m_columns[i].data){
+			munmap((void*)m_columns[i].data, m_columns[i].mappedSize);
+		}
+		m_columns[i].data = 0;
+		m_columns[i].mappedSize = 0;
+	}
+	m_mappedRows = 0;
+}
+
+size_t GameHistory::mapColumns(){
+	if(!m_dirty){
+		return m_mappedRows;
+	}
+	unmapColumns();
+	size_t rows = (size_t)-1;
+	for(int i = 0; i < m_columns.size(); i++){
+		Column &column = m_columns[i];
+		string filename = m_directory + "/" + column.name + ".col";
+		int fd = open(filename.c_str(), O_RDONLY);
+		struct stat info;
+		if(fd < 0 || fstat(fd, &info) != 0 || info.st_size == 0){
+			if(fd >= 0){
+				close(fd);
+			}
+			rows = 0;
+			continue;
+		}
+		void *data = mmap(0, info.st_size, PROT_READ, MAP_SHARED, fd, 0);
+		close(fd);
+		if(data == MAP_FAILED){
+			rows = 0;
+			continue;
+		}
+		column.data = (const char*)data;
+		column.mappedSize = info.st_size;
+		rows = min(rows, column.mappedSize / column.width);
+	}
+	m_mappedRows = rows == (size_t)-1 ? 0 : rows;
+	m_dirty = false;
+	return m_mappedRows;
+}
+
+size_t GameHistory::getNumGames(){
+	return mapColumns();
+}
+
+double GameHistory::getAverageLevelTime(int level){
+	size_t rows = mapColumns();
+	if(level < 1 || level > m_numLevels || rows == 0){
+		return 0;
+	}
+	//Levels that were not completed have a time of 0, so they add nothing to the sum
+	const float* times = values<float>(m_columns[COLUMN_FIRST_TIME + level - 1]);
+	double sum = 0;
+	size_t completed = 0;
+	for(size_t i = 0; i < rows; i++){
+		sum += times[i];
+		completed += times[i] > 0;
+	}
+	return completed == 0 ? 0 : sum / completed;
+}
+
+map<string, int> GameHistory::getBestScores(){
+	size_t rows = mapColumns();
+	map<string, int> best;
+	if(rows == 0){
+		return best;
+	}
+	const uint32_t* players = values<uint32_t>(m_columns[COLUMN_PLAYER]);
+	const int32_t* scores = values<int32_t>(m_columns[COLUMN_SCORE]);
+	vector<int32_t> bestById(m_players.size(), INT_MIN);
+	for(size_t i = 0; i < rows; i++){
+		uint32_t id = players[i];
+		if(id < bestById.size() && scores[i] > bestById[id]){
+			bestById[id] = scores[i];
+		}
+	}
+	for(size_t id = 0; id < bestById.size(); id++){
+		if(bestById[id] != INT_MIN){
+			best[m_players[id]] = bestById[id];
+		}
+	}
+	return best;
+}
+
+GameRecord GameHistory::getRecord(size_t row){
+	GameRecord record;
+	if(row >= mapColumns()){
+		return record;
+	}
+	uint32_t player = values<uint32_t>(m_columns[COLUMN_PLAYER])[row];
+	record.player = player < m_players.size() ? m_players[player] : "";
+	record.seed = values<uint32_t>(m_columns[COLUMN_SEED])[row];
+	record.level = values<uint8_t>(m_columns[COLUMN_LEVEL])[row];
+	record.score = values<int32_t>(m_columns[COLUMN_SCORE])[row];
+	record.moves = values<uint32_t>(m_columns[COLUMN_MOVES])[row];
+	for(int i = 0; i < m_numLevels; i++){
+		record.levelTimes.push_back(values<float>(m_columns[COLUMN_FIRST_TIME + i])[row]);
+	}
+	return record;
+}
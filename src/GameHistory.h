@@ -0,0 +1,165 @@
+//============================================================================
+// Name        : GameHistory.h
+// Author      : Amrit Dhakal
+// Version     : 1.0
+// Copyright   : © Amrit Dhakal 2015. All right reserved. :D
+// Description : Append only, columnar log of every finished game
+//============================================================================
+
+#ifndef GAMEHISTORY_H_
+#define GAMEHISTORY_H_
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <map>
+
+/**
+ * Everything that is kept about a finished game
+ */
+struct GameRecord {
+	std::string player;
+	uint32_t seed;
+	int level;
+	int score;
+	uint32_t moves;
+	//Seconds spent on each level, index 0 being level 1 (0 for levels not reached)
+	std::vector<float> levelTimes;
+};
+
+/**
+ * Class GameHistory stores finished games in a directory with one file per column.
+ * Every column file is an array of fixed width values, so row i of the log is the
+ * i-th value of every column. Rows are only ever appended. For queries the columns
+ * are memory mapped and scanned as plain arrays.
+ *
+ * A crash, or a full disk, while appending can leave the last row written to some
+ * columns only; every column is cut back to the complete rows when the log is
+ * opened and after a failed append, so the next row lines up again.
+ *
+ * Columns:
+ * 		player.col: uint32 index into players.txt (one name per line)
+ * 		seed.col:   uint32 random seed of the game
+ * 		level.col:  uint8 level reached
+ * 		score.col:  int32 final score
+ * 		moves.col:  uint32 number of reveals and flags
+ * 		timeNN.col: float seconds spent on level NN
+ */
+class GameHistory {
+public:
+
+	/**
+	 * Constructor:
+	 * 		parameter:
+	 * 			directory: the directory holding the column files (created if needed)
+	 * 			numLevels: the highest level of the game
+	 */
+	GameHistory(const std::string &directory, int numLevels);
+
+	/**
+	 * Destructor: unmaps the columns
+	 */
+	virtual ~GameHistory();
+
+	/**
+	 * append: appends a finished game to the log
+	 * 		return:
+	 * 			true: if every column was written
+	 * 			false: if the log could not be written
+	 */
+	bool append(const GameRecord &record);
+
+	/**
+	 * getNumGames: returns the number of games in the log
+	 */
+	size_t getNumGames();
+
+	/**
+	 * getAverageLevelTime: returns the average time spent on the level by the games
+	 * that completed it (0 if no game completed it)
+	 */
+	double getAverageLevelTime(int level);
+
+	/**
+	 * getBestScores: returns the best score of every player in the log
+	 */
+	std::map<std::string, int> getBestScores();
+
+	/**
+	 * getRecord: returns the game at the given row of the log
+	 */
+	GameRecord getRecord(size_t row);
+
+protected:
+
+	/**
+	 * A memory mapped column file
+	 */
+	struct Column {
+		std::string name;
+		size_t width;
+		const char* data;
+		size_t mappedSize;
+	};
+
+	/**
+	 * Maps every column and returns the number of complete rows
+	 */
+	size_t mapColumns();
+
+	/**
+	 * Truncates every column file to the rows written to all of them
+	 */
+	void truncateColumns();
+
+	/**
+	 * Unmaps every column
+	 */
+	void unmapColumns();
+
+	/**
+	 * Appends one value to the column file
+	 */
+	bool appendValue(const Column &column, const void *value);
+
+	/**
+	 * Returns the id of the player, adding the player to players.txt if needed
+	 */
+	uint32_t getPlayerId(const std::string &player);
+
+	/**
+	 * Loads the player names from players.txt
+	 */
+	void loadPlayers();
+
+	/**
+	 * Returns a pointer to the typed values of the column
+	 */
+	template<typename T>
+	const T* values(const Column &column) const {
+		return reinterpret_cast<const T*>(column.data);
+	}
+
+	//Directory of the log
+	std::string m_directory;
+
+	//Highest level of the game
+	int m_numLevels;
+
+	//Columns: player, seed, level, score, moves, then one time column per level
+	std::vector<Column> m_columns;
+
+	//Player names, index being the player id
+	std::vector<std::string> m_players;
+
+	//Player id for each name
+	std::map<std::string, uint32_t> m_playerIds;
+
+	//Number of complete rows in the current mapping
+	size_t m_mappedRows;
+
+	//Is the current mapping stale?
+	bool m_dirty;
+};
+
+#endif /* GAMEHISTORY_H_ */
@@ -0,0 +1,308 @@
+//============================================================================
+// Name        : GameProtocol.cpp
+// Author      : Amrit Dhakal
+// Version     : 1.0
+// Copyright   : © Amrit Dhakal 2015. All right reserved. :D
+// Description : Line-delimited JSON protocol the game is played over without a window
+//============================================================================
+
+#include "GameProtocol.h"
+#include <atomic>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+using namespace std;
+
+static const char* skipSpaces(const char *p, const char *end){
+	while(p < end && (*p == ' ' || *p == '\t' || *p == '\r')){
+		p++;
+	}
+	return p;
+}
+
+/**
+ * Parses a string starting at the opening quote, escapes are kept as they are
+ */
+static const char* parseString(const char *p, const char *end, string &value){
+	if(p == end || *p != '"'){
+		return 0;
+	}
+	const char *start = ++p;
+	while(p < end && *p != '"'){
+		if(*p == '\\'){
+			p++;
+		}
+		p++;
+	}
+	if(p >= end){
+		return 0;
+	}
+	value.assign(start, p);
+	return p + 1;
+}
+
+bool GameProtocol::isBlank(const char *begin, const char *end){
+	return skipSpaces(begin, end) == end;
+}
+
+bool GameProtocol::parseRequest(const char *p, const char *end, GameRequest &request, string &error){
+	p = skipSpaces(p, end);
+	if(p == end || *p != '{'){
+		error = "expected an object";
+		return false;
+	}
+	p = skipSpaces(p + 1, end);
+	if(p < end && *p == '}'){
+		error = "missing cmd";
+		return false;
+	}
+	string key, text;
+	while(p < end){
+		p = parseString(p, end, key);
+		if(!p){
+			error = "expected a key";
+			return false;
+		}
+		p = skipSpaces(p, end);
+		if(p == end || *p != ':'){
+			error = "expected ':'";
+			return false;
+		}
+		p = skipSpaces(p + 1, end);
+		long long number = -1;
+		bool isNumber = p < end && (*p == '-' || (*p >= '0' && *p <= '9'));
+		if(isNumber){
+			const char *start = p;
+			char *numberEnd;
+			number = strtoll(start, &numberEnd, 10);
+			p = numberEnd;
+			text.assign(start, p);
+		}
+		else {
+			p = parseString(p, end, text);
+			if(!p){
+				error = "values are strings or integers";
+				return false;
+			}
+		}
+		if(key == "cmd"){
+			request.cmd = text;
+		}
+		else if(key == "id"){
+			//Sent back as it came
+			request.id = isNumber ? text : "\"" + text + "\"";
+		}
+		else if(isNumber && key == "session"){
+			request.session = number;
+		}
+		else if(isNumber && key == "cell"){
+			request.cell = number;
+		}
+		else if(isNumber && key == "row"){
+			request.row = number;
+		}
+		else if(isNumber && key == "col"){
+			request.col = number;
+		}
+		else if(isNumber && key == "seed"){
+			request.seed = number;
+		}
+		p = skipSpaces(p, end);
+		if(p < end && *p == ','){
+			p = skipSpaces(p + 1, end);
+			continue;
+		}
+		if(p < end && *p == '}'){
+			if(request.cmd.empty()){
+				error = "missing cmd";
+				return false;
+			}
+			return true;
+		}
+		break;
+	}
+	error = "expected ',' or '}'";
+	return false;
+}
+
+const char* GameProtocol::toCommand(const GameRequest &request, int dim, GameCommand &command){
+	if(request.cmd == "new"){
+		command = GameCommand::newGame(request.seed >= 0 ? (unsigned int)request.seed : newSeed());
+		return 0;
+	}
+	if(request.cmd == "continue"){
+		command = GameCommand::continueLevel();
+		return 0;
+	}
+	if(request.cmd != "reveal" && request.cmd != "flag" && request.cmd != "chord"){
+		return "unknown cmd";
+	}
+	long long cell = request.cell;
+	if(request.row >= 0 && request.col >= 0 && request.row < dim && request.col < dim){
+		cell = request.row * dim + request.col;
+	}
+	if(cell < 0 || cell >= dim * dim){
+		return "no such cell";
+	}
+	if(request.cmd == "reveal"){
+		command = GameCommand::reveal(cell);
+	}
+	else if(request.cmd == "flag"){
+		command = GameCommand::flag(cell);
+	}
+	else {
+		command = GameCommand::chord(cell);
+	}
+	return 0;
+}
+
+/**
+ * Code of a cell in the deltas
+ */
+static int cellCode(const CellState &cell){
+	if(cell.revealed){
+		return cell.mine ? 9 : cell.minesAround;
+	}
+	return cell.flagged ? 10 : 11;
+}
+
+static const char* stateName(GameRules::State state){
+	switch(state){
+	case GameRules::LEVEL_COMPLETE:
+		return "level_complete";
+	case GameRules::GAME_OVER:
+		return "game_over";
+	case GameRules::COMPLETED:
+		return "completed";
+	default:
+		return "playing";
+	}
+}
+
+/**
+ * Appends the opening of a response: the id and the session of the request
+ */
+static void appendHeader(string &out, const GameRequest &request){
+	out += "{";
+	if(!request.id.empty()){
+		out += "\"id\":" + request.id + ",";
+	}
+	if(request.session >= 0){
+		out += "\"session\":";
+		GameProtocol::appendInt(out, request.session);
+		out += ",";
+	}
+}
+
+void GameProtocol::appendInt(string &out, long long value){
+	char buffer[24];
+	int length = snprintf(buffer, sizeof(buffer), "%lld", value);
+	out.append(buffer, length);
+}
+
+void GameProtocol::appendError(string &out, const GameRequest &request, const char *error){
+	appendHeader(out, request);
+	out += "\"error\":\"";
+	out += error;
+	out += "\"}\n";
+}
+
+void GameProtocol::appendResponse(string &out, const GameRequest &request, const GameRules &rules,
+		bool newBoard, const vector<int> &changed, const vector<GameEvent> &events){
+	appendHeader(out, request);
+	out += "\"state\":\"";
+	out += stateName(rules.getState());
+	out += "\",\"level\":";
+	appendInt(out, rules.getLevel());
+	out += ",\"score\":";
+	appendInt(out, rules.getScore());
+	out += ",\"moves\":";
+	appendInt(out, rules.getMoves());
+	char time[32];
+	out.append(time, snprintf(time, sizeof(time), ",\"time\":%.3f", rules.getTime()));
+
+	bool wholeBoard = request.cmd == "state";
+	if(newBoard || wholeBoard){
+		out += ",\"dim\":";
+		appendInt(out, rules.getDim());
+	}
+	int numCells = rules.getNumCells();
+	if(wholeBoard){
+		static const char CELL_CHARS[] = "012345678*F.";
+		out += ",\"cells\":\"";
+		for(int i = 0; i < numCells; i++){
+			out += CELL_CHARS[cellCode(rules.getCell(i))];
+		}
+		out += "\"";
+	}
+	else {
+		out += ",\"d\":[";
+		bool first = true;
+		if(newBoard){
+			//The player saw another board, every cell not hidden is sent
+			for(int i = 0; i < numCells; i++){
+				int code = cellCode(rules.getCell(i));
+				if(code != 11){
+					if(!first){
+						out += ",";
+					}
+					appendInt(out, i);
+					out += ",";
+					appendInt(out, code);
+					first = false;
+				}
+			}
+		}
+		else {
+			for(int i = 0; i < changed.size(); i++){
+				if(!first){
+					out += ",";
+				}
+				appendInt(out, changed[i]);
+				out += ",";
+				appendInt(out, cellCode(rules.getCell(changed[i])));
+				first = false;
+			}
+		}
+		out += "]";
+	}
+
+	bool firstEvent = true;
+	for(int i = 0; i < events.size(); i++){
+		const char *name = 0;
+		switch(events[i].type){
+		case GameEvent::CHORD_FAILED:
+			name = "chord_failed";
+			break;
+		case GameEvent::LEVEL_UP:
+			name = "level_up";
+			break;
+		case GameEvent::GAME_OVER:
+			name = "game_over";
+			break;
+		case GameEvent::GAME_COMPLETED:
+			name = "game_completed";
+			break;
+		default:
+			break;
+		}
+		if(name){
+			out += firstEvent ? ",\"ev\":[\"" : ",\"";
+			out += name;
+			out += "\"";
+			firstEvent = false;
+		}
+	}
+	if(!firstEvent){
+		out += "]";
+	}
+	out += "}\n";
+}
+
+unsigned int GameProtocol::newSeed(){
+	//Games are dealt from several threads by SessionHost
+	static atomic<unsigned int> games(0);
+	return time(NULL) ^ ((unsigned int)getpid() << 16) ^ (games++ * 2654435761u);
+}
@@ -0,0 +1,94 @@
+//============================================================================
+// Name        : GameProtocol.h
+// Author      : Amrit Dhakal
+// Version     : 1.0
+// Copyright   : © Amrit Dhakal 2015. All right reserved. :D
+// Description : Line-delimited JSON protocol the game is played over without a window
+//============================================================================
+
+#ifndef GAMEPROTOCOL_H_
+#define GAMEPROTOCOL_H_
+
+#include "GameRules.h"
+#include <string>
+#include <vector>
+
+/**
+ * Fields of a request, the protocol only uses flat objects of strings and integers
+ */
+struct GameRequest {
+	std::string cmd;
+	std::string id;		//Sent back as it came, quotes included
+	long long session = -1;
+	long long cell = -1;
+	long long row = -1;
+	long long col = -1;
+	long long seed = -1;
+};
+
+/**
+ * Class GameProtocol reads the requests and writes the responses of the protocol
+ * spoken by HeadlessServer and SessionHost (see HeadlessServer.h).
+ */
+class GameProtocol {
+public:
+	//Longest request line, and most responses a client may leave unread (bytes);
+	//a client going beyond either is disconnected
+	static const size_t MAX_LINE = 4096;
+	static const size_t MAX_PENDING_OUTPUT = 16 << 20;
+
+	/**
+	 * parseRequest: parses one request line
+	 * 		parameter:
+	 * 			begin, end: the line, without the newline
+	 * 			request: receives the fields of the request
+	 * 			error: receives why the line is not a request
+	 * 		return: false if the line is not a request
+	 */
+	static bool parseRequest(const char *begin, const char *end, GameRequest &request, std::string &error);
+
+	/**
+	 * isBlank: returns true if the line holds nothing but spaces
+	 */
+	static bool isBlank(const char *begin, const char *end);
+
+	/**
+	 * toCommand: returns the command of a "new", "continue", "reveal", "flag" or "chord" request
+	 * 		parameter:
+	 * 			request: the request
+	 * 			dim: dimension of the board the cell is on
+	 * 			command: receives the command
+	 * 		return: 0, or the error to answer the request with
+	 */
+	static const char* toCommand(const GameRequest &request, int dim, GameCommand &command);
+
+	/**
+	 * appendResponse: appends the response to a request
+	 * 		parameter:
+	 * 			out: the output of the connection
+	 * 			request: the request answered
+	 * 			rules: the game after the request
+	 * 			newBoard: a new board was dealt since the previous response
+	 * 			changed: the cells changed since the previous response, on the same board
+	 * 			events: what happened since the previous response
+	 */
+	static void appendResponse(std::string &out, const GameRequest &request, const GameRules &rules,
+			bool newBoard, const std::vector<int> &changed, const std::vector<GameEvent> &events);
+
+	/**
+	 * appendError: appends the error response to a request
+	 */
+	static void appendError(std::string &out, const GameRequest &request, const char *error);
+
+	/**
+	 * appendInt: appends an integer in decimal
+	 */
+	static void appendInt(std::string &out, long long value);
+
+	/**
+	 * newSeed: returns a seed for a game nobody gave a seed for
+	 */
+	static unsigned int newSeed();
+};
+
+#endif /* GAMEPROTOCOL_H_ */
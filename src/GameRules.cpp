@@ -0,0 +1,258 @@
+//============================================================================
+// Name        : GameRules.cpp
+// Author      : Amrit Dhakal
+// Version     : 1.0
+// Copyright   : © Amrit Dhakal 2015. All right reserved. :D
+// Description : Rules of the game: the board, the mines, the score and the levels
+//============================================================================
+
+#include "GameRules.h"
+#include "GameConstants.h"
+#include "Profiler.h"
+#include <algorithm>
+#include <assert.h>
+
+GameRules::GameRules(unsigned int seed)
+	: mRandom(seed), mState(PLAYING), mLevel(1), mDim(0), mScore(0), mRevealed(0), mFlaggedMines(0), mMoves(0),
+	  mBoard(0), mInitialized(false), mTime(0), mGameOverTime(0), mEvents(0), mChanged(0)
+{
+	for(int level = 1; level <= MAX_LEVEL; level++){
+		assert(LEVEL_DIM[level] <= MAX_DIM);
+	}
+	deal();
+}
+
+int GameRules::getNeighbors(int dim, int cell, int neighbors[8]){
+	int row = cell / dim;
+	int col = cell % dim;
+	int count = 0;
+	for(int r = row - 1; r <= row + 1; r++){
+		for(int c = col - 1; c <= col + 1; c++){
+			if(r >= 0 && r < dim && c >= 0 && c < dim && !(r == row && c == col)){
+				neighbors[count++] = r * dim + c;
+			}
+		}
+	}
+	return count;
+}
+
+void GameRules::apply(const GameCommand &command, std::vector<GameEvent> &events, std::vector<int> &changed){
+	mEvents = &events;
+	mChanged = &changed;
+	if(command.type == GameCommand::NEW_GAME){
+		mRandom.seed(command.seed);
+		mState = PLAYING;
+		mLevel = 1;
+		mScore = 0;
+		mMoves = 0;
+		deal();
+		return;
+	}
+	if(command.type == GameCommand::CONTINUE){
+		if(mState == LEVEL_COMPLETE){
+			mState = PLAYING;
+			mLevel++;
+			deal();
+		}
+		return;
+	}
+	if(mState != PLAYING || command.cell < 0 || command.cell >= getNumCells()){
+		return;
+	}
+	if(command.type == GameCommand::CHORD && !mCells[command.cell].revealed){
+		return;
+	}
+	if(!mInitialized){
+		placeMines(command.cell);
+	}
+	mMoves++;
+	if(command.type == GameCommand::FLAG){
+		CellState &cell = mCells[command.cell];
+		if(!cell.revealed){
+			cell.flagged = !cell.flagged;
+			if(cell.mine){
+				mFlaggedMines += cell.flagged ? 1 : -1;
+			}
+			change(command.cell);
+		}
+		event(GameEvent::CLICK, command.cell).flag = true;
+		if(isLevelUp()){
+			levelUp();
+		}
+		return;
+	}
+
+	bool chord = mCells[command.cell].revealed;
+	int before = mRevealed;
+	size_t numEvents = events.size();
+	if(!click(command.cell)){
+		gameOver();
+		return;
+	}
+	//A chord without as many flags as mines around the cell only reports CHORD_FAILED
+	bool chordFailed = events.size() > numEvents && events.back().type == GameEvent::CHORD_FAILED;
+	int revealed = mRevealed - before;
+	mScore += POINTS_PER_REVEAL[mLevel] * revealed;
+	GameEvent &e = event(GameEvent::CLICK, command.cell);
+	e.chord = chord && !chordFailed;
+	e.revealed = revealed;
+	if(isLevelUp()){
+		levelUp();
+	}
+}
+
+void GameRules::deal(){
+	mDim = LEVEL_DIM[mLevel];
+	std::fill(mCells, mCells + getNumCells(), CellState());
+	mRevealed = 0;
+	mFlaggedMines = 0;
+	mInitialized = false;
+	mTime = 0;
+	mGameOverTime = 0;
+	mBoard++;
+}
+
+void GameRules::placeMines(int firstCell){
+	mInitialized = true;
+	int numCells = getNumCells();
+	int placed = 0;
+	while(placed < NUM_MINES[mLevel]){
+		int cell = mRandom() % numCells;
+		if(!mCells[cell].mine && cell != firstCell){
+			mCells[cell].mine = true;
+			placed++;
+		}
+	}
+	int neighbors[8];
+	for(int i = 0; i < numCells; i++){
+		int count = getNeighbors(mDim, i, neighbors);
+		for(int n = 0; n < count; n++){
+			if(mCells[neighbors[n]].mine){
+				mCells[i].minesAround++;
+			}
+		}
+	}
+}
+
+bool GameRules::reveal(int cell){
+	CellState &state = mCells[cell];
+	if(state.flagged || state.revealed){
+		return true;
+	}
+	state.revealed = true;
+	change(cell);
+	if(state.mine){
+		return false;
+	}
+	mRevealed++;
+	if(state.minesAround != 0){
+		return true;
+	}
+	//Flood the empty area without recursion, the largest board would go deep. A cell
+	//is revealed before it is pushed, so the stack never holds more than the board.
+	int stack[MAX_CELLS];
+	int size = 0;
+	int neighbors[8];
+	stack[size++] = cell;
+	while(size > 0){
+		int current = stack[--size];
+		int count = getNeighbors(mDim, current, neighbors);
+		for(int n = 0; n < count; n++){
+			CellState &next = mCells[neighbors[n]];
+			if(next.flagged || next.revealed){
+				continue;
+			}
+			next.revealed = true;
+			change(neighbors[n]);
+			mRevealed++;
+			if(next.minesAround == 0){
+				stack[size++] = neighbors[n];
+			}
+		}
+	}
+	return true;
+}
+
+bool GameRules::click(int cell){
+	PROFILE_SCOPE("GameRules::click");
+	const CellState &state = mCells[cell];
+	if(state.flagged){
+		return true;
+	}
+	if(!state.revealed){
+		return reveal(cell);
+	}
+
+	int neighbors[8];
+	int count = getNeighbors(mDim, cell, neighbors);
+	int flags = 0;
+	for(int n = 0; n < count; n++){
+		if(mCells[neighbors[n]].flagged){
+			flags++;
+		}
+	}
+	if(state.minesAround != 0 && flags == state.minesAround){
+		for(int n = 0; n < count; n++){
+			if(!reveal(neighbors[n])){
+				return false;
+			}
+		}
+	}
+	else {
+		event(GameEvent::CHORD_FAILED, cell);
+	}
+	return true;
+}
+
+bool GameRules::isLevelUp() const {
+	return mRevealed == getNumCells() - NUM_MINES[mLevel] || mFlaggedMines == NUM_MINES[mLevel];
+}
+
+void GameRules::levelUp(){
+	if(mLevel < MAX_LEVEL){
+		if(mTime < MAX_BONUS_TIME[mLevel]){
+			//award bonus points
+			mScore = mScore + 2 * (MAX_BONUS_TIME[mLevel] - mTime);
+		}
+		mState = LEVEL_COMPLETE;
+		event(GameEvent::LEVEL_UP);
+	}
+	else {
+		int numCells = getNumCells();
+		for(int i = 0; i < numCells; i++){
+			if(!mCells[i].flagged && !mCells[i].revealed){
+				mCells[i].revealed = true;
+				change(i);
+			}
+		}
+		mState = COMPLETED;
+		event(GameEvent::GAME_COMPLETED);
+	}
+}
+
+void GameRules::gameOver(){
+	int numCells = getNumCells();
+	for(int i = 0; i < numCells; i++){
+		if(mCells[i].mine && !mCells[i].flagged && !mCells[i].revealed){
+			mCells[i].revealed = true;
+			change(i);
+		}
+	}
+	mState = GAME_OVER;
+	mGameOverTime = mTime;
+	event(GameEvent::GAME_OVER);
+}
+
+GameEvent& GameRules::event(GameEvent::Type type, int cell){
+	GameEvent e;
+	e.type = type;
+	e.cell = cell;
+	e.flag = false;
+	e.chord = false;
+	e.revealed = 0;
+	e.level = mLevel;
+	e.score = mScore;
+	e.time = mTime;
+	mEvents->push_back(e);
+	return mEvents->back();
+}
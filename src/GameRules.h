@@ -0,0 +1,270 @@
+//============================================================================
+// Name        : GameRules.h
+// Author      : Amrit Dhakal
+// Version     : 1.0
+// Copyright   : © Amrit Dhakal 2015. All right reserved. :D
+// Description : Rules of the game: the board, the mines, the score and the levels
+//============================================================================
+
+#ifndef GAMERULES_H_
+#define GAMERULES_H_
+
+#include <vector>
+#include <random>
+
+/**
+ * State of one cell of the board, packed in one byte: boards are scanned whole
+ * (level up, snapshots, deltas) and a game is copied into every snapshot
+ */
+struct CellState {
+	unsigned char mine : 1;
+	unsigned char revealed : 1;
+	unsigned char flagged : 1;
+	unsigned char minesAround : 4;
+
+	CellState(): mine(0), revealed(0), flagged(0), minesAround(0) {}
+
+	bool operator==(const CellState &other) const {
+		return mine == other.mine && revealed == other.revealed
+				&& flagged == other.flagged && minesAround == other.minesAround;
+	}
+	bool operator!=(const CellState &other) const {
+		return !(*this == other);
+	}
+};
+
+static_assert(sizeof(CellState) == 1, "a cell is one byte");
+
+/**
+ * Command given to the game by the player
+ */
+struct GameCommand {
+	enum Type {
+		REVEAL,	//Reveals the cell, or reveals its neighbours if it is revealed and all its mines are flagged
+		FLAG,	//Flags or unflags the cell
+		CHORD,	//Reveals the neighbours of a revealed cell whose mines are all flagged
+		CONTINUE,	//Deals the next level once the player has seen the level completed
+		NEW_GAME	//Starts a new game at level 1 with the seed
+	};
+	Type type;
+	int cell;
+	unsigned int seed;
+
+	static GameCommand reveal(int cell){
+		return GameCommand{REVEAL, cell, 0};
+	}
+	static GameCommand flag(int cell){
+		return GameCommand{FLAG, cell, 0};
+	}
+	static GameCommand chord(int cell){
+		return GameCommand{CHORD, cell, 0};
+	}
+	static GameCommand continueLevel(){
+		return GameCommand{CONTINUE, -1, 0};
+	}
+	static GameCommand newGame(unsigned int seed){
+		return GameCommand{NEW_GAME, -1, seed};
+	}
+};
+
+/**
+ * Something that happened while applying a command which the renderer or the
+ * bookkeeping (metrics, high scores, history) has to react to
+ */
+struct GameEvent {
+	enum Type {
+		CLICK,			//A reveal or flag was applied, revealed holds the number of cells it revealed
+		CHORD_FAILED,	//A revealed cell was clicked without all of its mines flagged
+		GAME_OVER,		//A mine was revealed
+		LEVEL_UP,		//level was completed, the next one is dealt by a CONTINUE command
+		GAME_COMPLETED	//The last level was completed
+	};
+	Type type;
+	int cell;
+	bool flag;		//CLICK: the command was a flag
+	bool chord;		//CLICK: the cell was already revealed and chorded (not CHORD_FAILED)
+	int revealed;	//CLICK: cells revealed by the command
+	int level;		//Level the event happened on
+	int score;		//Score after the event
+	double time;	//Time spent on the level when the event happened
+};
+
+/**
+ * Class GameRules applies the player's commands to a game. It holds nothing but the
+ * state of one game, the cells kept inline for the largest board, so a game is one
+ * block of memory without any allocation of its own; servers keep thousands of them.
+ * It is not thread safe, GameSimulation runs it at a fixed tick for the game.
+ */
+class GameRules {
+public:
+	enum State {
+		PLAYING,
+		LEVEL_COMPLETE,	//Only CONTINUE and NEW_GAME are applied: commands meant for the
+						//completed board must not land on the next one
+		GAME_OVER,
+		COMPLETED
+	};
+
+	//Dimension of the largest board of LEVEL_DIM
+	static const int MAX_DIM = 20;
+	static const int MAX_CELLS = MAX_DIM * MAX_DIM;
+
+	/**
+	 * Constructor: deals the first board of a game
+	 * 		parameter:
+	 * 			seed: seed of the mines of the game
+	 */
+	GameRules(unsigned int seed);
+
+	/**
+	 * apply: applies a command to the game
+	 * 		parameter:
+	 * 			command: the command to apply
+	 * 			events: receives what happened
+	 * 			changed: receives the cells revealed, flagged or unflagged on the board
+	 * 					of before the command (a new board is told by getBoard())
+	 */
+	void apply(const GameCommand &command, std::vector<GameEvent> &events, std::vector<int> &changed);
+
+	/**
+	 * advanceTime: moves the time of the level on, once its mines are placed and
+	 * until it is completed
+	 */
+	void advanceTime(double elapsed){
+		if(mInitialized && mState != LEVEL_COMPLETE){
+			mTime += elapsed;
+		}
+	}
+
+	State getState() const {
+		return mState;
+	}
+	int getLevel() const {
+		return mLevel;
+	}
+	int getDim() const {
+		return mDim;
+	}
+	int getNumCells() const {
+		return mDim * mDim;
+	}
+	const CellState& getCell(int cell) const {
+		return mCells[cell];
+	}
+	const CellState* getCells() const {
+		return mCells;
+	}
+	int getScore() const {
+		return mScore;
+	}
+	unsigned int getMoves() const {
+		return mMoves;
+	}
+
+	/**
+	 * getBoard: returns a number which changes every time a new board is dealt
+	 */
+	unsigned int getBoard() const {
+		return mBoard;
+	}
+
+	/**
+	 * isInitialized: have the mines been placed? The level time runs from the first click
+	 */
+	bool isInitialized() const {
+		return mInitialized;
+	}
+	double getTime() const {
+		return mTime;
+	}
+	double getGameOverTime() const {
+		return mGameOverTime;
+	}
+
+	/**
+	 * getNeighbors: returns the cells around the cell of a board
+	 * 		parameter:
+	 * 			dim: dimension of the board
+	 * 			cell: index of the cell (row * dim + column)
+	 * 			neighbors: receives the indices of the at most 8 neighbours
+	 * 		return: the number of neighbours
+	 */
+	static int getNeighbors(int dim, int cell, int neighbors[8]);
+
+private:
+	/**
+	 * deal: sets up an empty board for the current level
+	 */
+	void deal();
+
+	/**
+	 * placeMines: places the mines of the level anywhere but on the first cell clicked
+	 */
+	void placeMines(int firstCell);
+
+	/**
+	 * reveal: reveals a cell, and the cells around it while they have no mine around them
+	 * 		return: false if a mine was revealed
+	 */
+	bool reveal(int cell);
+
+	/**
+	 * click: applies a reveal to the cell, chording if it is already revealed
+	 * 		return: false if a mine was revealed
+	 */
+	bool click(int cell);
+
+	/**
+	 * isLevelUp: returns true if every safe cell is revealed or every mine flagged
+	 */
+	bool isLevelUp() const;
+
+	/**
+	 * levelUp: awards the bonus and completes the level, or the game on the last level
+	 */
+	void levelUp();
+
+	/**
+	 * gameOver: ends the game and reveals the mines
+	 */
+	void gameOver();
+
+	/**
+	 * event: records an event of the command being applied
+	 * 		return: the event, for the caller to fill in the details
+	 */
+	GameEvent& event(GameEvent::Type type, int cell = -1);
+
+	/**
+	 * change: records a cell whose visible state the command changed
+	 */
+	void change(int cell){
+		mChanged->push_back(cell);
+	}
+
+	std::minstd_rand mRandom;
+	State mState;
+	int mLevel;
+	int mDim;
+	int mScore;
+	int mRevealed;
+	int mFlaggedMines;
+	unsigned int mMoves;
+	unsigned int mBoard;
+	bool mInitialized;
+	double mTime;
+	double mGameOverTime;
+
+	/**
+	 * Where the command being applied records its events and changed cells
+	 */
+	std::vector<GameEvent>* mEvents;
+	std::vector<int>* mChanged;
+
+	/**
+	 * Cells of the board, row by row; only the first mDim * mDim are used
+	 */
+	CellState mCells[MAX_CELLS];
+};
+
+#endif /* GAMERULES_H_ */
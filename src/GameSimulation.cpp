@@ -0,0 +1,162 @@
+//============================================================================
+// Name        : GameSimulation.cpp
+// Author      : Amrit Dhakal
+// Version     : 1.0
+// Copyright   : © Amrit Dhakal 2015. All right reserved. :D
+// Description : Rules of the game run at a fixed tick, apart from the renderer
+//============================================================================
+
+#include "GameSimulation.h"
+#include "GameConstants.h"
+#include "Profiler.h"
+
+double GameSnapshot::timeAt(std::chrono::steady_clock::time_point now) const {
+	if(!initialized || state == GameRules::LEVEL_COMPLETE){
+		return time;
+	}
+	double since = std::chrono::duration<double>(now - published).count();
+	return time + std::max(0.0, std::min(since, SIMULATION_TICK));
+}
+
+int GameSnapshot::countFlags() const {
+	int count = 0;
+	for(int i = 0; i < cells->size(); i++){
+		if((*cells)[i].flagged){
+			count++;
+		}
+	}
+	return count;
+}
+
+void changedCells(const GameSnapshot &before, const GameSnapshot &after, std::vector<int> &changed){
+	if(before.cells == after.cells){
+		return;
+	}
+	const std::vector<CellState> &a = *before.cells;
+	const std::vector<CellState> &b = *after.cells;
+	for(int i = 0; i < b.size(); i++){
+		//Placing the mines changes hidden cells, which nobody may see
+		if(i >= a.size() || a[i].revealed != b[i].revealed || a[i].flagged != b[i].flagged){
+			changed.push_back(i);
+		}
+	}
+}
+
+GameSimulation::GameSimulation(unsigned int seed)
+	: mRules(seed), mPublishedBoard(0), mTick(0), mAccumulator(0), mRunning(false)
+{
+	publish();
+}
+
+GameSimulation::~GameSimulation(){
+	stop();
+}
+
+void GameSimulation::push(const GameCommand &command){
+	std::lock_guard<std::mutex> lock(mMutex);
+	mCommands.push_back(command);
+}
+
+void GameSimulation::advance(double elapsed){
+	if(mRunning){
+		return;
+	}
+	mAccumulator += elapsed;
+	int ticks = 0;
+	while(mAccumulator >= SIMULATION_TICK && ticks < SIMULATION_MAX_TICKS){
+		tick();
+		mAccumulator -= SIMULATION_TICK;
+		ticks++;
+	}
+	if(ticks == SIMULATION_MAX_TICKS){
+		//Too far behind, the time lost is not caught up
+		mAccumulator = 0;
+	}
+}
+
+void GameSimulation::tick(){
+	PROFILE_SCOPE("GameSimulation::tick");
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		mApplying.assign(mCommands.begin(), mCommands.end());
+		mCommands.clear();
+	}
+	for(int i = 0; i < mApplying.size(); i++){
+		mRules.apply(mApplying[i], mTickEvents, mChanged);
+	}
+	mRules.advanceTime(SIMULATION_TICK);
+	mTick++;
+	publish();
+}
+
+void GameSimulation::start(){
+	if(mRunning){
+		return;
+	}
+	mRunning = true;
+	mThread = std::thread(&GameSimulation::run, this);
+}
+
+void GameSimulation::stop(){
+	if(!mRunning){
+		return;
+	}
+	mRunning = false;
+	mThread.join();
+}
+
+void GameSimulation::run(){
+	PROFILE_THREAD("simulation");
+	std::chrono::steady_clock::duration period = std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+			std::chrono::duration<double>(SIMULATION_TICK));
+	std::chrono::steady_clock::time_point next = std::chrono::steady_clock::now() + period;
+	while(mRunning){
+		std::this_thread::sleep_until(next);
+		tick();
+		next += period;
+		std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+		if(now - next > period * SIMULATION_MAX_TICKS){
+			//Too far behind, the time lost is not caught up
+			next = now;
+		}
+	}
+}
+
+std::shared_ptr<const GameSnapshot> GameSimulation::getSnapshot() const {
+	std::lock_guard<std::mutex> lock(mMutex);
+	return mSnapshot;
+}
+
+void GameSimulation::pollEvents(std::vector<GameEvent> &events){
+	std::lock_guard<std::mutex> lock(mMutex);
+	events.insert(events.end(), mEvents.begin(), mEvents.end());
+	mEvents.clear();
+}
+
+void GameSimulation::publish(){
+	std::shared_ptr<GameSnapshot> snapshot = std::make_shared<GameSnapshot>();
+	snapshot->tick = mTick;
+	snapshot->state = mRules.getState();
+	snapshot->level = mRules.getLevel();
+	snapshot->dim = mRules.getDim();
+	snapshot->score = mRules.getScore();
+	snapshot->moves = mRules.getMoves();
+	snapshot->board = mRules.getBoard();
+	snapshot->initialized = mRules.isInitialized();
+	snapshot->time = mRules.getTime();
+	snapshot->gameOverTime = mRules.getGameOverTime();
+	snapshot->published = std::chrono::steady_clock::now();
+	if(!mChanged.empty() || mRules.getBoard() != mPublishedBoard){
+		//Only copied when the tick changed the board
+		mPublishedCells = std::make_shared<const std::vector<CellState> >(
+				mRules.getCells(), mRules.getCells() + mRules.getNumCells());
+		mPublishedBoard = mRules.getBoard();
+		mChanged.clear();
+	}
+	snapshot->cells = mPublishedCells;
+
+	std::lock_guard<std::mutex> lock(mMutex);
+	mSnapshot = snapshot;
+	mEvents.insert(mEvents.end(), mTickEvents.begin(), mTickEvents.end());
+	mTickEvents.clear();
+}
@@ -0,0 +1,167 @@
+//============================================================================
+// Name        : GameSimulation.h
+// Author      : Amrit Dhakal
+// Version     : 1.0
+// Copyright   : © Amrit Dhakal 2015. All right reserved. :D
+// Description : Rules of the game run at a fixed tick, apart from the renderer
+//============================================================================
+
+#ifndef GAMESIMULATION_H_
+#define GAMESIMULATION_H_
+
+#include "GameRules.h"
+#include <vector>
+#include <deque>
+#include <memory>
+#include <chrono>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <stdint.h>
+
+/**
+ * Immutable state of the game at the end of a tick. The cells are shared by the
+ * snapshots of the ticks which did not change the board.
+ */
+struct GameSnapshot {
+	uint64_t tick;
+	GameRules::State state;
+	int level;
+	int dim;
+	int score;
+	unsigned int moves;
+	/**
+	 * Changes every time a new board is dealt (new level or new game)
+	 */
+	unsigned int board;
+	/**
+	 * Have the mines been placed? The level time runs from the first click
+	 */
+	bool initialized;
+	double time;
+	double gameOverTime;
+	/**
+	 * When the snapshot was published, for interpolating the time
+	 */
+	std::chrono::steady_clock::time_point published;
+	std::shared_ptr<const std::vector<CellState> > cells;
+
+	/**
+	 * timeAt: returns the level time at the given moment, interpolated from the
+	 * time of the snapshot by at most one tick
+	 */
+	double timeAt(std::chrono::steady_clock::time_point now) const;
+
+	/**
+	 * countFlags: returns the number of flagged cells
+	 */
+	int countFlags() const;
+};
+
+/**
+ * changedCells: appends to changed the indices of the cells revealed, flagged or
+ * unflagged between two snapshots of the same board
+ */
+void changedCells(const GameSnapshot &before, const GameSnapshot &after, std::vector<int> &changed);
+
+/**
+ * Class GameSimulation runs the rules of the game (GameRules) for the game. It knows
+ * nothing of the scene, so it runs the same with or without a renderer.
+ *
+ * Commands can be pushed from any thread; they are applied at the next tick, which
+ * is run every SIMULATION_TICK seconds either by advance() or by the simulation's own
+ * thread (start()). After every tick an immutable snapshot is published, which any
+ * thread can hold on to for as long as it likes, and the events of the tick are queued
+ * for pollEvents().
+ */
+class GameSimulation {
+public:
+
+	/**
+	 * Constructor: deals the first board of a game
+	 * 		parameter:
+	 * 			seed: seed of the mines of the game
+	 */
+	GameSimulation(unsigned int seed);
+
+	/**
+	 * Destructor: stops the simulation thread
+	 */
+	virtual ~GameSimulation();
+
+	/**
+	 * push: queues a command for the next tick (any thread)
+	 */
+	void push(const GameCommand &command);
+
+	/**
+	 * advance: runs the ticks due after the elapsed time, at most SIMULATION_MAX_TICKS.
+	 * Does nothing while the simulation thread runs.
+	 * 		parameter:
+	 * 			elapsed: time since the last call (seconds)
+	 */
+	void advance(double elapsed);
+
+	/**
+	 * tick: applies the queued commands, moves the time on by one tick and
+	 * publishes the snapshot (only without the simulation thread)
+	 */
+	void tick();
+
+	/**
+	 * start: runs the ticks on a thread of their own until stop() or the destructor
+	 */
+	void start();
+
+	/**
+	 * stop: stops the simulation thread, if it runs
+	 */
+	void stop();
+
+	/**
+	 * getSnapshot: returns the snapshot of the last tick (any thread)
+	 */
+	std::shared_ptr<const GameSnapshot> getSnapshot() const;
+
+	/**
+	 * pollEvents: appends the events of the ticks since the last call (any thread)
+	 */
+	void pollEvents(std::vector<GameEvent> &events);
+
+private:
+	/**
+	 * publish: makes the state of the tick visible to getSnapshot()
+	 */
+	void publish();
+
+	/**
+	 * run: body of the simulation thread
+	 */
+	void run();
+
+	GameRules mRules;
+	std::vector<int> mChanged;
+	unsigned int mPublishedBoard;
+	uint64_t mTick;
+	double mAccumulator;
+
+	/**
+	 * Events of the tick being run, handed to mEvents when it is published
+	 */
+	std::vector<GameEvent> mTickEvents;
+
+	/**
+	 * Guards the commands, events and snapshot shared with the other threads
+	 */
+	mutable std::mutex mMutex;
+	std::deque<GameCommand> mCommands;
+	std::vector<GameCommand> mApplying;
+	std::vector<GameEvent> mEvents;
+	std::shared_ptr<const GameSnapshot> mSnapshot;
+	std::shared_ptr<const std::vector<CellState> > mPublishedCells;
+
+	std::thread mThread;
+	std::atomic<bool> mRunning;
+};
+
+#endif /* GAMESIMULATION_H_ */
@@ -0,0 +1,282 @@
+//============================================================================
+// Name        : GuiCache.cpp
+// Author      : Amrit Dhakal
+// Version     : 1.0
+// Copyright   : © Amrit Dhakal 2015. All right reserved. :D
+// Description : Glyphs of the GUI fonts rasterised once and kept on disk
+//============================================================================
+
+#include "GuiCache.h"
+#include "Constants.h"
+#include "tinyxml.h"
+
+#include <Ogre.h>
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <vector>
+#include <sys/stat.h>
+
+using namespace std;
+
+//Bumped whenever the files written change, so older caches are not read
+static const uint64_t GUI_CACHE_FORMAT = 1;
+
+//FNV-1a 64 bit parameters
+static const uint64_t FNV_OFFSET = 14695981039346656037ULL;
+static const uint64_t FNV_PRIME = 1099511628211ULL;
+
+GuiCache::GuiCache(const string &dir):
+					mDir(dir)
+{
+	mkdir(mDir.c_str(), 0755);
+	Ogre::ResourceGroupManager &groups = Ogre::ResourceGroupManager::getSingleton();
+	if(!groups.resourceGroupExists(GUI_CACHE_GROUP)){
+		groups.addResourceLocation(mDir, "FileSystem", GUI_CACHE_GROUP);
+		groups.initialiseResourceGroup(GUI_CACHE_GROUP);
+	}
+}
+
+void GuiCache::loadScheme(const string &file){
+	CEGUI::SchemeManager &schemes = CEGUI::SchemeManager::getSingleton();
+	string text;
+	try {
+		text = Ogre::ResourceGroupManager::getSingleton().openResource(file, "Schemes")->getAsString();
+	} catch(Ogre::Exception &e){
+		schemes.createFromFile(file);
+		return;
+	}
+	TiXmlDocument scheme;
+	scheme.Parse(text.c_str());
+	if(scheme.Error() || !scheme.RootElement()){
+		schemes.createFromFile(file);
+		return;
+	}
+
+	//The scheme is keyed by itself and by the key of every font it loads
+	uint64_t key = hash(baseHash(), text);
+	vector<TiXmlElement*> fontElements;
+	vector<uint64_t> fontKeys;
+	vector<string> fontNames;
+	for(TiXmlElement* element = scheme.RootElement()->FirstChildElement("Font"); element;
+			element = element->NextSiblingElement("Font")){
+		string name;
+		const char* fontFile = element->Attribute("filename");
+		uint64_t fontKey = fontFile ? hashFontFile(fontFile, name) : 0;
+		fontElements.push_back(element);
+		fontKeys.push_back(fontKey);
+		fontNames.push_back(name);
+		key = hash(key, toKey(fontKey));
+	}
+
+	string cached = toKey(key) + ".scheme";
+	if(isCached(cached)){
+		try {
+			schemes.createFromFile(cached, GUI_CACHE_GROUP);
+			return;
+		} catch(CEGUI::Exception &e){
+			cerr << "File " << cached << " could not be read, loading " << file << "." << endl;
+		}
+	}
+	schemes.createFromFile(file);
+
+	bool baked = true;
+	for(int i = 0; i < fontElements.size(); i++){
+		CEGUI::FontManager &fonts = CEGUI::FontManager::getSingleton();
+		if(fontNames[i].empty() || !fonts.isDefined(fontNames[i]) || !bake(fonts.get(fontNames[i]), toKey(fontKeys[i]))){
+			baked = false;
+			continue;
+		}
+		fontElements[i]->SetAttribute("filename", (toKey(fontKeys[i]) + ".font").c_str());
+		fontElements[i]->SetAttribute("resourceGroup", GUI_CACHE_GROUP.c_str());
+	}
+	//Written last, so a cached scheme always has its fonts
+	if(baked){
+		scheme.SaveFile((mDir + "/" + cached).c_str());
+	}
+}
+
+void GuiCache::createFreeTypeFont(const string &name, float size, const string &fontFile){
+	ostringstream description;
+	description << name << " " << size;
+	uint64_t key = hashResource(hash(baseHash(), description.str()), fontFile, "Fonts");
+	string cached = toKey(key) + ".font";
+	CEGUI::FontManager &fonts = CEGUI::FontManager::getSingleton();
+	if(isCached(cached)){
+		try {
+			fonts.createFromFile(cached, GUI_CACHE_GROUP);
+			return;
+		} catch(CEGUI::Exception &e){
+			cerr << "File " << cached << " could not be read, rasterising " << fontFile << "." << endl;
+		}
+	}
+	bake(fonts.createFreeTypeFont(name, size, true, fontFile), toKey(key));
+}
+
+bool GuiCache::bake(CEGUI::Font &font, const string &key){
+	struct Glyph {
+		CEGUI::utf32 codepoint;
+		const CEGUI::BitmapImage* image;
+		float advance;
+		int x, y, width, height;
+	};
+
+	//Asking for a glyph makes FreeType rasterise it
+	vector<Glyph> glyphs;
+	for(CEGUI::utf32 codepoint = GUI_CACHE_FIRST_CODEPOINT; codepoint <= GUI_CACHE_LAST_CODEPOINT; codepoint++){
+		const CEGUI::FontGlyph* data = font.getGlyphData(codepoint);
+		const CEGUI::BitmapImage* image = data ? dynamic_cast<const CEGUI::BitmapImage*>(data->getImage()) : 0;
+		if(image){
+			Glyph glyph = {codepoint, image, data->getAdvance(), 0, 0,
+					(int)ceil(image->getImageArea().getWidth()), (int)ceil(image->getImageArea().getHeight())};
+			glyphs.push_back(glyph);
+		}
+	}
+	if(glyphs.empty()){
+		return false;
+	}
+
+	//Rows of glyphs, a pixel apart so filtering does not mix them
+	int x = 0, y = 0, rowHeight = 0;
+	for(int i = 0; i < glyphs.size(); i++){
+		if(x + glyphs[i].width > GUI_CACHE_ATLAS_WIDTH){
+			x = 0;
+			y += rowHeight + 1;
+			rowHeight = 0;
+		}
+		glyphs[i].x = x;
+		glyphs[i].y = y;
+		x += glyphs[i].width + 1;
+		rowHeight = max(rowHeight, glyphs[i].height);
+	}
+	int height = 1;
+	while(height < y + rowHeight){
+		height *= 2;
+	}
+
+	//Glyph pixels are copied from the textures FreeType rendered them to
+	vector<uint32_t> atlas(GUI_CACHE_ATLAS_WIDTH * height, 0);
+	map<const CEGUI::Texture*, vector<uint32_t> > pages;
+	for(int i = 0; i < glyphs.size(); i++){
+		CEGUI::Texture* texture = const_cast<CEGUI::Texture*>(glyphs[i].image->getTexture());
+		int pageWidth = texture->getSize().d_width;
+		vector<uint32_t> &page = pages[texture];
+		if(page.empty()){
+			page.resize(pageWidth * (int)texture->getSize().d_height);
+			texture->blitToMemory(&page[0]);
+		}
+		const CEGUI::Rectf &area = glyphs[i].image->getImageArea();
+		for(int row = 0; row < glyphs[i].height; row++){
+			const uint32_t* source = &page[((int)area.top() + row) * pageWidth + (int)area.left()];
+			copy(source, source + glyphs[i].width, &atlas[(glyphs[i].y + row) * GUI_CACHE_ATLAS_WIDTH + glyphs[i].x]);
+		}
+	}
+
+	string imageFile = key + ".png";
+	try {
+		Ogre::Image image;
+		image.loadDynamicImage((Ogre::uchar*)&atlas[0], GUI_CACHE_ATLAS_WIDTH, height, 1, Ogre::PF_A8R8G8B8);
+		image.save(mDir + "/" + imageFile);
+	} catch(Ogre::Exception &e){
+		cerr << "File " << imageFile << " could not be written." << endl;
+		return false;
+	}
+
+	string imagesetFile = mDir + "/" + key + ".imageset";
+	ofstream imageset(imagesetFile.c_str());
+	if(!imageset.is_open()){
+		cerr << "File " << imagesetFile << " could not be opened." << endl;
+		return false;
+	}
+	imageset << "<?xml version=\"1.0\" ?>" << endl;
+	imageset << "<Imageset version=\"2\" name=\"" << key << "\" imagefile=\"" << imageFile
+			<< "\" resourceGroup=\"" << GUI_CACHE_GROUP << "\" autoScaled=\"false\">" << endl;
+	for(int i = 0; i < glyphs.size(); i++){
+		const CEGUI::Vector2f &offset = glyphs[i].image->getRenderedOffset();
+		imageset << "\t<Image name=\"" << glyphs[i].codepoint << "\" xPos=\"" << glyphs[i].x
+				<< "\" yPos=\"" << glyphs[i].y << "\" width=\"" << glyphs[i].width
+				<< "\" height=\"" << glyphs[i].height << "\" xOffset=\"" << offset.d_x
+				<< "\" yOffset=\"" << offset.d_y << "\" />" << endl;
+	}
+	imageset << "</Imageset>" << endl;
+	imageset.close();
+
+	//The .font is written last, a cached font always has its imageset
+	string fontFile = mDir + "/" + key + ".font";
+	ofstream pixmap(fontFile.c_str());
+	if(!pixmap.is_open()){
+		cerr << "File " << fontFile << " could not be opened." << endl;
+		return false;
+	}
+	pixmap << "<?xml version=\"1.0\" ?>" << endl;
+	pixmap << "<Font version=\"3\" name=\"" << font.getName() << "\" filename=\"" << key
+			<< ".imageset\" resourceGroup=\"" << GUI_CACHE_GROUP << "\" type=\"Pixmap\" autoScaled=\"false\">" << endl;
+	for(int i = 0; i < glyphs.size(); i++){
+		pixmap << "\t<Mapping codepoint=\"" << glyphs[i].codepoint << "\" image=\"" << glyphs[i].codepoint
+				<< "\" horzAdvance=\"" << glyphs[i].advance << "\" />" << endl;
+	}
+	pixmap << "</Font>" << endl;
+	return true;
+}
+
+uint64_t GuiCache::hash(uint64_t seed, const string &bytes){
+	for(int i = 0; i < bytes.size(); i++){
+		seed = (seed ^ (unsigned char)bytes[i]) * FNV_PRIME;
+	}
+	return seed;
+}
+
+uint64_t GuiCache::hashResource(uint64_t seed, const string &file, const string &group){
+	try {
+		return hash(hash(seed, file), Ogre::ResourceGroupManager::getSingleton().openResource(file, group)->getAsString());
+	} catch(Ogre::Exception &e){
+		return hash(seed, file);
+	}
+}
+
+uint64_t GuiCache::hashFontFile(const string &file, string &name){
+	string text;
+	try {
+		text = Ogre::ResourceGroupManager::getSingleton().openResource(file, "Fonts")->getAsString();
+	} catch(Ogre::Exception &e){
+		return hash(baseHash(), file);
+	}
+	uint64_t key = hash(baseHash(), text);
+	TiXmlDocument font;
+	font.Parse(text.c_str());
+	if(font.RootElement()){
+		const char* fontName = font.RootElement()->Attribute("name");
+		const char* fontFile = font.RootElement()->Attribute("filename");
+		name = fontName ? fontName : "";
+		if(fontFile){
+			key = hashResource(key, fontFile, "Fonts");
+		}
+	}
+	return key;
+}
+
+uint64_t GuiCache::baseHash(){
+	//Auto scaled fonts are rasterised for the size of the display
+	const CEGUI::Sizef &display = CEGUI::System::getSingleton().getRenderer()->getDisplaySize();
+	ostringstream base;
+	base << GUI_CACHE_FORMAT << " " << CEGUI_VERSION_MAJOR << "." << CEGUI_VERSION_MINOR << "."
+			<< CEGUI_VERSION_PATCH << " " << display.d_width << "x" << display.d_height;
+	return hash(FNV_OFFSET, base.str());
+}
+
+string GuiCache::toKey(uint64_t hash){
+	ostringstream key;
+	key << hex;
+	key.width(16);
+	key.fill('0');
+	key << hash;
+	return key.str();
+}
+
+bool GuiCache::isCached(const string &file){
+	struct stat info;
+	return stat((mDir + "/" + file).c_str(), &info) == 0;
+}
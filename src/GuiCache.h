@@ -0,0 +1,100 @@
+//============================================================================
+// Name        : GuiCache.h
+// Author      : Amrit Dhakal
+// Version     : 1.0
+// Copyright   : © Amrit Dhakal 2015. All right reserved. :D
+// Description : Glyphs of the GUI fonts rasterised once and kept on disk
+//============================================================================
+
+#ifndef GUICACHE_H_
+#define GUICACHE_H_
+
+#include <CEGUI/CEGUI.h>
+#include <string>
+#include <stdint.h>
+
+/**
+ * Class GuiCache keeps the FreeType fonts of the GUI as pixmap fonts on disk, so
+ * later launches load a prebaked glyph atlas instead of rasterising the TrueType files.
+ *
+ * On the first launch the fonts are created from FreeType as usual, then the glyphs
+ * they rendered are packed into one image per font, written with an imageset and a
+ * pixmap .font file. A scheme is cached as a copy of itself whose fonts point at the
+ * cached ones. Every file is named by a hash of everything it was made from (the
+ * .font, .ttf and scheme files, the display size and the CEGUI version), so a changed
+ * input is rebaked and never read stale.
+ *
+ * The directory is a resource location of its own group, which CEGUI reads from.
+ */
+class GuiCache {
+public:
+
+	/**
+	 * Constructor: creates the directory and its resource group
+	 * 		parameter:
+	 * 			dir: directory the cache is kept in
+	 */
+	GuiCache(const std::string &dir);
+
+	/**
+	 * loadScheme: loads the scheme and its fonts, from the cache if it has them
+	 * 		parameter:
+	 * 			file: scheme file, in the Schemes resource group
+	 */
+	void loadScheme(const std::string &file);
+
+	/**
+	 * createFreeTypeFont: creates an anti aliased font, from the cache if it has it
+	 * 		parameter:
+	 * 			name: name of the font
+	 * 			size: point size
+	 * 			fontFile: TrueType file, in the Fonts resource group
+	 */
+	void createFreeTypeFont(const std::string &name, float size, const std::string &fontFile);
+
+private:
+
+	/**
+	 * bake: writes the glyphs the font has rasterised to the cache
+	 * 		return: true if the font was written
+	 */
+	bool bake(CEGUI::Font &font, const std::string &key);
+
+	/**
+	 * hash: continues an FNV-1a hash with the bytes of the string
+	 */
+	static uint64_t hash(uint64_t seed, const std::string &bytes);
+
+	/**
+	 * hashResource: continues the hash with the contents of a file of a resource group
+	 */
+	static uint64_t hashResource(uint64_t seed, const std::string &file, const std::string &group);
+
+	/**
+	 * hashFontFile: returns the key of the font a .font file describes
+	 * 		parameter:
+	 * 			file: .font file, in the Fonts resource group
+	 * 			name: set to the name of the font
+	 */
+	uint64_t hashFontFile(const std::string &file, std::string &name);
+
+	/**
+	 * baseHash: returns the first part of every key: the cache format, the CEGUI version and the display size
+	 */
+	uint64_t baseHash();
+
+	/**
+	 * toKey: returns the hash as the file name it is cached under
+	 */
+	static std::string toKey(uint64_t hash);
+
+	/**
+	 * isCached: returns true if the file exists in the cache directory
+	 */
+	bool isCached(const std::string &file);
+
+	//Directory of the cache
+	std::string mDir;
+};
+
+#endif /* GUICACHE_H_ */
@@ -0,0 +1,282 @@
+//============================================================================
+// Name        : HeadlessServer.cpp
+// Author      : Amrit Dhakal
+// Version     : 1.0
+// Copyright   : © Amrit Dhakal 2015. All right reserved. :D
+// Description : Game without a window, played over a line-delimited JSON protocol
+//============================================================================
+
+#include "HeadlessServer.h"
+
+#include <iostream>
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <signal.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/epoll.h>
+
+using namespace std;
+
+//Set by the signal handler to stop the server
+static volatile sig_atomic_t stopRequested = 0;
+
+static void requestStop(int){
+	stopRequested = 1;
+}
+
+static bool setNonBlocking(int fd){
+	int flags = fcntl(fd, F_GETFL, 0);
+	return flags >= 0 && fcntl(fd, F_SETFL, flags | O_NONBLOCK) == 0;
+}
+
+HeadlessServer::Session::Session(unsigned int seed):
+					rules(seed),
+					shownBoard(rules.getBoard()),
+					lastCommand(chrono::steady_clock::now()),
+					closing(false)
+{
+}
+
+void HeadlessServer::handleRequest(Session &session, const char *begin, const char *end){
+	GameRequest request;
+	string error;
+	if(!GameProtocol::parseRequest(begin, end, request, error)){
+		GameProtocol::appendError(session.out, request, error.c_str());
+		return;
+	}
+
+	session.events.clear();
+	session.changed.clear();
+	if(request.cmd != "state"){
+		GameCommand command;
+		const char *invalid = GameProtocol::toCommand(request, session.rules.getDim(), command);
+		if(invalid){
+			GameProtocol::appendError(session.out, request, invalid);
+			return;
+		}
+		chrono::steady_clock::time_point now = chrono::steady_clock::now();
+		session.rules.advanceTime(chrono::duration<double>(now - session.lastCommand).count());
+		session.rules.apply(command, session.events, session.changed);
+		session.lastCommand = now;
+	}
+
+	bool newBoard = session.rules.getBoard() != session.shownBoard;
+	GameProtocol::appendResponse(session.out, request, session.rules, newBoard, session.changed, session.events);
+	session.shownBoard = session.rules.getBoard();
+}
+
+void HeadlessServer::handleLines(Session &session){
+	size_t offset = 0;
+	size_t newline;
+	while((newline = session.in.find('\n', offset)) != string::npos){
+		const char *begin = session.in.data() + offset;
+		const char *end = session.in.data() + newline;
+		if(!GameProtocol::isBlank(begin, end)){
+			handleRequest(session, begin, end);
+		}
+		offset = newline + 1;
+	}
+	session.in.erase(0, offset);
+}
+
+HeadlessServer::HeadlessServer(const string &socketPath):
+					m_socketPath(socketPath),
+					m_listenFd(-1),
+					m_epollFd(-1)
+{
+}
+
+HeadlessServer::~HeadlessServer() {
+	while(!m_sessions.empty()){
+		disconnect(m_sessions.begin()->first);
+	}
+	if(m_listenFd >= 0){
+		close(m_listenFd);
+		unlink(m_socketPath.c_str());
+	}
+	if(m_epollFd >= 0){
+		close(m_epollFd);
+	}
+}
+
+bool HeadlessServer::run(){
+	signal(SIGINT, requestStop);
+	signal(SIGTERM, requestStop);
+	signal(SIGPIPE, SIG_IGN);
+	return m_socketPath.empty() ? runStdio() : runSocket();
+}
+
+bool HeadlessServer::runStdio(){
+	Session session(GameProtocol::newSeed());
+	char buffer[64 * 1024];
+	while(!stopRequested){
+		ssize_t received = read(STDIN_FILENO, buffer, sizeof(buffer));
+		if(received < 0 && errno == EINTR){
+			continue;
+		}
+		if(received <= 0){
+			break;
+		}
+		session.in.append(buffer, received);
+		handleLines(session);
+
+		//The responses to everything read are written at once, a pipelining client
+		//gets them in few writes
+		size_t written = 0;
+		while(written < session.out.size()){
+			ssize_t sent = write(STDOUT_FILENO, session.out.data() + written, session.out.size() - written);
+			if(sent < 0){
+				if(errno == EINTR){
+					continue;
+				}
+				return true;
+			}
+			written += sent;
+		}
+		session.out.clear();
+		if(session.in.size() > GameProtocol::MAX_LINE){
+			cerr << "Request line longer than " << GameProtocol::MAX_LINE << " bytes." << endl;
+			return true;
+		}
+	}
+	return true;
+}
+
+bool HeadlessServer::listen(){
+	m_listenFd = socket(AF_UNIX, SOCK_STREAM, 0);
+	if(m_listenFd < 0){
+		cerr << "Headless socket could not be created: " << strerror(errno) << endl;
+		return false;
+	}
+	struct sockaddr_un address;
+	memset(&address, 0, sizeof(address));
+	address.sun_family = AF_UNIX;
+	strncpy(address.sun_path, m_socketPath.c_str(), sizeof(address.sun_path) - 1);
+	unlink(m_socketPath.c_str());
+	if(bind(m_listenFd, (struct sockaddr*)&address, sizeof(address)) != 0
+			|| ::listen(m_listenFd, SOMAXCONN) != 0 || !setNonBlocking(m_listenFd)){
+		cerr << "Headless socket " << m_socketPath << " could not be opened: " << strerror(errno) << endl;
+		return false;
+	}
+	m_epollFd = epoll_create1(0);
+	struct epoll_event event;
+	memset(&event, 0, sizeof(event));
+	event.events = EPOLLIN;
+	event.data.fd = m_listenFd;
+	return m_epollFd >= 0 && epoll_ctl(m_epollFd, EPOLL_CTL_ADD, m_listenFd, &event) == 0;
+}
+
+void HeadlessServer::acceptClients(){
+	int fd;
+	while((fd = accept(m_listenFd, 0, 0)) >= 0){
+		struct epoll_event event;
+		memset(&event, 0, sizeof(event));
+		event.events = EPOLLIN | EPOLLRDHUP;
+		event.data.fd = fd;
+		if(!setNonBlocking(fd) || epoll_ctl(m_epollFd, EPOLL_CTL_ADD, fd, &event) != 0){
+			close(fd);
+			continue;
+		}
+		m_sessions[fd] = new Session(GameProtocol::newSeed());
+	}
+}
+
+void HeadlessServer::disconnect(int fd){
+	epoll_ctl(m_epollFd, EPOLL_CTL_DEL, fd, 0);
+	close(fd);
+	delete m_sessions[fd];
+	m_sessions.erase(fd);
+}
+
+bool HeadlessServer::readClient(int fd, Session &session){
+	char buffer[64 * 1024];
+	ssize_t received;
+	while((received = recv(fd, buffer, sizeof(buffer), 0)) > 0){
+		session.in.append(buffer, received);
+		//Requests sent just before the client closed the connection are still answered
+		handleLines(session);
+		if(session.in.size() > GameProtocol::MAX_LINE){
+			return false;
+		}
+	}
+	if(received < 0 && errno != EAGAIN && errno != EWOULDBLOCK){
+		return false;
+	}
+	//After a half-close the responses are still sent before the connection goes
+	session.closing = received == 0;
+	return flushClient(fd, session);
+}
+
+bool HeadlessServer::flushClient(int fd, Session &session){
+	size_t sentTotal = 0;
+	while(sentTotal < session.out.size()){
+		ssize_t sent = send(fd, session.out.data() + sentTotal, session.out.size() - sentTotal, MSG_NOSIGNAL);
+		if(sent < 0){
+			if(errno != EAGAIN && errno != EWOULDBLOCK){
+				return false;
+			}
+			break;
+		}
+		sentTotal += sent;
+	}
+	session.out.erase(0, sentTotal);
+	if(session.out.size() > GameProtocol::MAX_PENDING_OUTPUT){
+		//The client sends requests without reading the responses
+		return false;
+	}
+	if(session.closing && session.out.empty()){
+		return false;
+	}
+	//Wait for the socket to be writable only while there is something left to send,
+	//and no longer for input once the client has nothing more to send
+	struct epoll_event event;
+	memset(&event, 0, sizeof(event));
+	event.events = (session.closing ? 0 : EPOLLIN | EPOLLRDHUP) | (session.out.empty() ? 0 : EPOLLOUT);
+	event.data.fd = fd;
+	return epoll_ctl(m_epollFd, EPOLL_CTL_MOD, fd, &event) == 0;
+}
+
+bool HeadlessServer::runSocket(){
+	if(!listen()){
+		return false;
+	}
+	cout << "Headless game listening on " << m_socketPath << endl;
+
+	const int MAX_EVENTS = 64;
+	struct epoll_event events[MAX_EVENTS];
+	while(!stopRequested){
+		int count = epoll_wait(m_epollFd, events, MAX_EVENTS, 1000);
+		for(int i = 0; i < count; i++){
+			int fd = events[i].data.fd;
+			if(fd == m_listenFd){
+				acceptClients();
+				continue;
+			}
+			map<int, Session*>::iterator session = m_sessions.find(fd);
+			if(session == m_sessions.end()){
+				continue;
+			}
+			bool alive = !(events[i].events & (EPOLLERR | EPOLLHUP));
+			if(alive && (events[i].events & (EPOLLIN | EPOLLRDHUP))){
+				alive = readClient(fd, *session->second);
+			}
+			if(alive && (events[i].events & EPOLLOUT)){
+				alive = flushClient(fd, *session->second);
+			}
+			if(!alive){
+				disconnect(fd);
+			}
+		}
+	}
+	return true;
+}
+
+int HeadlessServer::main(int argc, char *argv[]){
+	HeadlessServer server(argc > 0 ? argv[0] : "");
+	return server.run() ? 0 : 1;
+}
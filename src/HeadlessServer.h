@@ -0,0 +1,153 @@
+//============================================================================
+// Name        : HeadlessServer.h
+// Author      : Amrit Dhakal
+// Version     : 1.0
+// Copyright   : © Amrit Dhakal 2015. All right reserved. :D
+// Description : Game without a window, played over a line-delimited JSON protocol
+//============================================================================
+
+#ifndef HEADLESSSERVER_H_
+#define HEADLESSSERVER_H_
+
+#include "GameProtocol.h"
+#include <string>
+#include <vector>
+#include <map>
+#include <chrono>
+
+/**
+ * Class HeadlessServer plays the game without a window or a renderer, driven by
+ * bots, tests or remote front ends. It runs the same GameRules as the game, command
+ * by command rather than tick by tick, on stdin/stdout or on a UNIX domain socket
+ * where every connection plays its own game (single threaded epoll loop, as
+ * LeaderboardServer). SessionHost serves many games a connection on every core.
+ *
+ * Run with: MineSweeper --headless [socket]
+ *
+ * Every request is one JSON object on a line, every response one line:
+ * 		{"cmd":"new","seed":7}		new game at level 1, seed optional
+ * 		{"cmd":"reveal","cell":12}	also "flag" and "chord"; a cell is given by
+ * 									"cell" (row * dim + col) or by "row" and "col"
+ * 		{"cmd":"continue"}			deals the next level after "level_complete"
+ * 		{"cmd":"state"}				the whole board
+ * An "id" given with a request is sent back with its response.
+ *
+ * Responses hold the game state and the cells changed since the previous response
+ * as flat pairs of cell and code, the code being 0-8 for a revealed cell (mines
+ * around it), 9 for a revealed mine, 10 for a flag and 11 for a hidden cell:
+ * 		{"id":3,"state":"playing","level":1,"score":12,"moves":2,"time":1.250,"d":[12,1,13,0]}
+ * "dim" is added when a new board was dealt, "ev" lists what happened ("chord_failed",
+ * "level_up", "game_over", "game_completed"). The state response holds the whole board
+ * in "cells", one character per cell: '.' hidden, 'F' flag, '*' mine, '0'-'8'.
+ * Errors are answered with {"id":3,"error":"..."}. A client sending a line longer
+ * than GameProtocol::MAX_LINE, or leaving more than GameProtocol::MAX_PENDING_OUTPUT
+ * of responses unread, is disconnected.
+ */
+class HeadlessServer {
+public:
+
+	/**
+	 * Constructor:
+	 * 		parameter:
+	 * 			socketPath: UNIX domain socket to listen on, empty for stdin/stdout
+	 */
+	HeadlessServer(const std::string &socketPath);
+
+	/**
+	 * Destructor: closes every socket and removes the socket file
+	 */
+	virtual ~HeadlessServer();
+
+	/**
+	 * run: serves requests until the input ends (stdin) or SIGINT or SIGTERM is received
+	 * 		return: false if the socket could not be opened
+	 */
+	bool run();
+
+	/**
+	 * main: parses the command line arguments following --headless and runs the server
+	 * 		return: the exit code of the program
+	 */
+	static int main(int argc, char *argv[]);
+
+	/**
+	 * A game being played, with the board last sent to its player
+	 */
+	struct Session {
+		Session(unsigned int seed);
+
+		GameRules rules;
+		unsigned int shownBoard;
+		std::chrono::steady_clock::time_point lastCommand;
+		std::vector<GameEvent> events;
+		std::vector<int> changed;
+		std::string in;
+		std::string out;
+		bool closing;		//The client is done sending, it is disconnected once out is sent
+	};
+
+	/**
+	 * handleLines: answers every complete request line of the session's input,
+	 * appending the responses to its output
+	 */
+	static void handleLines(Session &session);
+
+	/**
+	 * handleRequest: answers one request line
+	 */
+	static void handleRequest(Session &session, const char *begin, const char *end);
+
+protected:
+
+	/**
+	 * Serves the session on stdin and stdout
+	 */
+	bool runStdio();
+
+	/**
+	 * Serves one session per connection on the socket
+	 */
+	bool runSocket();
+
+	/**
+	 * Opens the listening socket and the epoll instance
+	 */
+	bool listen();
+
+	/**
+	 * Accepts every pending connection
+	 */
+	void acceptClients();
+
+	/**
+	 * Reads everything available from the client and answers its requests
+	 * 		return: false if the client has to be disconnected
+	 */
+	bool readClient(int fd, Session &session);
+
+	/**
+	 * Sends as much of the pending output as the socket accepts
+	 * 		return: false if the client has to be disconnected (a closing client
+	 * 		once everything is sent)
+	 */
+	bool flushClient(int fd, Session &session);
+
+	/**
+	 * Closes the connection to the client
+	 */
+	void disconnect(int fd);
+
+	//Path of the socket, empty for stdin/stdout
+	std::string m_socketPath;
+
+	//Listening socket
+	int m_listenFd;
+
+	//epoll instance
+	int m_epollFd;
+
+	//Sessions by socket
+	std::map<int, Session*> m_sessions;
+};
+
+#endif /* HEADLESSSERVER_H_ */
@@ -19,7 +19,6 @@
 
 using namespace std;
 
-typedef pair<string, int> ScorePair;
 const int HighScores::DEFAULT_NUMBER_OF_SCORES = 10;
 const string HighScores::DEFAULT_TITLE = "High Scores";
 
@@ -27,18 +26,105 @@ const string HighScores::DEFAULT_TITLE = "High Scores";
 HighScores::HighScores():
 					m_title(DEFAULT_TITLE),
 					m_number(DEFAULT_NUMBER_OF_SCORES),
-					m_highestBest(true)
+					m_highestBest(true),
+					m_snapshot(0),
+					m_generation(0),
+					m_readerGeneration(0),
+					m_leaderboard(0)
 {
+	publish();
 }
 
 HighScores::HighScores(string title, int number, bool highestBest):
 					m_title(title),
 					m_number(number),
-					m_highestBest(highestBest)
+					m_highestBest(highestBest),
+					m_snapshot(0),
+					m_generation(0),
+					m_readerGeneration(0),
+					m_leaderboard(0)
 {
+	publish();
 }
 
 HighScores::~HighScores() {
+	for(int i = 0; i < m_retired.size(); i++){
+		delete m_retired[i].second;
+	}
+	delete m_snapshot.load();
+}
+
+void HighScores::publish(){
+	HighScoreSnapshot* snapshot = new HighScoreSnapshot();
+	snapshot->title = m_title;
+	snapshot->number = m_number;
+	snapshot->highestBest = m_highestBest;
+	snapshot->scores = m_scores;
+
+	const HighScoreSnapshot* old = m_snapshot.exchange(snapshot, memory_order_acq_rel);
+	//A reader that sees this generation has also seen the new snapshot
+	unsigned long generation = m_generation.fetch_add(1, memory_order_release) + 1;
+	if(old){
+		lock_guard<mutex> lock(m_retiredMutex);
+		m_retired.push_back(make_pair(generation, old));
+	}
+	reclaimSnapshots();
+}
+
+void HighScores::getScores(int first, int count, vector<ScorePair> &page) const{
+	const vector<ScorePair> &scores = snapshot()->scores;
+	page.clear();
+	for(int i = first; i >= 0 && i < scores.size() && i < first + count; i++){
+		page.push_back(scores[i]);
+	}
+}
+
+void HighScores::submitScore(uint64_t gameId, const string &name, int score){
+	if(m_leaderboard){
+		m_leaderboard->submit(gameId, name, score);
+	}
+}
+
+void HighScores::resetScores(){
+	if(m_leaderboard){
+		m_leaderboard->reset();
+		return;
+	}
+	clearScores();
+}
+
+bool HighScores::syncFromLeaderboard(){
+	vector<LeaderboardEntry> top;
+	if(!m_leaderboard || !m_leaderboard->takeTop(top)){
+		return false;
+	}
+	m_scores.clear();
+	for(int i = 0; i < top.size() && i < m_number; i++){
+		m_scores.push_back(ScorePair(top[i].name, top[i].score));
+	}
+	sortScores();
+	publish();
+	return true;
+}
+
+void HighScores::quiescentState(){
+	m_readerGeneration.store(m_generation.load(memory_order_acquire), memory_order_release);
+	reclaimSnapshots();
+}
+
+void HighScores::reclaimSnapshots(){
+	unsigned long readerGeneration = m_readerGeneration.load(memory_order_acquire);
+	lock_guard<mutex> lock(m_retiredMutex);
+	int kept = 0;
+	for(int i = 0; i < m_retired.size(); i++){
+		if(m_retired[i].first <= readerGeneration){
+			delete m_retired[i].second;
+		}
+		else {
+			m_retired[kept++] = m_retired[i];
+		}
+	}
+	m_retired.resize(kept);
 }
 
 
@@ -57,6 +143,7 @@ bool HighScores::addScore(string name, int score){
 			m_scores.pop_back();
 		m_scores.push_back(ScorePair(name, score));
 		sortScores();
+		publish();
 		return true;
 	}
 	else {
@@ -83,6 +170,7 @@ void HighScores::setNumber(int number) {
 		}
 	}
 	m_number = number;
+	publish();
 }
 
 const string& HighScores::getTitle() const {
@@ -91,6 +179,7 @@ const string& HighScores::getTitle() const {
 
 void HighScores::setTitle(const string& title) {
 	m_title = title;
+	publish();
 }
 
 void HighScores::sortScores(){
@@ -130,6 +219,7 @@ bool HighScores::isHighScore(int score) const{
 
 void HighScores::clearScores() {
 	m_scores.clear();
+	publish();
 }
 
 int HighScores::totalScores(){
@@ -160,6 +250,7 @@ bool HighScores::readFromFile(const string &filename){
 	}
 	in.close();
 	sortScores();
+	publish();
 
 	return true;
 }
@@ -195,8 +286,9 @@ int HighScores::getScore(const int i){
 int HighScores::updateScore(int i, string name, int score){
 	m_scores.erase(m_scores.begin() + i);
 	int scorePlace = getPlace(score);
-	addScore(name, score);
-	sortScores();
+	if(!addScore(name, score)){
+		publish();	//the erased score must disappear from the readers' table as well
+	}
 	return scorePlace;
 }
 
@@ -231,6 +323,7 @@ void HighScores::incrementScores(const int inc){
 	for(int i = 0; i < m_scores.size(); i++){
 		m_scores.at(i).second += inc ;
 	}
+	publish();
 }
 
 void HighScores::print() const{
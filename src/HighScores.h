@@ -14,14 +14,51 @@ using namespace std;
 #include <iostream>
 #include <vector>
 #include <algorithm>
+#include <atomic>
+#include <mutex>
+#include "LeaderboardClient.h"
+#include "ScoreSource.h"
 
-typedef pair<string, int> ScorePair;
+/**
+ * HighScoreSnapshot: an immutable copy of a high score table.
+ * Snapshots are never changed after they are published, so they can be read
+ * from any thread without locking.
+ */
+struct HighScoreSnapshot {
+	//Title of the high scores
+	string title;
+
+	//Maximum number of scores stored
+	int number;
+
+	//Is highest score the best?
+	bool highestBest;
+
+	//Scores sorted from the best to the worst
+	vector<ScorePair> scores;
+
+	/**
+	 * getHighestScore: returns the best score, 0 if there are no scores
+	 */
+	int getHighestScore() const {
+		return scores.empty() ? 0 : scores.front().second;
+	}
+};
 
 /**
  * Class HighScores stores a list of high scores for a game.
  *
+ * Every change to the list publishes a new HighScoreSnapshot (read-copy-update).
+ * Readers call snapshot() and use the returned table without any lock. A snapshot
+ * that has been replaced is freed once the reader thread has called quiescentState(),
+ * so a reader must not keep a snapshot across its calls to quiescentState().
+ * Only one thread may change the list at a time.
+ *
+ * In client mode (see setLeaderboard) the list is a local cache of the table kept
+ * by the leaderboard daemon: scores are submitted asynchronously and the cache is
+ * replaced whenever syncFromLeaderboard() receives a newer table.
  */
-class HighScores {
+class HighScores : public ScoreSource {
 public:
 	//Default values for title and max number of scores
 	static const int DEFAULT_NUMBER_OF_SCORES;
@@ -215,16 +252,86 @@ public:
 	void incrementScores(const int inc);
 
 	/**
-	 * getHighestScore: returns the highest score
-	 * return: highest score if there are any scores, 0 otherwise
+	 * getHighestScore: returns the best score of the current snapshot
+	 * return: best score if there are any scores, 0 otherwise
+	 */
+	int getHighestScore() const {
+		return snapshot()->getHighestScore();
+	}
+
+	/**
+	 * snapshot: returns the most recently published copy of the high scores.
+	 * It can be called from any thread and never blocks.
+	 * 		return: the current snapshot, valid until the next call to quiescentState()
+	 */
+	const HighScoreSnapshot* snapshot() const {
+		return m_snapshot.load(memory_order_acquire);
+	}
+
+	/**
+	 * quiescentState: called by the reader thread when it no longer holds any
+	 * snapshot (e.g. once per frame) so that replaced snapshots can be freed
+	 */
+	void quiescentState();
+
+	/**
+	 * getNumScores: returns the number of scores in the current snapshot
+	 */
+	virtual int getNumScores() const override {
+		return snapshot()->scores.size();
+	}
+
+	/**
+	 * getScores: copies a page of the current snapshot
+	 */
+	virtual void getScores(int first, int count, vector<ScorePair> &page) const override;
+
+	/**
+	 * getVersion: returns the number of snapshots published so far
 	 */
-	int getHighestScore(){
-		if(m_scores.empty()){
-			return 0;
-		}
-		return m_scores.at(0).second;
+	virtual unsigned long getVersion() const override {
+		return m_generation.load(memory_order_acquire);
 	}
 
+	/**
+	 * setLeaderboard: switches the high scores to client mode
+	 * 		parameter:
+	 * 			client: connection to the leaderboard daemon (not owned), 0 to leave client mode
+	 */
+	void setLeaderboard(LeaderboardClient* client){
+		m_leaderboard = client;
+	}
+
+	/**
+	 * isClient: returns true if the high scores are kept by the leaderboard daemon
+	 */
+	bool isClient() const {
+		return m_leaderboard != 0;
+	}
+
+	/**
+	 * submitScore: sends the current score of a game to the leaderboard daemon.
+	 * It returns immediately; the score appears in the list after the next sync.
+	 * 		parameter:
+	 * 			gameId: id of the game, unique across all instances
+	 * 			name: the name of the player
+	 * 			score: the current score of the game
+	 */
+	void submitScore(uint64_t gameId, const string &name, int score);
+
+	/**
+	 * resetScores: removes every score. In client mode the daemon is asked to, and
+	 * the list is only emptied by the sync receiving its table after the reset.
+	 */
+	void resetScores();
+
+	/**
+	 * syncFromLeaderboard: replaces the list with the latest table received from the
+	 * leaderboard daemon, if a new one arrived. Must be called by the writer thread.
+	 * 		return: true if the list changed
+	 */
+	bool syncFromLeaderboard();
+
 protected:
 
 
@@ -244,6 +351,34 @@ protected:
 	 * Sorts the scores based on whether the highest score is the best or the lowest
 	 */
 	void sortScores();
+
+	/**
+	 * Publishes a snapshot of the current scores for the readers
+	 */
+	void publish();
+
+	/**
+	 * Frees the replaced snapshots that the reader can no longer be using
+	 */
+	void reclaimSnapshots();
+
+	//Snapshot read by the readers
+	atomic<const HighScoreSnapshot*> m_snapshot;
+
+	//Number of snapshots published so far
+	atomic<unsigned long> m_generation;
+
+	//Generation seen by the reader the last time it held no snapshot
+	atomic<unsigned long> m_readerGeneration;
+
+	//Replaced snapshots waiting to be freed, with the generation that replaced them
+	vector<pair<unsigned long, const HighScoreSnapshot*> > m_retired;
+
+	//Protects m_retired
+	mutex m_retiredMutex;
+
+	//Connection to the leaderboard daemon in client mode, 0 otherwise
+	LeaderboardClient* m_leaderboard;
 };
 
 
@@ -0,0 +1,208 @@
+//============================================================================
+// Name        : InputThread.cpp
+// Author      : Amrit Dhakal
+// Version     : 1.0
+// Copyright   : © Amrit Dhakal 2015. All right reserved. :D
+// Description : Samples the keyboard and mouse on their own thread
+//============================================================================
+
+#include "InputThread.h"
+#include <chrono>
+
+using namespace std;
+
+InputThread::InputThread(OIS::Keyboard* keyboard, OIS::Mouse* mouse, Ogre::Timer* timer, int pollRate):
+					mKeyboard(keyboard),
+					mMouse(mouse),
+					mTimer(timer),
+					mPollRate(pollRate),
+					mHead(0),
+					mTail(0),
+					mDropped(0),
+					mMoved(false),
+					mWidth(0),
+					mHeight(0),
+					mEventTime(0),
+					mStop(false)
+{
+	mKeyboard->setEventCallback(this);
+	mMouse->setEventCallback(this);
+	mThread = std::thread(&InputThread::run, this);
+}
+
+InputThread::~InputThread(){
+	mStop = true;
+	mThread.join();
+}
+
+void InputThread::dispatch(OIS::KeyListener* keyListener, OIS::MouseListener* mouseListener){
+	unsigned int head = mHead.load(memory_order_relaxed);
+	unsigned int tail = mTail.load(memory_order_acquire);
+
+	InputEvent move;
+	bool moved = false;
+	for(; head != tail; head++){
+		const InputEvent &event = mQueue[head % QUEUE_SIZE];
+		if(event.type == MOUSE_MOVED){
+			if(moved){
+				merge(move, event);
+			}
+			else {
+				move = event;
+				moved = true;
+			}
+			continue;
+		}
+		//The pointer is where it was when the button or key went down
+		if(moved){
+			deliver(move, keyListener, mouseListener);
+			moved = false;
+		}
+		deliver(event, keyListener, mouseListener);
+	}
+	mHead.store(head, memory_order_release);
+
+	if(moved){
+		deliver(move, keyListener, mouseListener);
+	}
+	mEventTime = mTimer->getMicroseconds();
+}
+
+bool InputThread::waitForEvents(unsigned long timeout){
+	unique_lock<mutex> lock(mWaitMutex);
+	return mWake.wait_for(lock, chrono::microseconds(timeout), [this]{ return hasEvents(); });
+}
+
+void InputThread::setWindowSize(int width, int height){
+	mWidth = width;
+	mHeight = height;
+}
+
+bool InputThread::keyPressed(const OIS::KeyEvent &arg){
+	InputEvent event;
+	event.type = KEY_PRESSED;
+	event.time = mTimer->getMicroseconds();
+	event.key = arg.key;
+	event.text = arg.text;
+	push(event);
+	return true;
+}
+
+bool InputThread::keyReleased(const OIS::KeyEvent &arg){
+	InputEvent event;
+	event.type = KEY_RELEASED;
+	event.time = mTimer->getMicroseconds();
+	event.key = arg.key;
+	event.text = arg.text;
+	push(event);
+	return true;
+}
+
+bool InputThread::mouseMoved(const OIS::MouseEvent &arg){
+	InputEvent event;
+	event.type = MOUSE_MOVED;
+	event.time = mTimer->getMicroseconds();
+	event.state = arg.state;
+	if(mMoved){
+		merge(mMove, event);
+	}
+	else {
+		mMove = event;
+		mMoved = true;
+	}
+	return true;
+}
+
+bool InputThread::mousePressed(const OIS::MouseEvent &arg, OIS::MouseButtonID id){
+	InputEvent event;
+	event.type = MOUSE_PRESSED;
+	event.time = mTimer->getMicroseconds();
+	event.button = id;
+	event.state = arg.state;
+	push(event);
+	return true;
+}
+
+bool InputThread::mouseReleased(const OIS::MouseEvent &arg, OIS::MouseButtonID id){
+	InputEvent event;
+	event.type = MOUSE_RELEASED;
+	event.time = mTimer->getMicroseconds();
+	event.button = id;
+	event.state = arg.state;
+	push(event);
+	return true;
+}
+
+void InputThread::run(){
+	chrono::microseconds period(1000000 / mPollRate);
+	chrono::steady_clock::time_point next = chrono::steady_clock::now();
+	while(!mStop){
+		int width = mWidth, height = mHeight;
+		if(width > 0 && height > 0){
+			const OIS::MouseState &state = mMouse->getMouseState();
+			state.width = width;
+			state.height = height;
+		}
+		mKeyboard->capture();
+		mMouse->capture();
+		flushMove();
+
+		next += period;
+		this_thread::sleep_until(next);
+	}
+}
+
+void InputThread::push(const InputEvent &event){
+	flushMove();
+	unsigned int tail = mTail.load(memory_order_relaxed);
+	if(tail - mHead.load(memory_order_acquire) >= QUEUE_SIZE){
+		mDropped.fetch_add(1, memory_order_relaxed);
+		return;
+	}
+	mQueue[tail % QUEUE_SIZE] = event;
+	{
+		//Under the lock, so the event cannot slip in between the check and the wait
+		lock_guard<mutex> lock(mWaitMutex);
+		mTail.store(tail + 1, memory_order_release);
+	}
+	mWake.notify_one();
+}
+
+void InputThread::flushMove(){
+	if(mMoved){
+		mMoved = false;
+		push(mMove);
+	}
+}
+
+void InputThread::deliver(const InputEvent &event, OIS::KeyListener* keyListener, OIS::MouseListener* mouseListener){
+	mEventTime = event.time;
+	switch(event.type){
+	case KEY_PRESSED:
+		keyListener->keyPressed(OIS::KeyEvent(mKeyboard, event.key, event.text));
+		break;
+	case KEY_RELEASED:
+		keyListener->keyReleased(OIS::KeyEvent(mKeyboard, event.key, event.text));
+		break;
+	case MOUSE_MOVED:
+		mouseListener->mouseMoved(OIS::MouseEvent(mMouse, event.state));
+		break;
+	case MOUSE_PRESSED:
+		mouseListener->mousePressed(OIS::MouseEvent(mMouse, event.state), event.button);
+		break;
+	case MOUSE_RELEASED:
+		mouseListener->mouseReleased(OIS::MouseEvent(mMouse, event.state), event.button);
+		break;
+	}
+}
+
+void InputThread::merge(InputEvent &move, const InputEvent &later){
+	move.state.X.abs = later.state.X.abs;
+	move.state.Y.abs = later.state.Y.abs;
+	move.state.Z.abs = later.state.Z.abs;
+	move.state.X.rel += later.state.X.rel;
+	move.state.Y.rel += later.state.Y.rel;
+	move.state.Z.rel += later.state.Z.rel;
+	move.state.buttons = later.state.buttons;
+	move.time = later.time;
+}
@@ -0,0 +1,180 @@
+//============================================================================
+// Name        : InputThread.h
+// Author      : Amrit Dhakal
+// Version     : 1.0
+// Copyright   : © Amrit Dhakal 2015. All right reserved. :D
+// Description : Samples the keyboard and mouse on their own thread
+//============================================================================
+
+#ifndef INPUTTHREAD_H_
+#define INPUTTHREAD_H_
+
+#include <OgreTimer.h>
+#if OGRE_PLATFORM == OGRE_PLATFORM_APPLE
+#  include <OIS/OISKeyboard.h>
+#  include <OIS/OISMouse.h>
+#else
+#  include <OISKeyboard.h>
+#  include <OISMouse.h>
+#endif
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+/**
+ * Class InputThread captures the OIS devices on a worker thread at a fixed rate, so input
+ * is sampled at the same rate whatever the frame rate. The events are timestamped and
+ * passed to the render thread through a single producer, single consumer ring buffer.
+ *
+ * The render thread calls dispatch() once a frame, which hands the events to the
+ * listeners in order. Consecutive mouse moves are merged into one (the relative motions
+ * summed, the last absolute position kept), so a burst of moves costs one mouseMoved a
+ * frame. A move is always delivered before the button or key event following it, so a
+ * click is handled with the pointer where it was when the button went down.
+ *
+ * Once started, the devices must only be touched through this class.
+ */
+class InputThread : public OIS::KeyListener, public OIS::MouseListener {
+public:
+
+	/**
+	 * Constructor: becomes the listener of the devices and starts capturing them
+	 * 		parameter:
+	 * 			keyboard, mouse: buffered devices to capture
+	 * 			timer: timer the events are stamped with
+	 * 			pollRate: captures a second
+	 */
+	InputThread(OIS::Keyboard* keyboard, OIS::Mouse* mouse, Ogre::Timer* timer, int pollRate);
+
+	/**
+	 * Destructor: stops capturing, the devices can be destroyed afterwards
+	 */
+	virtual ~InputThread();
+
+	/**
+	 * dispatch: hands the events captured since the last call to the listeners (render thread)
+	 */
+	void dispatch(OIS::KeyListener* keyListener, OIS::MouseListener* mouseListener);
+
+	/**
+	 * hasEvents: returns true if events are waiting to be dispatched (render thread)
+	 */
+	bool hasEvents() const {
+		return mHead.load(std::memory_order_relaxed) != mTail.load(std::memory_order_acquire);
+	}
+
+	/**
+	 * waitForEvents: waits until an event is queued or the timeout expires (render thread)
+	 * 		parameter:
+	 * 			timeout: longest wait (microseconds)
+	 * 		return: true if events are waiting
+	 */
+	bool waitForEvents(unsigned long timeout);
+
+	/**
+	 * setWindowSize: sets the area the mouse is clipped to
+	 */
+	void setWindowSize(int width, int height);
+
+	/**
+	 * getEventTime: returns when the event being dispatched happened (microseconds of the timer)
+	 */
+	unsigned long getEventTime() const {
+		return mEventTime;
+	}
+
+	/**
+	 * getDroppedEvents: returns the number of events lost because the queue was full
+	 */
+	unsigned long getDroppedEvents() const {
+		return mDropped.load(std::memory_order_relaxed);
+	}
+
+private:
+
+	enum EventType {
+		KEY_PRESSED,
+		KEY_RELEASED,
+		MOUSE_MOVED,
+		MOUSE_PRESSED,
+		MOUSE_RELEASED
+	};
+
+	struct InputEvent {
+		EventType type;
+		unsigned long time;
+		OIS::KeyCode key;
+		unsigned int text;
+		OIS::MouseButtonID button;
+		OIS::MouseState state;
+	};
+
+	//Events the queue holds, a power of two
+	static const unsigned int QUEUE_SIZE = 1024;
+
+	/**
+	 * Listener callbacks, called by capture() on the worker thread
+	 */
+	virtual bool keyPressed(const OIS::KeyEvent &arg);
+	virtual bool keyReleased(const OIS::KeyEvent &arg);
+	virtual bool mouseMoved(const OIS::MouseEvent &arg);
+	virtual bool mousePressed(const OIS::MouseEvent &arg, OIS::MouseButtonID id);
+	virtual bool mouseReleased(const OIS::MouseEvent &arg, OIS::MouseButtonID id);
+
+	/**
+	 * run: captures the devices until stopped (worker thread)
+	 */
+	void run();
+
+	/**
+	 * push: queues an event, the mouse move merged so far first (worker thread)
+	 */
+	void push(const InputEvent &event);
+
+	/**
+	 * flushMove: queues the mouse move merged so far (worker thread)
+	 */
+	void flushMove();
+
+	/**
+	 * deliver: hands one event to the listeners (render thread)
+	 */
+	void deliver(const InputEvent &event, OIS::KeyListener* keyListener, OIS::MouseListener* mouseListener);
+
+	/**
+	 * merge: adds the motion of a later mouse move to an earlier one
+	 */
+	static void merge(InputEvent &move, const InputEvent &later);
+
+	OIS::Keyboard* mKeyboard;
+	OIS::Mouse* mMouse;
+	Ogre::Timer* mTimer;
+	int mPollRate;
+
+	//Ring buffer: the worker writes at mTail, the render thread reads at mHead
+	InputEvent mQueue[QUEUE_SIZE];
+	std::atomic<unsigned int> mHead;
+	std::atomic<unsigned int> mTail;
+	std::atomic<unsigned long> mDropped;
+
+	//Worker thread: moves of the current capture, merged
+	InputEvent mMove;
+	bool mMoved;
+
+	//Window size to clip the mouse to, applied by the worker before capturing
+	std::atomic<int> mWidth;
+	std::atomic<int> mHeight;
+
+	//Wakes the render thread waiting in waitForEvents
+	std::mutex mWaitMutex;
+	std::condition_variable mWake;
+
+	//Render thread: time of the event being dispatched
+	unsigned long mEventTime;
+
+	std::atomic<bool> mStop;
+	std::thread mThread;
+};
+
+#endif /* INPUTTHREAD_H_ */
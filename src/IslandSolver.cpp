@@ -0,0 +1,95 @@
+//============================================================================
+// Name        : IslandSolver.cpp
+// Author      : Amrit Dhakal
+// Version     : 1.0
+// Copyright   : © Amrit Dhakal 2015. All right reserved. :D
+// Description : Solves the simulation islands of a Bullet world on a pool of threads
+//============================================================================
+
+#include "IslandSolver.h"
+#include "Profiler.h"
+#include <algorithm>
+
+using namespace std;
+
+IslandSolver::IslandSolver(int threads):
+					mNumBatches(0),
+					mUnsolved(0)
+{
+	if(threads <= 0){
+		threads = max(1, (int)thread::hardware_concurrency());
+	}
+	for(int i = 0; i < threads; i++){
+		mSolvers.push_back(unique_ptr<btSequentialImpulseConstraintSolver>(new btSequentialImpulseConstraintSolver()));
+	}
+	mExecutor.reset(new WorkStealingExecutor(threads));
+}
+
+IslandSolver::~IslandSolver() {
+	//Stops the workers before their solvers go
+	mExecutor.reset();
+}
+
+void IslandSolver::prepareSolve(int numBodies, int numManifolds){
+	mNumBatches = 0;
+}
+
+btScalar IslandSolver::solveGroup(btCollisionObject** bodies, int numBodies, btPersistentManifold** manifolds, int numManifolds,
+		btTypedConstraint** constraints, int numConstraints, const btContactSolverInfo& info,
+		btIDebugDraw* debugDrawer, btDispatcher* dispatcher){
+	//Bullet reuses its arrays for the next batch as soon as this returns
+	if(mNumBatches == mBatches.size()){
+		mBatches.push_back(unique_ptr<Batch>(new Batch()));
+	}
+	Batch* batch = mBatches[mNumBatches++].get();
+	batch->bodies.resize(numBodies);
+	for(int i = 0; i < numBodies; i++){
+		batch->bodies[i] = bodies[i];
+	}
+	batch->manifolds.resize(numManifolds);
+	for(int i = 0; i < numManifolds; i++){
+		batch->manifolds[i] = manifolds[i];
+	}
+	batch->constraints.resize(numConstraints);
+	for(int i = 0; i < numConstraints; i++){
+		batch->constraints[i] = constraints[i];
+	}
+	batch->info = info;
+	batch->debugDrawer = debugDrawer;
+	batch->dispatcher = dispatcher;
+
+	{
+		lock_guard<mutex> lock(mMutex);
+		mUnsolved++;
+	}
+	mExecutor->submit([this, batch](int worker){ solve(worker, batch); });
+	return 0;
+}
+
+void IslandSolver::solve(int worker, Batch* batch){
+	{
+		PROFILE_SCOPE("IslandSolver::solve");
+		mSolvers[worker]->solveGroup(
+				batch->bodies.size() ? &batch->bodies[0] : 0, batch->bodies.size(),
+				batch->manifolds.size() ? &batch->manifolds[0] : 0, batch->manifolds.size(),
+				batch->constraints.size() ? &batch->constraints[0] : 0, batch->constraints.size(),
+				batch->info, batch->debugDrawer, batch->dispatcher);
+	}
+	lock_guard<mutex> lock(mMutex);
+	if(--mUnsolved == 0){
+		mSolved.notify_one();
+	}
+}
+
+void IslandSolver::allSolved(const btContactSolverInfo& info, btIDebugDraw* debugDrawer){
+	PROFILE_SCOPE("IslandSolver::allSolved");
+	unique_lock<mutex> lock(mMutex);
+	mSolved.wait(lock, [this]{ return mUnsolved == 0; });
+}
+
+void IslandSolver::reset(){
+	//Only called between steps, while no batch is being solved
+	for(int i = 0; i < mSolvers.size(); i++){
+		mSolvers[i]->reset();
+	}
+}
@@ -0,0 +1,99 @@
+//============================================================================
+// Name        : IslandSolver.h
+// Author      : Amrit Dhakal
+// Version     : 1.0
+// Copyright   : © Amrit Dhakal 2015. All right reserved. :D
+// Description : Solves the simulation islands of a Bullet world on a pool of threads
+//============================================================================
+
+#ifndef ISLANDSOLVER_H_
+#define ISLANDSOLVER_H_
+
+#include <btBulletDynamicsCommon.h>
+#include "WorkStealingExecutor.h"
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+
+/**
+ * Class IslandSolver is a constraint solver solving the islands of a world in
+ * parallel. Bullet splits the bodies touching each other into islands, which share
+ * no body and no contact, and hands them to the solver one batch of islands after
+ * the other; each batch is copied and queued on a pool, where every worker has a
+ * btSequentialImpulseConstraintSolver of its own. The step goes on once every batch
+ * is solved (allSolved), so the rest of the step (integration) does not change.
+ *
+ * The bodies of the game over explosion fly apart into many small islands, which
+ * is what lets the solver, the largest part of a step, use every core.
+ *
+ * Installed with world->setConstraintSolver(); the world must not own it.
+ */
+class IslandSolver : public btConstraintSolver {
+public:
+
+	/**
+	 * Constructor: starts the threads
+	 * 		parameter:
+	 * 			threads: number of threads solving islands, 0 for one per core
+	 */
+	IslandSolver(int threads);
+
+	virtual ~IslandSolver();
+
+	virtual void prepareSolve(int numBodies, int numManifolds);
+
+	virtual btScalar solveGroup(btCollisionObject** bodies, int numBodies, btPersistentManifold** manifolds, int numManifolds,
+			btTypedConstraint** constraints, int numConstraints, const btContactSolverInfo& info,
+			btIDebugDraw* debugDrawer, btDispatcher* dispatcher);
+
+	virtual void allSolved(const btContactSolverInfo& info, btIDebugDraw* debugDrawer);
+
+	virtual void reset();
+
+	virtual btConstraintSolverType getSolverType() const {
+		return BT_SEQUENTIAL_IMPULSE_SOLVER;
+	}
+
+	/**
+	 * getNumThreads: returns the number of threads solving islands
+	 */
+	int getNumThreads() const {
+		return mExecutor->getNumWorkers();
+	}
+
+private:
+
+	/**
+	 * Islands handed over by one call of solveGroup
+	 */
+	struct Batch {
+		btAlignedObjectArray<btCollisionObject*> bodies;
+		btAlignedObjectArray<btPersistentManifold*> manifolds;
+		btAlignedObjectArray<btTypedConstraint*> constraints;
+		btContactSolverInfo info;
+		btIDebugDraw* debugDrawer;
+		btDispatcher* dispatcher;
+	};
+
+	/**
+	 * solve: solves a batch on a worker
+	 */
+	void solve(int worker, Batch* batch);
+
+	std::unique_ptr<WorkStealingExecutor> mExecutor;
+
+	//Solver of each worker
+	std::vector<std::unique_ptr<btSequentialImpulseConstraintSolver> > mSolvers;
+
+	//Batches of the current step, kept for the next steps so their arrays are reused
+	std::vector<std::unique_ptr<Batch> > mBatches;
+	int mNumBatches;
+
+	//Batches queued and not solved yet
+	int mUnsolved;
+	std::mutex mMutex;
+	std::condition_variable mSolved;
+};
+
+#endif /* ISLANDSOLVER_H_ */
@@ -0,0 +1,195 @@
+//============================================================================
+// Name        : LeaderboardClient.cpp
+// Author      : Amrit Dhakal
+// Version     : 1.0
+// Copyright   : © Amrit Dhakal 2015. All right reserved. :D
+// Description : Asynchronous connection to the leaderboard daemon
+//============================================================================
+
+#include "LeaderboardClient.h"
+
+#include <chrono>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/time.h>
+
+using namespace std;
+
+LeaderboardClient::LeaderboardClient(const string &socketPath, int number):
+					m_socketPath(socketPath),
+					m_number(number),
+					m_fd(-1),
+					m_connected(false),
+					m_stop(false),
+					m_resetPending(false),
+					m_topChanged(false)
+{
+	m_thread = thread(&LeaderboardClient::run, this);
+}
+
+LeaderboardClient::~LeaderboardClient() {
+	{
+		lock_guard<mutex> lock(m_mutex);
+		m_stop = true;
+	}
+	m_wake.notify_one();
+	m_thread.join();
+	if(m_fd >= 0){
+		close(m_fd);
+	}
+}
+
+void LeaderboardClient::queue(const LeaderboardEntry &entry){
+	for(int i = 0; i < m_pending.size(); i++){
+		if(m_pending[i].gameId == entry.gameId){
+			m_pending[i] = entry;
+			return;
+		}
+	}
+	m_pending.push_back(entry);
+}
+
+void LeaderboardClient::submit(uint64_t gameId, const string &name, int score){
+	LeaderboardEntry entry;
+	entry.gameId = gameId;
+	entry.score = score;
+	entry.name = name;
+	lock_guard<mutex> lock(m_mutex);
+	queue(entry);
+}
+
+void LeaderboardClient::reset(){
+	lock_guard<mutex> lock(m_mutex);
+	m_pending.clear();
+	m_resetPending = true;
+	//A table received before the reset is sent is out of date
+	m_topChanged = false;
+}
+
+bool LeaderboardClient::takeTop(vector<LeaderboardEntry> &entries){
+	lock_guard<mutex> lock(m_mutex);
+	if(!m_topChanged){
+		return false;
+	}
+	entries.swap(m_top);
+	m_topChanged = false;
+	return true;
+}
+
+bool LeaderboardClient::connectSocket(){
+	m_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+	if(m_fd < 0){
+		return false;
+	}
+	struct sockaddr_un address;
+	memset(&address, 0, sizeof(address));
+	address.sun_family = AF_UNIX;
+	strncpy(address.sun_path, m_socketPath.c_str(), sizeof(address.sun_path) - 1);
+	if(connect(m_fd, (struct sockaddr*)&address, sizeof(address)) != 0){
+		close(m_fd);
+		m_fd = -1;
+		return false;
+	}
+	//A daemon that stops answering must not hang the client thread forever
+	struct timeval timeout = {2, 0};
+	setsockopt(m_fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+	setsockopt(m_fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+	m_received.clear();
+	return true;
+}
+
+bool LeaderboardClient::exchange(bool reset, const vector<LeaderboardEntry> &batch){
+	string out;
+	if(reset){
+		LeaderboardProtocol::appendReset(out);
+	}
+	if(!batch.empty()){
+		LeaderboardProtocol::appendEntries(out, LeaderboardProtocol::SUBMIT, batch);
+	}
+	LeaderboardProtocol::appendQueryTop(out, m_number);
+
+	size_t sent = 0;
+	while(sent < out.size()){
+		ssize_t result = send(m_fd, out.data() + sent, out.size() - sent, MSG_NOSIGNAL);
+		if(result <= 0){
+			return false;
+		}
+		sent += result;
+	}
+
+	//Wait for the answer to the table request
+	while(true){
+		size_t offset = 0;
+		uint8_t type;
+		string payload;
+		int result = LeaderboardProtocol::extractMessage(m_received, offset, type, payload);
+		if(result < 0){
+			return false;
+		}
+		if(result == 1){
+			m_received.erase(0, offset);
+			vector<LeaderboardEntry> top;
+			if(type != LeaderboardProtocol::TOP || !LeaderboardProtocol::parseEntries(payload, top)){
+				return false;
+			}
+			lock_guard<mutex> lock(m_mutex);
+			//Tables asked for before a reset still waiting to be sent are out of date
+			if(reset || !m_resetPending){
+				m_top.swap(top);
+				m_topChanged = true;
+			}
+			return true;
+		}
+		char buffer[16 * 1024];
+		ssize_t received = recv(m_fd, buffer, sizeof(buffer), 0);
+		if(received <= 0){
+			return false;
+		}
+		m_received.append(buffer, received);
+	}
+}
+
+void LeaderboardClient::run(){
+	unique_lock<mutex> lock(m_mutex);
+	while(true){
+		int interval = m_fd >= 0 ? SYNC_INTERVAL : RECONNECT_INTERVAL;
+		m_wake.wait_for(lock, chrono::milliseconds(interval), [this]{ return m_stop; });
+		bool stopping = m_stop;
+
+		vector<LeaderboardEntry> batch;
+		batch.swap(m_pending);
+		bool reset = m_resetPending;
+		m_resetPending = false;
+		lock.unlock();
+
+		bool ok = m_fd >= 0 || connectSocket();
+		ok = ok && exchange(reset, batch);
+		if(!ok && m_fd >= 0){
+			close(m_fd);
+			m_fd = -1;
+		}
+		m_connected = ok;
+
+		lock.lock();
+		//Unless the game asked for a reset since, which dropped the scores of the batch
+		if(!ok && !m_resetPending){
+			//Keep the reset and the scores for the next attempt unless the game has sent newer ones
+			m_resetPending = reset;
+			for(int i = 0; i < batch.size(); i++){
+				bool superseded = false;
+				for(int j = 0; j < m_pending.size(); j++){
+					superseded = superseded || m_pending[j].gameId == batch[i].gameId;
+				}
+				if(!superseded){
+					m_pending.push_back(batch[i]);
+				}
+			}
+		}
+		if(stopping){
+			return;
+		}
+	}
+}
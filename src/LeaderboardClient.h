@@ -0,0 +1,145 @@
+//============================================================================
+// Name        : LeaderboardClient.h
+// Author      : Amrit Dhakal
+// Version     : 1.0
+// Copyright   : © Amrit Dhakal 2015. All right reserved. :D
+// Description : Asynchronous connection to the leaderboard daemon
+//============================================================================
+
+#ifndef LEADERBOARDCLIENT_H_
+#define LEADERBOARDCLIENT_H_
+
+#include "LeaderboardProtocol.h"
+#include <string>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <condition_variable>
+
+/**
+ * Class LeaderboardClient talks to the leaderboard daemon on its own thread.
+ * Scores are queued by submit() and sent in batches together with a request for
+ * the current table (pipelined, without waiting in between). The latest table
+ * received is kept until takeTop() collects it. The game thread only ever takes a
+ * short lock, so a slow or missing daemon never stalls a frame. If the daemon is
+ * not running, the client keeps retrying and holds on to the latest score of each game.
+ */
+class LeaderboardClient {
+public:
+	//Time between two exchanges with the daemon (milliseconds)
+	static const int SYNC_INTERVAL = 250;
+
+	//Time between two connection attempts (milliseconds)
+	static const int RECONNECT_INTERVAL = 1000;
+
+	/**
+	 * Constructor: starts the client thread
+	 * 		parameter:
+	 * 			socketPath: path of the daemon's UNIX domain socket
+	 * 			number: number of scores to fetch from the daemon
+	 */
+	LeaderboardClient(const std::string &socketPath, int number);
+
+	/**
+	 * Destructor: sends the queued scores if connected and stops the thread
+	 */
+	virtual ~LeaderboardClient();
+
+	/**
+	 * submit: queues the score of a game. Only the latest score of each game is sent.
+	 * 		parameter:
+	 * 			gameId: id of the game, unique across all instances
+	 * 			name: name of the player
+	 * 			score: current score of the game
+	 */
+	void submit(uint64_t gameId, const std::string &name, int score);
+
+	/**
+	 * reset: asks the daemon to remove every score, dropping the scores not sent yet.
+	 * The next table takeTop() returns is the one after the reset.
+	 */
+	void reset();
+
+	/**
+	 * takeTop: returns the latest table received from the daemon
+	 * 		parameter:
+	 * 			entries: filled with the table, best score first
+	 * 		return:
+	 * 			true: if a new table was received since the last call
+	 * 			false: if nothing new was received (entries is left untouched)
+	 */
+	bool takeTop(std::vector<LeaderboardEntry> &entries);
+
+	/**
+	 * isConnected: returns whether the daemon is currently reachable
+	 */
+	bool isConnected() const {
+		return m_connected.load();
+	}
+
+protected:
+
+	/**
+	 * Body of the client thread
+	 */
+	void run();
+
+	/**
+	 * Connects to the daemon
+	 */
+	bool connectSocket();
+
+	/**
+	 * Sends the reset if asked for, the batch and a table request, then waits for the table
+	 * 		return: false if the connection was lost
+	 */
+	bool exchange(bool reset, const std::vector<LeaderboardEntry> &batch);
+
+	/**
+	 * Queues the entry, replacing the queued score of the same game
+	 * (m_mutex must be held)
+	 */
+	void queue(const LeaderboardEntry &entry);
+
+	//Path of the daemon's socket
+	std::string m_socketPath;
+
+	//Number of scores to fetch
+	int m_number;
+
+	//Socket connected to the daemon, -1 if not connected
+	int m_fd;
+
+	//Bytes received and not yet handled
+	std::string m_received;
+
+	//Is the daemon reachable?
+	std::atomic<bool> m_connected;
+
+	//Protects everything below
+	std::mutex m_mutex;
+
+	//Wakes the client thread up
+	std::condition_variable m_wake;
+
+	//Should the thread stop?
+	bool m_stop;
+
+	//Scores waiting to be sent
+	std::vector<LeaderboardEntry> m_pending;
+
+	//Is a reset waiting to be sent?
+	bool m_resetPending;
+
+	//Latest table received
+	std::vector<LeaderboardEntry> m_top;
+
+	//Has the table changed since takeTop was last called?
+	bool m_topChanged;
+
+	//Client thread
+	std::thread m_thread;
+};
+
+#endif /* LEADERBOARDCLIENT_H_ */
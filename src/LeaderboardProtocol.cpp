@@ -0,0 +1,102 @@
+//============================================================================
+// Name        : LeaderboardProtocol.cpp
+// Author      : Amrit Dhakal
+// Version     : 1.0
+// Copyright   : © Amrit Dhakal 2015. All right reserved. :D
+// Description : Binary messages exchanged with the leaderboard daemon
+//============================================================================
+
+#include "LeaderboardProtocol.h"
+
+#include <string.h>
+
+using namespace std;
+
+template<typename T>
+static void appendValue(string &out, T value){
+	out.append(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+template<typename T>
+static bool readValue(const string &in, size_t &pos, T &value){
+	if(pos + sizeof(T) > in.size()){
+		return false;
+	}
+	memcpy(&value, in.data() + pos, sizeof(T));
+	pos += sizeof(T);
+	return true;
+}
+
+static void appendHeader(string &out, uint32_t length, uint8_t type){
+	appendValue(out, length);
+	appendValue(out, type);
+}
+
+void LeaderboardProtocol::appendEntries(string &out, MessageType type, const vector<LeaderboardEntry> &entries){
+	uint16_t count = entries.size() > 0xFFFF ? 0xFFFF : entries.size();
+	uint32_t length = sizeof(uint16_t);
+	for(int i = 0; i < count; i++){
+		length += sizeof(uint64_t) + sizeof(int32_t) + sizeof(uint8_t) + min<size_t>(entries[i].name.size(), 255);
+	}
+	out.reserve(out.size() + HEADER_SIZE + length);
+	appendHeader(out, length, type);
+	appendValue(out, count);
+	for(int i = 0; i < count; i++){
+		uint8_t nameLength = min<size_t>(entries[i].name.size(), 255);
+		appendValue(out, entries[i].gameId);
+		appendValue(out, entries[i].score);
+		appendValue(out, nameLength);
+		out.append(entries[i].name, 0, nameLength);
+	}
+}
+
+void LeaderboardProtocol::appendQueryTop(string &out, uint16_t count){
+	appendHeader(out, sizeof(uint16_t), QUERY_TOP);
+	appendValue(out, count);
+}
+
+void LeaderboardProtocol::appendReset(string &out){
+	appendHeader(out, 0, RESET);
+}
+
+int LeaderboardProtocol::extractMessage(const string &buffer, size_t &offset, uint8_t &type, string &payload){
+	if(buffer.size() < offset + HEADER_SIZE){
+		return 0;
+	}
+	uint32_t length;
+	memcpy(&length, buffer.data() + offset, sizeof(length));
+	if(length > MAX_PAYLOAD_SIZE){
+		return -1;
+	}
+	if(buffer.size() < offset + HEADER_SIZE + length){
+		return 0;
+	}
+	type = buffer[offset + sizeof(length)];
+	payload.assign(buffer, offset + HEADER_SIZE, length);
+	offset += HEADER_SIZE + length;
+	return 1;
+}
+
+bool LeaderboardProtocol::parseEntries(const string &payload, vector<LeaderboardEntry> &entries){
+	size_t pos = 0;
+	uint16_t count;
+	if(!readValue(payload, pos, count)){
+		return false;
+	}
+	entries.resize(count);
+	for(int i = 0; i < count; i++){
+		uint8_t nameLength;
+		if(!readValue(payload, pos, entries[i].gameId) || !readValue(payload, pos, entries[i].score)
+				|| !readValue(payload, pos, nameLength) || pos + nameLength > payload.size()){
+			return false;
+		}
+		entries[i].name.assign(payload, pos, nameLength);
+		pos += nameLength;
+	}
+	return true;
+}
+
+bool LeaderboardProtocol::parseQueryTop(const string &payload, uint16_t &count){
+	size_t pos = 0;
+	return readValue(payload, pos, count);
+}
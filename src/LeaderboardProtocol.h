@@ -0,0 +1,100 @@
+//============================================================================
+// Name        : LeaderboardProtocol.h
+// Author      : Amrit Dhakal
+// Version     : 1.0
+// Copyright   : © Amrit Dhakal 2015. All right reserved. :D
+// Description : Binary messages exchanged with the leaderboard daemon
+//============================================================================
+
+#ifndef LEADERBOARDPROTOCOL_H_
+#define LEADERBOARDPROTOCOL_H_
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+/**
+ * A score of one game on the leaderboard. The game id lets a game update its
+ * own entry as its score grows instead of adding a new one.
+ */
+struct LeaderboardEntry {
+	uint64_t gameId;
+	int32_t score;
+	std::string name;
+};
+
+/**
+ * Class LeaderboardProtocol encodes and decodes the messages exchanged with the
+ * leaderboard daemon over a UNIX domain socket.
+ *
+ * Every message is framed as:
+ * 		uint32 payload length, uint8 message type, payload
+ * Payloads:
+ * 		SUBMIT: uint16 count, then count entries (uint64 game id, int32 score, uint8 name length, name)
+ * 		QUERY_TOP: uint16 number of entries wanted
+ * 		TOP: same as SUBMIT, best entry first
+ * 		RESET: empty, removes every score of the table
+ * Clients may send any number of messages without waiting for replies; the
+ * daemon answers every QUERY_TOP with a TOP, in order. Messages are handled in the
+ * order they arrive, so the TOP answering a QUERY_TOP sent after a RESET shows the
+ * reset has been done.
+ * Integers are in host byte order since both ends run on the same host.
+ */
+class LeaderboardProtocol {
+public:
+	enum MessageType {
+		SUBMIT = 1,
+		QUERY_TOP = 2,
+		TOP = 3,
+		RESET = 4
+	};
+
+	//Size of the frame header (length and type)
+	static const size_t HEADER_SIZE = 5;
+
+	//Larger messages are considered corrupt
+	static const uint32_t MAX_PAYLOAD_SIZE = 1 << 20;
+
+	/**
+	 * appendEntries: appends a SUBMIT or TOP message to the buffer
+	 */
+	static void appendEntries(std::string &out, MessageType type, const std::vector<LeaderboardEntry> &entries);
+
+	/**
+	 * appendQueryTop: appends a QUERY_TOP message to the buffer
+	 */
+	static void appendQueryTop(std::string &out, uint16_t count);
+
+	/**
+	 * appendReset: appends a RESET message to the buffer
+	 */
+	static void appendReset(std::string &out);
+
+	/**
+	 * extractMessage: reads the next complete message from the buffer
+	 * 		parameter:
+	 * 			buffer: received bytes
+	 * 			offset: position of the next message, moved past the message read
+	 * 			type: the type of the message
+	 * 			payload: the payload of the message
+	 * 		return:
+	 * 			1 if a message was extracted
+	 * 			0 if the buffer does not hold a complete message yet
+	 * 			-1 if the buffer holds a corrupt message
+	 */
+	static int extractMessage(const std::string &buffer, size_t &offset, uint8_t &type, std::string &payload);
+
+	/**
+	 * parseEntries: decodes the payload of a SUBMIT or TOP message
+	 * 		return: false if the payload is corrupt
+	 */
+	static bool parseEntries(const std::string &payload, std::vector<LeaderboardEntry> &entries);
+
+	/**
+	 * parseQueryTop: decodes the payload of a QUERY_TOP message
+	 * 		return: false if the payload is corrupt
+	 */
+	static bool parseQueryTop(const std::string &payload, uint16_t &count);
+};
+
+#endif /* LEADERBOARDPROTOCOL_H_ */
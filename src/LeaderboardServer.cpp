@@ -0,0 +1,275 @@
+//============================================================================
+// Name        : LeaderboardServer.cpp
+// Author      : Amrit Dhakal
+// Version     : 1.0
+// Copyright   : © Amrit Dhakal 2015. All right reserved. :D
+// Description : Leaderboard daemon shared by the games running on one host
+//============================================================================
+
+#include "LeaderboardServer.h"
+#include "HighScores.h"
+
+#include <iostream>
+#include <algorithm>
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/epoll.h>
+
+using namespace std;
+
+//Set by the signal handler to stop the daemon
+static volatile sig_atomic_t stopRequested = 0;
+
+static void requestStop(int){
+	stopRequested = 1;
+}
+
+static bool setNonBlocking(int fd){
+	int flags = fcntl(fd, F_GETFL, 0);
+	return flags >= 0 && fcntl(fd, F_SETFL, flags | O_NONBLOCK) == 0;
+}
+
+static bool isBetter(const LeaderboardEntry &a, const LeaderboardEntry &b){
+	return a.score > b.score;
+}
+
+LeaderboardServer::LeaderboardServer(const string &socketPath, const string &scoresFile, int number):
+					m_socketPath(socketPath),
+					m_scoresFile(scoresFile),
+					m_number(number),
+					m_title(HighScores::DEFAULT_TITLE),
+					m_dirty(false),
+					m_listenFd(-1),
+					m_epollFd(-1)
+{
+}
+
+LeaderboardServer::~LeaderboardServer() {
+	while(!m_clients.empty()){
+		disconnect(m_clients.begin()->first);
+	}
+	if(m_listenFd >= 0){
+		close(m_listenFd);
+		unlink(m_socketPath.c_str());
+	}
+	if(m_epollFd >= 0){
+		close(m_epollFd);
+	}
+}
+
+void LeaderboardServer::load(){
+	HighScores scores(HighScores::DEFAULT_TITLE, m_number, true);
+	if(!scores.readFromFile(m_scoresFile)){
+		return;
+	}
+	m_title = scores.getTitle();
+	m_entries.clear();
+	for(int i = 0; i < scores.totalScores() && i < m_number; i++){
+		LeaderboardEntry entry;
+		//Scores from the file belong to finished games, so they get ids no game uses
+		entry.gameId = i;
+		entry.score = scores.getScore(i);
+		entry.name = scores.getName(i);
+		m_entries.push_back(entry);
+	}
+}
+
+void LeaderboardServer::save(){
+	HighScores scores(m_title, m_number, true);
+	for(int i = 0; i < m_entries.size(); i++){
+		scores.addScore(m_entries[i].name, m_entries[i].score);
+	}
+	scores.writeToFile(m_scoresFile);
+	m_dirty = false;
+}
+
+void LeaderboardServer::submit(const vector<LeaderboardEntry> &entries){
+	for(int i = 0; i < entries.size(); i++){
+		const LeaderboardEntry &entry = entries[i];
+		int j = 0;
+		while(j < m_entries.size() && m_entries[j].gameId != entry.gameId){
+			j++;
+		}
+		if(j < m_entries.size()){
+			m_entries[j] = entry;
+		}
+		else if(m_entries.size() < m_number || entry.score > m_entries.back().score){
+			m_entries.push_back(entry);
+		}
+		else {
+			continue;
+		}
+		stable_sort(m_entries.begin(), m_entries.end(), isBetter);
+		if(m_entries.size() > m_number){
+			m_entries.pop_back();
+		}
+		m_dirty = true;
+	}
+}
+
+bool LeaderboardServer::listen(){
+	m_listenFd = socket(AF_UNIX, SOCK_STREAM, 0);
+	if(m_listenFd < 0){
+		cerr << "Leaderboard socket could not be created: " << strerror(errno) << endl;
+		return false;
+	}
+	struct sockaddr_un address;
+	memset(&address, 0, sizeof(address));
+	address.sun_family = AF_UNIX;
+	strncpy(address.sun_path, m_socketPath.c_str(), sizeof(address.sun_path) - 1);
+	unlink(m_socketPath.c_str());
+	if(bind(m_listenFd, (struct sockaddr*)&address, sizeof(address)) != 0
+			|| ::listen(m_listenFd, SOMAXCONN) != 0 || !setNonBlocking(m_listenFd)){
+		cerr << "Leaderboard socket " << m_socketPath << " could not be opened: " << strerror(errno) << endl;
+		return false;
+	}
+	m_epollFd = epoll_create1(0);
+	struct epoll_event event;
+	memset(&event, 0, sizeof(event));
+	event.events = EPOLLIN;
+	event.data.fd = m_listenFd;
+	return m_epollFd >= 0 && epoll_ctl(m_epollFd, EPOLL_CTL_ADD, m_listenFd, &event) == 0;
+}
+
+void LeaderboardServer::acceptClients(){
+	int fd;
+	while((fd = accept(m_listenFd, 0, 0)) >= 0){
+		struct epoll_event event;
+		memset(&event, 0, sizeof(event));
+		event.events = EPOLLIN | EPOLLRDHUP;
+		event.data.fd = fd;
+		if(!setNonBlocking(fd) || epoll_ctl(m_epollFd, EPOLL_CTL_ADD, fd, &event) != 0){
+			close(fd);
+			continue;
+		}
+		m_clients[fd] = Client();
+	}
+}
+
+void LeaderboardServer::disconnect(int fd){
+	epoll_ctl(m_epollFd, EPOLL_CTL_DEL, fd, 0);
+	close(fd);
+	m_clients.erase(fd);
+}
+
+bool LeaderboardServer::readClient(int fd, Client &client){
+	char buffer[64 * 1024];
+	ssize_t received;
+	while((received = recv(fd, buffer, sizeof(buffer), 0)) > 0){
+		client.in.append(buffer, received);
+	}
+	if(received < 0 && errno != EAGAIN && errno != EWOULDBLOCK){
+		return false;
+	}
+	//Messages sent just before the client closed the connection are still handled,
+	//and the answers sent before it goes
+	client.closing = received == 0;
+
+	//Every complete message received is handled before anything is sent back
+	size_t offset = 0;
+	uint8_t type;
+	string payload;
+	vector<LeaderboardEntry> entries;
+	int result;
+	while((result = LeaderboardProtocol::extractMessage(client.in, offset, type, payload)) == 1){
+		if(type == LeaderboardProtocol::SUBMIT){
+			if(!LeaderboardProtocol::parseEntries(payload, entries)){
+				return false;
+			}
+			submit(entries);
+		}
+		else if(type == LeaderboardProtocol::RESET){
+			m_entries.clear();
+			m_dirty = true;
+		}
+		else if(type == LeaderboardProtocol::QUERY_TOP){
+			uint16_t count;
+			if(!LeaderboardProtocol::parseQueryTop(payload, count)){
+				return false;
+			}
+			vector<LeaderboardEntry> top(m_entries.begin(), m_entries.begin() + min<size_t>(count, m_entries.size()));
+			LeaderboardProtocol::appendEntries(client.out, LeaderboardProtocol::TOP, top);
+		}
+		else {
+			return false;
+		}
+	}
+	client.in.erase(0, offset);
+	return result == 0 && flushClient(fd, client);
+}
+
+bool LeaderboardServer::flushClient(int fd, Client &client){
+	while(!client.out.empty()){
+		ssize_t sent = send(fd, client.out.data(), client.out.size(), MSG_NOSIGNAL);
+		if(sent < 0){
+			if(errno != EAGAIN && errno != EWOULDBLOCK){
+				return false;
+			}
+			break;
+		}
+		client.out.erase(0, sent);
+	}
+	if(client.closing && client.out.empty()){
+		return false;
+	}
+	//Wait for the socket to be writable only while there is something left to send,
+	//and no longer for input once the client has nothing more to send
+	struct epoll_event event;
+	memset(&event, 0, sizeof(event));
+	event.events = (client.closing ? 0 : EPOLLIN | EPOLLRDHUP) | (client.out.empty() ? 0 : EPOLLOUT);
+	event.data.fd = fd;
+	return epoll_ctl(m_epollFd, EPOLL_CTL_MOD, fd, &event) == 0;
+}
+
+bool LeaderboardServer::run(){
+	load();
+	if(!listen()){
+		return false;
+	}
+	signal(SIGINT, requestStop);
+	signal(SIGTERM, requestStop);
+	signal(SIGPIPE, SIG_IGN);
+	cout << "Leaderboard listening on " << m_socketPath << endl;
+
+	const int MAX_EVENTS = 64;
+	struct epoll_event events[MAX_EVENTS];
+	time_t lastSave = time(0);
+	while(!stopRequested){
+		int count = epoll_wait(m_epollFd, events, MAX_EVENTS, 1000);
+		for(int i = 0; i < count; i++){
+			int fd = events[i].data.fd;
+			if(fd == m_listenFd){
+				acceptClients();
+				continue;
+			}
+			map<int, Client>::iterator client = m_clients.find(fd);
+			if(client == m_clients.end()){
+				continue;
+			}
+			bool alive = !(events[i].events & (EPOLLERR | EPOLLHUP));
+			if(alive && (events[i].events & (EPOLLIN | EPOLLRDHUP))){
+				alive = readClient(fd, client->second);
+			}
+			if(alive && (events[i].events & EPOLLOUT)){
+				alive = flushClient(fd, client->second);
+			}
+			if(!alive){
+				disconnect(fd);
+			}
+		}
+		if(m_dirty && time(0) != lastSave){
+			save();
+			lastSave = time(0);
+		}
+	}
+	if(m_dirty){
+		save();
+	}
+	return true;
+}
@@ -0,0 +1,130 @@
+//============================================================================
+// Name        : LeaderboardServer.h
+// Author      : Amrit Dhakal
+// Version     : 1.0
+// Copyright   : © Amrit Dhakal 2015. All right reserved. :D
+// Description : Leaderboard daemon shared by the games running on one host
+//============================================================================
+
+#ifndef LEADERBOARDSERVER_H_
+#define LEADERBOARDSERVER_H_
+
+#include "LeaderboardProtocol.h"
+#include <string>
+#include <vector>
+#include <map>
+
+/**
+ * Class LeaderboardServer keeps the high score table of every game running on
+ * the host and serves it on a UNIX domain socket. It runs a single threaded
+ * epoll loop with non blocking sockets, so a slow client never holds up the others.
+ * The table is written to the high score file (same format as HighScores) at most
+ * once per second while it changes, and when the daemon stops.
+ */
+class LeaderboardServer {
+public:
+
+	/**
+	 * Constructor:
+	 * 		parameter:
+	 * 			socketPath: path of the UNIX domain socket to listen on
+	 * 			scoresFile: file the table is loaded from and saved to
+	 * 			number: maximum number of scores in the table
+	 */
+	LeaderboardServer(const std::string &socketPath, const std::string &scoresFile, int number);
+
+	/**
+	 * Destructor: closes every socket and removes the socket file
+	 */
+	virtual ~LeaderboardServer();
+
+	/**
+	 * run: serves clients until SIGINT or SIGTERM is received
+	 * 		return: false if the socket could not be opened
+	 */
+	bool run();
+
+protected:
+
+	/**
+	 * A connected client with the bytes received and not yet processed
+	 * and the bytes not yet sent
+	 */
+	struct Client {
+		std::string in;
+		std::string out;
+		bool closing = false;		//Done sending, disconnected once out is sent
+	};
+
+	/**
+	 * Opens the listening socket and the epoll instance
+	 */
+	bool listen();
+
+	/**
+	 * Accepts every pending connection
+	 */
+	void acceptClients();
+
+	/**
+	 * Reads everything available from the client and answers its messages
+	 * 		return: false if the client has to be disconnected
+	 */
+	bool readClient(int fd, Client &client);
+
+	/**
+	 * Sends as much of the pending output as the socket accepts
+	 * 		return: false if the client has to be disconnected (a closing client
+	 * 		once everything is sent)
+	 */
+	bool flushClient(int fd, Client &client);
+
+	/**
+	 * Closes the connection to the client
+	 */
+	void disconnect(int fd);
+
+	/**
+	 * Adds the scores to the table, replacing the scores of the same games
+	 */
+	void submit(const std::vector<LeaderboardEntry> &entries);
+
+	/**
+	 * Loads the table from the scores file
+	 */
+	void load();
+
+	/**
+	 * Saves the table to the scores file
+	 */
+	void save();
+
+	//Path of the socket
+	std::string m_socketPath;
+
+	//File holding the table
+	std::string m_scoresFile;
+
+	//Maximum number of scores
+	int m_number;
+
+	//Title of the table
+	std::string m_title;
+
+	//Table, best score first
+	std::vector<LeaderboardEntry> m_entries;
+
+	//Has the table changed since it was saved?
+	bool m_dirty;
+
+	//Listening socket
+	int m_listenFd;
+
+	//epoll instance
+	int m_epollFd;
+
+	//Connected clients by socket
+	std::map<int, Client> m_clients;
+};
+
+#endif /* LEADERBOARDSERVER_H_ */
@@ -0,0 +1,130 @@
+//============================================================================
+// Name        : LeaderboardView.cpp
+// Author      : Amrit Dhakal
+// Version     : 1.0
+// Copyright   : © Amrit Dhakal 2015. All right reserved. :D
+// Description : Virtualized view of a score list in a CEGUI MultiColumnList
+//============================================================================
+
+#include "LeaderboardView.h"
+
+#include <algorithm>
+#include <string>
+
+//Rows alternate between these colours
+static const CEGUI::Colour EVEN_ROW_COLOUR(0xFFFF0000);
+static const CEGUI::Colour ODD_ROW_COLOUR(0xFF00FF00);
+
+static const CEGUI::String ROW_FONT("HighScoreFont-18.font");
+
+/**
+ * Creates an item for the view. Fonts and colours are set directly on the item
+ * so no markup has to be parsed when the text changes.
+ */
+static CEGUI::ListboxTextItem* createItem(){
+	CEGUI::ListboxTextItem* item = new CEGUI::ListboxTextItem("");
+	item->setTextParsingEnabled(false);
+	item->setFont(ROW_FONT);
+	return item;
+}
+
+LeaderboardView::LeaderboardView(CEGUI::MultiColumnList* list, CEGUI::Scrollbar* scrollbar):
+					mList(list),
+					mScrollbar(scrollbar),
+					mSource(0),
+					mFirstRow(0),
+					mVersion(0)
+{
+	mList->resetList();
+	for(int i = 0; i < VISIBLE_ROWS; i++){
+		int rowID = mList->addRow();
+		mRanks.push_back(createItem());
+		mNames.push_back(createItem());
+		mNames.back()->setSelectionBrushImage("GlossySerpentFHD/MultiListSelectionBrush");
+		mScores.push_back(createItem());
+		mList->setItem(mRanks.back(), 0, rowID);
+		mList->setItem(mNames.back(), 1, rowID);
+		mList->setItem(mScores.back(), 2, rowID);
+	}
+	mList->subscribeEvent(CEGUI::Window::EventMouseWheel,
+			CEGUI::Event::Subscriber(&LeaderboardView::mouseWheel, this));
+	mScrollbar->setPageSize(VISIBLE_ROWS);
+	mScrollbar->setStepSize(1);
+	mScrollbar->subscribeEvent(CEGUI::Scrollbar::EventScrollPositionChanged,
+			CEGUI::Event::Subscriber(&LeaderboardView::scrollPositionChanged, this));
+}
+
+LeaderboardView::~LeaderboardView() {
+}
+
+void LeaderboardView::show(const ScoreSource* source){
+	mSource = source;
+	mFirstRow = 0;
+	refresh();
+}
+
+void LeaderboardView::scroll(int rows){
+	if(!mSource){
+		return;
+	}
+	int lastFirstRow = std::max(0, mSource->getNumScores() - VISIBLE_ROWS);
+	int firstRow = std::min(std::max(0, mFirstRow + rows), lastFirstRow);
+	if(firstRow != mFirstRow){
+		mFirstRow = firstRow;
+		refresh();
+	}
+}
+
+void LeaderboardView::update(){
+	if(mSource && mSource->getVersion() != mVersion){
+		refresh();
+	}
+}
+
+void LeaderboardView::refresh(){
+	mPage.clear();
+	int numScores = 0;
+	if(mSource){
+		//Read before the page, a change in between only refreshes once more
+		mVersion = mSource->getVersion();
+		numScores = mSource->getNumScores();
+		//The list may have shrunk below the window
+		mFirstRow = std::min(mFirstRow, std::max(0, numScores - VISIBLE_ROWS));
+		mSource->getScores(mFirstRow, VISIBLE_ROWS, mPage);
+	}
+	for(int i = 0; i < VISIBLE_ROWS; i++){
+		if(i < mPage.size()){
+			int rank = mFirstRow + i;
+			const CEGUI::Colour &colour = rank % 2 == 0 ? EVEN_ROW_COLOUR : ODD_ROW_COLOUR;
+			mRanks[i]->setText(std::to_string(rank + 1));
+			mNames[i]->setText(mPage[i].first);
+			mScores[i]->setText(std::to_string(mPage[i].second));
+			mRanks[i]->setTextColours(colour);
+			mNames[i]->setTextColours(colour);
+			mScores[i]->setTextColours(colour);
+		}
+		else {
+			mRanks[i]->setText("");
+			mNames[i]->setText("");
+			mScores[i]->setText("");
+		}
+	}
+	mList->handleUpdatedItemData();
+	//Size first, the position is clamped to it
+	mScrollbar->setDocumentSize(std::max(numScores, VISIBLE_ROWS));
+	mScrollbar->setScrollPosition(mFirstRow);
+}
+
+bool LeaderboardView::mouseWheel(const CEGUI::EventArgs &e){
+	const CEGUI::MouseEventArgs &args = static_cast<const CEGUI::MouseEventArgs&>(e);
+	//Wheel up shows better scores
+	scroll(args.wheelChange > 0 ? -1 : 1);
+	return true;
+}
+
+bool LeaderboardView::scrollPositionChanged(const CEGUI::EventArgs &e){
+	//Also fired by refresh setting the position, when the row is already shown
+	int firstRow = (int)(mScrollbar->getScrollPosition() + 0.5f);
+	scroll(firstRow - mFirstRow);
+	return true;
+}
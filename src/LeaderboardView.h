@@ -0,0 +1,100 @@
+//============================================================================
+// Name        : LeaderboardView.h
+// Author      : Amrit Dhakal
+// Version     : 1.0
+// Copyright   : © Amrit Dhakal 2015. All right reserved. :D
+// Description : Virtualized view of a score list in a CEGUI MultiColumnList
+//============================================================================
+
+#ifndef LEADERBOARDVIEW_H_
+#define LEADERBOARDVIEW_H_
+
+#include "ScoreSource.h"
+#include <CEGUI/CEGUI.h>
+#include <vector>
+
+/**
+ * Class LeaderboardView shows a window of a ScoreSource in a MultiColumnList with
+ * the columns rank, name and score. The list holds only the visible rows, created
+ * once; scrolling copies the next page from the source into the same items. So
+ * opening or scrolling the view costs the same for 20 scores or 100000 scores.
+ *
+ * Since the list only knows the visible rows, the scrollbar beside it is kept in
+ * rows of the whole source: its document is the number of scores, its page the
+ * visible rows.
+ */
+class LeaderboardView {
+public:
+	//Number of rows shown at once
+	static const int VISIBLE_ROWS = 15;
+
+	/**
+	 * Constructor: creates the rows of the list (the fonts must already exist)
+	 * 		parameter:
+	 * 			list: the list with the rank, name and score columns
+	 * 			scrollbar: the scrollbar beside the list
+	 */
+	LeaderboardView(CEGUI::MultiColumnList* list, CEGUI::Scrollbar* scrollbar);
+
+	virtual ~LeaderboardView();
+
+	/**
+	 * show: shows the source starting with the best score
+	 * 		parameter:
+	 * 			source: the scores to be shown
+	 */
+	void show(const ScoreSource* source);
+
+	/**
+	 * refresh: copies the current page from the source again (e.g. after it changed)
+	 */
+	void refresh();
+
+	/**
+	 * update: refreshes the view if the source changed since it was last copied
+	 * (called once per frame)
+	 */
+	void update();
+
+	/**
+	 * scroll: moves the window by the given number of rows (negative to go up)
+	 */
+	void scroll(int rows);
+
+protected:
+
+	/**
+	 * Scrolls on mouse wheel events over the list
+	 */
+	bool mouseWheel(const CEGUI::EventArgs &e);
+
+	/**
+	 * Scrolls to the row the scrollbar was moved to
+	 */
+	bool scrollPositionChanged(const CEGUI::EventArgs &e);
+
+	//List the rows are shown in
+	CEGUI::MultiColumnList* mList;
+
+	//Scrollbar of the whole source, in rows
+	CEGUI::Scrollbar* mScrollbar;
+
+	//Scores being shown
+	const ScoreSource* mSource;
+
+	//Rank of the score on the first row
+	int mFirstRow;
+
+	//Version of the source the page was copied from
+	unsigned long mVersion;
+
+	//Items of each row (owned by the list)
+	std::vector<CEGUI::ListboxTextItem*> mRanks;
+	std::vector<CEGUI::ListboxTextItem*> mNames;
+	std::vector<CEGUI::ListboxTextItem*> mScores;
+
+	//Page of scores being shown, reused between pages
+	std::vector<ScorePair> mPage;
+};
+
+#endif /* LEADERBOARDVIEW_H_ */
@@ -0,0 +1,59 @@
+//============================================================================
+// Name        : LevelArena.cpp
+// Author      : Amrit Dhakal
+// Version     : 1.0
+// Copyright   : © Amrit Dhakal 2015. All right reserved. :D
+// Description : Bump allocator for the game state of one level
+//============================================================================
+
+#include "LevelArena.h"
+#include <stdint.h>
+
+LevelArena::LevelArena(size_t capacity)
+	: mBlock(new char[capacity]), mCapacity(capacity), mTop(0), mUsed(0), mLevelUsed(0), mPeak(0)
+{
+}
+
+LevelArena::~LevelArena(){
+	for(int i = 0; i < mOverflow.size(); i++){
+		delete[] mOverflow[i];
+	}
+	delete[] mBlock;
+}
+
+void* LevelArena::allocate(size_t size, size_t alignment){
+	uintptr_t base = reinterpret_cast<uintptr_t>(mBlock);
+	size_t start = ((base + mTop + alignment - 1) & ~(uintptr_t)(alignment - 1)) - base;
+	mUsed += size;
+	if(start + size <= mCapacity){
+		mTop = start + size;
+		return mBlock + start;
+	}
+	//Only until the next reset, which makes the block big enough
+	char *block = new char[size + alignment];
+	mOverflow.push_back(block);
+	uintptr_t address = reinterpret_cast<uintptr_t>(block);
+	return block + (((address + alignment - 1) & ~(uintptr_t)(alignment - 1)) - address);
+}
+
+void LevelArena::reset(){
+	if(mUsed == 0){
+		return;
+	}
+	mLevelUsed = mUsed;
+	if(mUsed > mPeak){
+		mPeak = mUsed;
+	}
+	if(!mOverflow.empty()){
+		for(int i = 0; i < mOverflow.size(); i++){
+			delete[] mOverflow[i];
+		}
+		mOverflow.clear();
+		//Room for the padding of the alignment as well
+		delete[] mBlock;
+		mCapacity = mPeak + mPeak / 4;
+		mBlock = new char[mCapacity];
+	}
+	mTop = 0;
+	mUsed = 0;
+}
@@ -0,0 +1,104 @@
+//============================================================================
+// Name        : LevelArena.h
+// Author      : Amrit Dhakal
+// Version     : 1.0
+// Copyright   : © Amrit Dhakal 2015. All right reserved. :D
+// Description : Bump allocator for the game state of one level
+//============================================================================
+
+#ifndef LEVELARENA_H_
+#define LEVELARENA_H_
+
+#include <vector>
+#include <stddef.h>
+
+/**
+ * Class LevelArena hands out the memory of the game state of a level (the cells of
+ * the board) from one block, moving a pointer up. Nothing is freed on its own: the
+ * whole level is given back at once by reset() when the next board is dealt, which
+ * costs nothing however many objects the level made, and leaves no holes behind.
+ *
+ * Objects are never destroyed, so they must not own memory of their own; the scene
+ * nodes of the cells belong to the scene manager and are destroyed before the reset.
+ *
+ * A level needing more than the block gets blocks of its own from the heap, and the
+ * reset after it grows the block to what the level needed.
+ */
+class LevelArena {
+public:
+
+	/**
+	 * Constructor:
+	 * 		parameter:
+	 * 			capacity: size of the block (bytes)
+	 */
+	LevelArena(size_t capacity);
+
+	/**
+	 * Destructor: frees the block, objects still in it are not destroyed
+	 */
+	virtual ~LevelArena();
+
+	/**
+	 * allocate: returns memory for the current level
+	 * 		parameter:
+	 * 			size: bytes needed
+	 * 			alignment: alignment of the memory, a power of 2
+	 */
+	void* allocate(size_t size, size_t alignment);
+
+	/**
+	 * allocate: returns memory for count objects of type T, not constructed
+	 */
+	template<typename T>
+	T* allocate(size_t count){
+		return static_cast<T*>(allocate(sizeof(T) * count, alignof(T)));
+	}
+
+	/**
+	 * reset: gives back everything allocated since the last reset, the level is over
+	 */
+	void reset();
+
+	/**
+	 * getUsed: returns the bytes allocated since the last reset
+	 */
+	size_t getUsed() const {
+		return mUsed;
+	}
+
+	/**
+	 * getLevelUsed: returns the bytes the last level (before the last reset) allocated
+	 */
+	size_t getLevelUsed() const {
+		return mLevelUsed;
+	}
+
+	/**
+	 * getPeak: returns the most bytes a level ever allocated
+	 */
+	size_t getPeak() const {
+		return mPeak;
+	}
+
+	/**
+	 * getCapacity: returns the size of the block
+	 */
+	size_t getCapacity() const {
+		return mCapacity;
+	}
+
+private:
+	char* mBlock;
+	size_t mCapacity;
+	size_t mTop;
+
+	//Blocks of the allocations which did not fit in mBlock
+	std::vector<char*> mOverflow;
+
+	size_t mUsed;
+	size_t mLevelUsed;
+	size_t mPeak;
+};
+
+#endif /* LEVELARENA_H_ */
@@ -0,0 +1,245 @@
+//============================================================================
+// Name        : Metrics.cpp
+// Author      : Amrit Dhakal
+// Version     : 1.0
+// Copyright   : © Amrit Dhakal 2015. All right reserved. :D
+// Description : Gameplay and performance metrics in Prometheus text format
+//============================================================================
+
+#include "Metrics.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+using namespace std;
+
+//How often the HTTP thread checks whether it should stop (milliseconds)
+static const int POLL_INTERVAL = 250;
+
+//Largest HTTP request read
+static const int MAX_REQUEST = 4096;
+
+MetricHistogram::MetricHistogram(const vector<double> &bounds):
+					mBounds(bounds),
+					mBuckets(bounds.size() + 1),
+					mSum(0)
+{
+	for(int i = 0; i < mBuckets.size(); i++){
+		mBuckets[i].store(0);
+	}
+}
+
+void MetricHistogram::observe(double value){
+	int bucket = lower_bound(mBounds.begin(), mBounds.end(), value) - mBounds.begin();
+	mBuckets[bucket].fetch_add(1, memory_order_relaxed);
+	mSum.fetch_add((int64_t)(value * 1e6), memory_order_relaxed);
+}
+
+void MetricHistogram::write(ostream &out, const string &name) const{
+	//Prometheus buckets are cumulative
+	uint64_t count = 0;
+	for(int i = 0; i < mBounds.size(); i++){
+		count += mBuckets[i].load(memory_order_relaxed);
+		out << name << "_bucket{le=\"" << mBounds[i] << "\"} " << count << "\n";
+	}
+	count += mBuckets[mBounds.size()].load(memory_order_relaxed);
+	out << name << "_bucket{le=\"+Inf\"} " << count << "\n";
+	out << name << "_sum " << mSum.load(memory_order_relaxed) / 1e6 << "\n";
+	out << name << "_count " << count << "\n";
+}
+
+Metrics::Metrics():
+					mListenFd(-1),
+					mStop(false)
+{
+}
+
+Metrics::~Metrics(){
+	mStop = true;
+	if(mThread.joinable()){
+		mThread.join();
+	}
+	if(mListenFd >= 0){
+		close(mListenFd);
+	}
+	for(int i = 0; i < mEntries.size(); i++){
+		switch(mEntries[i].type){
+		case COUNTER:
+			delete (MetricCounter*)mEntries[i].metric;
+			break;
+		case GAUGE:
+			delete (MetricGauge*)mEntries[i].metric;
+			break;
+		case HISTOGRAM:
+			delete (MetricHistogram*)mEntries[i].metric;
+			break;
+		}
+	}
+}
+
+Metrics::Entry* Metrics::add(const string &name, const string &help, Type type){
+	Entry entry;
+	entry.name = name;
+	entry.help = help;
+	entry.type = type;
+	entry.metric = 0;
+	mEntries.push_back(entry);
+	return &mEntries.back();
+}
+
+MetricCounter* Metrics::addCounter(const string &name, const string &help){
+	lock_guard<mutex> lock(mMutex);
+	MetricCounter* counter = new MetricCounter();
+	add(name, help, COUNTER)->metric = counter;
+	return counter;
+}
+
+MetricGauge* Metrics::addGauge(const string &name, const string &help){
+	lock_guard<mutex> lock(mMutex);
+	MetricGauge* gauge = new MetricGauge();
+	add(name, help, GAUGE)->metric = gauge;
+	return gauge;
+}
+
+MetricHistogram* Metrics::addHistogram(const string &name, const string &help, const vector<double> &bounds){
+	lock_guard<mutex> lock(mMutex);
+	MetricHistogram* histogram = new MetricHistogram(bounds);
+	add(name, help, HISTOGRAM)->metric = histogram;
+	return histogram;
+}
+
+void Metrics::write(ostream &out) const{
+	lock_guard<mutex> lock(mMutex);
+	for(int i = 0; i < mEntries.size(); i++){
+		const Entry &entry = mEntries[i];
+		out << "# HELP " << entry.name << " " << entry.help << "\n";
+		switch(entry.type){
+		case COUNTER:
+			out << "# TYPE " << entry.name << " counter\n";
+			out << entry.name << " " << ((MetricCounter*)entry.metric)->get() << "\n";
+			break;
+		case GAUGE:
+			out << "# TYPE " << entry.name << " gauge\n";
+			out << entry.name << " " << ((MetricGauge*)entry.metric)->get() << "\n";
+			break;
+		case HISTOGRAM:
+			out << "# TYPE " << entry.name << " histogram\n";
+			((MetricHistogram*)entry.metric)->write(out, entry.name);
+			break;
+		}
+	}
+}
+
+bool Metrics::writeToFile(const string &filename) const{
+	string temporary = filename + ".tmp";
+	ofstream out(temporary.c_str());
+	if(!out.is_open()){
+		cerr << "File " << temporary << " could not be opened." << endl;
+		return false;
+	}
+	write(out);
+	out.close();
+	if(!out || rename(temporary.c_str(), filename.c_str()) != 0){
+		cerr << "File " << filename << " could not be written." << endl;
+		return false;
+	}
+	return true;
+}
+
+bool Metrics::serve(int port){
+	if(mListenFd >= 0){
+		return true;
+	}
+	int fd = socket(AF_INET, SOCK_STREAM, 0);
+	if(fd < 0){
+		cerr << "Metrics endpoint could not be created: " << strerror(errno) << endl;
+		return false;
+	}
+	int reuse = 1;
+	setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+	//Only reachable from the machine itself
+	sockaddr_in address;
+	memset(&address, 0, sizeof(address));
+	address.sin_family = AF_INET;
+	address.sin_port = htons(port);
+	address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	if(bind(fd, (sockaddr*)&address, sizeof(address)) < 0 || listen(fd, 8) < 0){
+		cerr << "Metrics endpoint could not listen on port " << port << ": " << strerror(errno) << endl;
+		close(fd);
+		return false;
+	}
+	mListenFd = fd;
+	mThread = thread(&Metrics::run, this);
+	return true;
+}
+
+void Metrics::run(){
+	pollfd listener;
+	listener.fd = mListenFd;
+	listener.events = POLLIN;
+	while(!mStop){
+		listener.revents = 0;
+		if(poll(&listener, 1, POLL_INTERVAL) <= 0 || !(listener.revents & POLLIN)){
+			continue;
+		}
+		int fd = accept(mListenFd, 0, 0);
+		if(fd < 0){
+			continue;
+		}
+		//A client that never finishes its request cannot hold up the endpoint
+		timeval timeout;
+		timeout.tv_sec = 1;
+		timeout.tv_usec = 0;
+		setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+		setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+		answer(fd);
+		close(fd);
+	}
+}
+
+void Metrics::answer(int fd){
+	string request;
+	char buffer[512];
+	while(request.find("\r\n\r\n") == string::npos && request.size() < MAX_REQUEST){
+		ssize_t received = recv(fd, buffer, sizeof(buffer), 0);
+		if(received <= 0){
+			return;
+		}
+		request.append(buffer, received);
+	}
+
+	ostringstream response;
+	if(request.compare(0, 13, "GET /metrics ") == 0 || request.compare(0, 6, "GET / ") == 0){
+		ostringstream body;
+		write(body);
+		response << "HTTP/1.0 200 OK\r\n"
+				<< "Content-Type: text/plain; version=0.0.4\r\n"
+				<< "Content-Length: " << body.str().size() << "\r\n\r\n"
+				<< body.str();
+	}
+	else {
+		response << "HTTP/1.0 404 Not Found\r\nContent-Length: 0\r\n\r\n";
+	}
+
+	string data = response.str();
+	size_t sent = 0;
+	while(sent < data.size()){
+		ssize_t written = send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+		if(written <= 0){
+			return;
+		}
+		sent += written;
+	}
+}
@@ -0,0 +1,173 @@
+//============================================================================
+// Name        : Metrics.h
+// Author      : Amrit Dhakal
+// Version     : 1.0
+// Copyright   : © Amrit Dhakal 2015. All right reserved. :D
+// Description : Gameplay and performance metrics in Prometheus text format
+//============================================================================
+
+#ifndef METRICS_H_
+#define METRICS_H_
+
+#include <atomic>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <stdint.h>
+
+/**
+ * A value that only goes up
+ */
+class MetricCounter {
+public:
+	MetricCounter(): mValue(0) {}
+
+	void increment(uint64_t amount = 1){
+		mValue.fetch_add(amount, std::memory_order_relaxed);
+	}
+
+	uint64_t get() const {
+		return mValue.load(std::memory_order_relaxed);
+	}
+
+private:
+	std::atomic<uint64_t> mValue;
+};
+
+/**
+ * A value that is set to its current level
+ */
+class MetricGauge {
+public:
+	MetricGauge(): mValue(0) {}
+
+	void set(int64_t value){
+		mValue.store(value, std::memory_order_relaxed);
+	}
+
+	int64_t get() const {
+		return mValue.load(std::memory_order_relaxed);
+	}
+
+private:
+	std::atomic<int64_t> mValue;
+};
+
+/**
+ * Counts observations into buckets with fixed upper bounds
+ */
+class MetricHistogram {
+public:
+	/**
+	 * Constructor:
+	 * 		parameter:
+	 * 			bounds: upper bounds of the buckets, in increasing order
+	 */
+	MetricHistogram(const std::vector<double> &bounds);
+
+	/**
+	 * observe: adds a value to the bucket it falls in
+	 */
+	void observe(double value);
+
+	/**
+	 * write: writes the buckets, sum and count of the histogram under the name
+	 */
+	void write(std::ostream &out, const std::string &name) const;
+
+private:
+	std::vector<double> mBounds;
+
+	//One more bucket than bounds, for the values above the last bound
+	std::vector<std::atomic<uint64_t> > mBuckets;
+
+	//Sum of the observations, in millionths
+	std::atomic<int64_t> mSum;
+};
+
+/**
+ * Class Metrics holds every metric of the game and writes them in the Prometheus
+ * text format, to a file (for node_exporter's textfile collector) or over HTTP
+ * on a localhost port. Metrics are registered at start up; recording is lock free
+ * and can be done from any thread.
+ */
+class Metrics {
+public:
+	Metrics();
+
+	/**
+	 * Destructor: stops serving
+	 */
+	virtual ~Metrics();
+
+	/**
+	 * addCounter, addGauge, addHistogram: registers a metric
+	 * 		parameter:
+	 * 			name: name of the metric (counters should end in _total)
+	 * 			help: one line description
+	 * 		return: the metric, owned by the registry
+	 */
+	MetricCounter* addCounter(const std::string &name, const std::string &help);
+	MetricGauge* addGauge(const std::string &name, const std::string &help);
+	MetricHistogram* addHistogram(const std::string &name, const std::string &help, const std::vector<double> &bounds);
+
+	/**
+	 * write: writes every metric in the Prometheus text format
+	 */
+	void write(std::ostream &out) const;
+
+	/**
+	 * writeToFile: writes every metric to a temporary file then renames it over
+	 * the file, so readers never see half a dump
+	 * 		return: true if the file was written
+	 */
+	bool writeToFile(const std::string &filename) const;
+
+	/**
+	 * serve: answers HTTP GET /metrics on 127.0.0.1 at the port, on its own thread
+	 * 		return: true if the port could be bound
+	 */
+	bool serve(int port);
+
+private:
+	enum Type {
+		COUNTER,
+		GAUGE,
+		HISTOGRAM
+	};
+
+	struct Entry {
+		std::string name;
+		std::string help;
+		Type type;
+		void* metric;
+	};
+
+	/**
+	 * Accepts and answers the HTTP requests until the registry is destroyed
+	 */
+	void run();
+
+	/**
+	 * Answers one HTTP request
+	 */
+	void answer(int fd);
+
+	Entry* add(const std::string &name, const std::string &help, Type type);
+
+	std::vector<Entry> mEntries;
+
+	//Guards mEntries
+	mutable std::mutex mMutex;
+
+	//Listening socket of the HTTP endpoint, -1 if not serving
+	int mListenFd;
+
+	std::thread mThread;
+
+	std::atomic<bool> mStop;
+};
+
+#endif /* METRICS_H_ */
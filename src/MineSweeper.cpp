@@ -12,12 +12,41 @@
 #include "Cell.h"
 #include "tinyxml.h"
 #include "HighScores.h"
+#include "ScoreDistribution.h"
 #include <vector>
-#include <Shapes/OgreBulletCollisionsBoxShape.h>
+#include <algorithm>
+#include <new>
 #include <Shapes/OgreBulletCollisionsSphereShape.h>
+#include <unistd.h>
+#include <string.h>
+#include "LeaderboardServer.h"
+#include "PhysicsBenchmark.h"
+#include "AssetCooker.h"
+#include "HeadlessServer.h"
+#include "SessionHost.h"
+#include "BoardAtlas.h"
+#include "GuiCache.h"
+#include "Profiler.h"
 
 using namespace Ogre;
 
+#ifdef MINESWEEPER_PROFILING
+/**
+ * Takes over the rendering of CEGUI at the end of the overlay queue, where
+ * CEGUI's own listener would draw it, so the time it takes can be recorded
+ */
+class GuiRenderTimer : public Ogre::RenderQueueListener {
+public:
+	virtual void renderQueueEnded(Ogre::uint8 queueGroupId, const Ogre::String& invocation, bool& repeatThisInvocation){
+		if(queueGroupId != Ogre::RENDER_QUEUE_OVERLAY || !invocation.empty()){
+			return;
+		}
+		PROFILE_SCOPE("CEGUI render");
+		CEGUI::System::getSingleton().renderAllGUIContexts();
+	}
+};
+#endif
+
 
 const int MineSweeper::g = 9.81;
 
@@ -50,19 +79,74 @@ MineSweeper::MineSweeper(void)
 	mStop = true;
 	mRaySceneQuery = 0;
 	mCurTime = 0;
-	mCurNumRevealed = 0;
 	mLevel = 1;
 	mScore = 0;
 	mDetector = 0;
+	mDetectorHead = 0;
+	mResourceTicket = 0;
+	mAssetsReady = false;
 	mDim = LEVEL_DIM[mLevel];
 	mGameOverTime = 0;
 	mCameraDirection = Ogre::Vector3::ZERO;
+	m_bounds = PHYSICS_WORLD_BOUNDS;
+	mHighScore = 0;
+	mLeaderboardView = 0;
+	mScoreDistribution = 0;
+	mGameHistory = 0;
+	mLeaderboard = 0;
+	mGameId = 0;
+	mPhysicsSetupIndex = 0;
+	//Started at the first game over, a game that is never lost needs no physics threads
+	mPhysicsStepper = 0;
+	mLevelArena = new LevelArena(LEVEL_ARENA_SIZE);
+	mCells = 0;
+	mNumCells = 0;
+	mDebris = 0;
+	mParticleExplosion = EXPLOSION_PARTICLES_DEFAULT;
+	mExplodingParticles = false;
+	mMetrics = 0;
+	mMetricsPort = 0;
+	mArenaLoader = 0;
+	mMetricsTime = 0;
+	mClickTime = 0;
+	mClickTick = 0;
+#ifdef MINESWEEPER_PROFILING
+	mProfilerPanel = false;
+	mGuiRenderTimer = 0;
+#endif
+	mSeed = 0;
+	mMoves = 0;
+	mSimulation = 0;
 
 }
 //---------------------------------------------------------------------------
 MineSweeper::~MineSweeper(void)
 {
-
+	delete mSimulation;
+	delete mPhysicsStepper;
+	delete mLevelArena;
+	delete mDebris;
+	delete mArenaLoader;
+	if(mMetrics){
+		mMetrics->writeToFile(METRICS_FILE);
+	}
+	delete mMetrics;
+#ifdef MINESWEEPER_PROFILING
+	if(mGuiRenderTimer){
+		mSceneMgr->removeRenderQueueListener(mGuiRenderTimer);
+		delete mGuiRenderTimer;
+	}
+#endif
+	delete mScoreDistribution;
+	delete mGameHistory;
+	delete mLeaderboardView;
+	delete mHighScore;
+	delete mLeaderboard;
+	//The cache is the only owner of the shapes, the bodies merely point to them
+	for(std::map<ShapeKey, btBoxShape*>::iterator it = mShapeCache.begin();
+			it != mShapeCache.end(); ++it){
+		delete it->second;
+	}
 }
 //-------------------------------------------------------------------------------------
 void MineSweeper::showButtons(bool val){
@@ -81,31 +165,7 @@ bool MineSweeper::quit(const CEGUI::EventArgs &e)
 //-------------------------------------------------------------------------------------
 bool MineSweeper::showHighScores(const CEGUI::EventArgs &e)
 {
-	mScoreBox->resetList();
-	for(int i = 0; i < mHighScore->totalScores(); i++) {
-		CEGUI::String name;
-		CEGUI::String score;
-		CEGUI::String rank;
-		if(i % 2 == 0){
-			rank = "[font='HighScoreFont-18.font'][colour='FFFF0000']" + std::to_string(i+1);
-			name = "[font='HighScoreFont-18.font'][colour='FFFF0000']" + mHighScore->getName(i);
-			score = "[font='HighScoreFont-18.font'][colour='FFFF0000']" + std::to_string(mHighScore->getScore(i));
-		}
-		else{
-			rank = "[font='HighScoreFont-18.font'][colour='FF00FF00']" + std::to_string(i+1);
-			name = "[font='HighScoreFont-18.font'][colour='FF00FF00']" + mHighScore->getName(i);
-			score = "[font='HighScoreFont-18.font'][colour='FF00FF00']" + std::to_string(mHighScore->getScore(i));
-		}
-		int rowID = mScoreBox->addRow();	//Create new row and get row id
-		CEGUI::ListboxTextItem* pRank= new CEGUI::ListboxTextItem(rank);
-		CEGUI::ListboxTextItem* pName= new CEGUI::ListboxTextItem(name);
-		pName->setSelectionBrushImage("GlossySerpentFHD/MultiListSelectionBrush");
-		CEGUI::ListboxTextItem* pScore= new CEGUI::ListboxTextItem(score);
-		// Add row to all the columns using row id received above
-		mScoreBox->setItem(pRank, 0, rowID);
-		mScoreBox->setItem(pName, 1, rowID);
-		mScoreBox->setItem(pScore, 2, rowID);
-	}
+	mLeaderboardView->show(mHighScore);
 	mGuiRoot->getChild("MessageLabel")->setVisible(false);
 	mGuiRoot->getChild("ScoreWindow")->setVisible(true);
 	return true;
@@ -113,13 +173,16 @@ bool MineSweeper::showHighScores(const CEGUI::EventArgs &e)
 //-------------------------------------------------------------------------------------
 bool MineSweeper::resetHighScores(const CEGUI::EventArgs &e)
 {
-	mScoreBox->resetList();
-	mHighScore->clearScores();
-	mHighScore->writeToFile(HIGHSCORE_FILE);
+	//In client mode the file belongs to the daemon, and the list is cleared once it has reset
+	mHighScore->resetScores();
+	if(!mHighScore->isClient()){
+		mHighScore->writeToFile(HIGHSCORE_FILE);
+	}
 	mScorePosition = -1;
 	if(mScore != 0){
 		updateHighScores();
 	}
+	mLeaderboardView->show(mHighScore);
 	return true;
 }
 //-------------------------------------------------------------------------------------
@@ -137,17 +200,16 @@ bool MineSweeper::restart(const CEGUI::EventArgs &e)
 		mGameOverTime = 0;
 		mCurTime = 0;
 		mLevel =1;
-		mDim = LEVEL_DIM[mLevel];
 		mGuiRoot->getChild("GameOverWindow")->setVisible(false);
 		showButtons(false);
 		mStop = true;
 		mPause = true;
+		//The new board is created when the simulation has dealt it
 		clearCells();
-		createField();
-		mInitialized = false;
 		mScore = 0;
-		mCurNumRevealed = 0;
 		mScorePosition = -1;
+		newGameSeed();
+		mSimulation->push(GameCommand::newGame(mSeed));
 		mGuiRoot->getChild("LevelUpWindow")->setVisible(false);
 		mGuiRoot->getChild("ScoreValue")->setText(CEGUI::String(std::to_string(mScore)));
 		mGuiRoot->getChild("LevelValue")->setText(std::to_string(mLevel));
@@ -188,6 +250,10 @@ bool MineSweeper::nameEntered(const CEGUI::EventArgs& e) {
 
 //-------------------------------------------------------------------------------------
 void MineSweeper::updateHighScores(){
+	if(mHighScore->isClient()){
+		mHighScore->submitScore(mGameId, mPlayerName.c_str(), mScore);
+		return;
+	}
 	if(mScorePosition == -1){
 		int scorePos = mHighScore->getPlace(mScore);
 		if(scorePos != -1){
@@ -203,75 +269,76 @@ void MineSweeper::updateHighScores(){
 }
 //-------------------------------------------------------------------------------------
 void MineSweeper::clearCells(){
-	for(int i = 0; i < mBodies.size(); i++){
-		delete mBodies[i];
+	if(mPhysicsStepper){
+		mPhysicsStepper->wait();
 	}
-
 	for(int i = 0; i < mBodies.size(); i++){
-		mBodies.erase(mBodies.begin());
+		mWorld->getBulletDynamicsWorld()->removeRigidBody(mBodies[i]);
 	}
-	mBodies.clear();
-
-	for(int i = 0; i < mShapes.size(); i++){
-		delete mShapes[i];
-
+	//The shapes stay in mShapeCache for the next game
+	deleteBodies(mBodies);
+	deleteBodies(mCulledBodies);
+	mBodyNodes.clear();
+	mBodyStates.clear();
+	mDebris->clear();
+
+	for(int i = 0; i < mNumCells; i++){
+		mCells[i].removeFromScene();
 	}
-	for(int i = 0; i < mShapes.size(); i++){
-		mShapes.erase(mShapes.begin());
-	}
-
-
-	mShapes.clear();
-
-	for(int i = 0; i < mCells.size(); i++){
-		mCells[i]->removeFromScene();
-	}
-
-	for(int i = 0; i < mCells.size(); i++){
-		mCells.erase(mCells.begin());
-	}
-	mCells.clear();
-
+	mCells = 0;
+	mNumCells = 0;
+	//The cells are in the arena, with nothing of their own left to free
+	mLevelArena->reset();
 }
 
-int MineSweeper::countFlags(){
-	int count = 0;
-	for(int i = 0; i < mCells.size(); ++i){
-		if(mCells[i]->isFlagged()){
-			++count;
-		}
+bool MineSweeper::frameRenderingQueued(const Ogre::FrameEvent& evt) {
+#ifdef MINESWEEPER_PROFILING
+	std::string trace = Profiler::frame();
+	if(!trace.empty()){
+		std::cout << "Slow frame, trace written to " << trace << std::endl;
 	}
-	return count;
-}
-
-int MineSweeper::getNumRevealed(int prevReveal){
-	int count = 0;
-	for(int i = 0; i < mCells.size(); ++i){
-		if(mCells[i]->isRevelead()){
-			++count;
-		}
+	PROFILE_SCOPE("frameRenderingQueued");
+	if(!mProfilerPanel){
+		mTrayMgr->hideAll();
 	}
-	return count - prevReveal;
-}
-
-bool MineSweeper::frameRenderingQueued(const Ogre::FrameEvent& evt) {
+#else
 	mTrayMgr->hideAll();
+#endif
+	//No high score snapshot is held between frames
+	mHighScore->syncFromLeaderboard();
+	mLeaderboardView->update();
+	mHighScore->quiescentState();
 	updateGUI();
+	if(mArenaLoader && !mArenaLoader->isFinished()){
+		mArenaLoader->update(DOTSCENE_COMMANDS_PER_FRAME);
+	}
 	mTimeSinceLastFrame = evt.timeSinceLastFrame;
 	mCamera->setPosition(mCamera->getPosition() + CAMERA_SPEED*evt.timeSinceLastFrame*mCameraDirection);
-	if(mInitialized){
-		mCurTime += evt.timeSinceLastFrame;
-	}
+	updateSimulation(evt.timeSinceLastFrame);
 	bool result = BaseApplication::frameRenderingQueued(evt);
+	//The time before a frame drawn at the idle rate was spent waiting, not drawing
+	if(!mIdleFrame){
+		mFrameTimeMetric->observe(evt.timeSinceLastFrame);
+	}
+	updateMetrics(evt.timeSinceLastFrame);
+#ifdef MINESWEEPER_PROFILING
+	if(mProfilerPanel){
+		updateProfilerPanel();
+	}
+#endif
 
 	if(mGameOver && ((mCurTime - mGameOverTime ) > 2)){
 		mGuiRoot->getChild("GameOverWindow")->getChild("GameOverPrompt")->setText(
-				"         Game Over !!! You clicked on a mine."  );
+				"         Game Over !!! You clicked on a mine. " + mGameOverRank);
 		mGuiRoot->getChild("MessageLabel")->setText(
 				"         Game Over !!! You clicked on a mine.");
 		mGuiRoot->getChild("GameOverWindow")->setVisible(true);
-		setupPhysicsObjects();
-		mWorld->stepSimulation(evt.timeSinceLastFrame);
+		if(mExplodingParticles){
+			stepDebris(evt.timeSinceLastFrame);
+		}
+		else {
+			stepPhysics(evt.timeSinceLastFrame);
+		}
 	}
 	return result;
 }
@@ -279,179 +346,254 @@ bool MineSweeper::frameRenderingQueued(const Ogre::FrameEvent& evt) {
 
 
 
-int getIndex(int dim, int r, int c){
-	return dim*c + r;
+bool MineSweeper::frameEnded(const Ogre::FrameEvent& evt) {
+	//The frame showing the result of the click has been handed to the GPU, the click
+	//is applied by the first tick after the one shown when it happened
+	if(mClickTime != 0 && mSnapshot->tick > mClickTick){
+		mClickLatencyMetric->observe((mRoot->getTimer()->getMicroseconds() - mClickTime) / 1e6);
+		mClickTime = 0;
+	}
+	return true;
 }
 
-void MineSweeper::revealAll(){
-	for (int i = 0; i < mCells.size(); ++i){
-		if(mCells[i]->isMine()){
-			mCells[i]->reveal(false, false);
+bool MineSweeper::isAnimating(void){
+	if(BaseApplication::isAnimating() || mCameraDirection != Ogre::Vector3::ZERO){
+		return true;
+	}
+	//Meshes and the arena appear as they load
+	if(!mAssetsReady || (mArenaLoader && !mArenaLoader->isFinished())){
+		return true;
+	}
+	//The game over window shows up after a delay, then the board explodes
+	if(mGameOver){
+		bool exploded = mPhysicsInitialized && (mExplodingParticles ? mDebris->getNumParticles() == 0 : mExplosionAtRest);
+		if(!exploded){
+			return true;
 		}
 	}
+	//The board changed, or the simulation's time only runs while frames are drawn
+	std::shared_ptr<const GameSnapshot> snapshot = mSimulation->getSnapshot();
+	if(snapshot->cells != mSnapshot->cells || snapshot->state != mSnapshot->state){
+		return true;
+	}
+	return !SIMULATION_ON_WORKER_THREAD && snapshot->initialized;
+}
 
-
+/**
+ * Counts the node and all of its descendants
+ */
+static int countNodes(Ogre::Node* node){
+	int count = 1;
+	Ogre::Node::ChildNodeIterator it = node->getChildIterator();
+	while(it.hasMoreElements()){
+		count += countNodes(it.getNext());
+	}
+	return count;
 }
 
-void MineSweeper::setupPhysicsObjects(){
+void MineSweeper::setupMetrics(){
+	mMetrics = new Metrics();
+	mClicksMetric = mMetrics->addCounter("minesweeper_clicks_total", "Clicks on a cell");
+	mRevealsMetric = mMetrics->addCounter("minesweeper_reveals_total", "Cells revealed by the player");
+	mFloodsMetric = mMetrics->addCounter("minesweeper_floods_total", "Clicks that revealed more than one cell");
+	mFloodCellsMetric = mMetrics->addCounter("minesweeper_flood_cells_total", "Cells revealed by floods");
+	mChordsMetric = mMetrics->addCounter("minesweeper_chords_total", "Chords that revealed the neighbours of a cell");
+	mFlagsMetric = mMetrics->addCounter("minesweeper_flags_total", "Flags placed or removed");
+	mLevelUpsMetric = mMetrics->addCounter("minesweeper_level_ups_total", "Levels completed");
+	mGameOversMetric = mMetrics->addCounter("minesweeper_game_overs_total", "Games lost on a mine");
+
+	std::vector<double> latencyBounds = {0.005, 0.01, 0.02, 0.035, 0.05, 0.075, 0.1, 0.25, 0.5, 1};
+	mClickLatencyMetric = mMetrics->addHistogram("minesweeper_click_latency_seconds",
+			"Time from a click to the end of the frame showing its result", latencyBounds);
+	std::vector<double> frameBounds = {0.004, 0.008, 0.0167, 0.025, 0.0334, 0.05, 0.1, 0.25, 1};
+	mFrameTimeMetric = mMetrics->addHistogram("minesweeper_frame_seconds", "Time between two frames", frameBounds);
+
+	mSceneNodesMetric = mMetrics->addGauge("minesweeper_scene_nodes", "Scene nodes in the scene graph");
+	mEntitiesMetric = mMetrics->addGauge("minesweeper_entities", "Entities alive in the scene manager");
+	mLevelArenaMetric = mMetrics->addGauge("minesweeper_level_arena_bytes", "Game state memory of the last level finished");
+	mLevelArenaPeakMetric = mMetrics->addGauge("minesweeper_level_arena_peak_bytes", "Most game state memory a level needed");
+
+	if(mMetricsPort != 0){
+		mMetrics->serve(mMetricsPort);
+	}
+}
 
-	if(mPhysicsInitialized){
+void MineSweeper::updateMetrics(Ogre::Real timeSinceLastFrame){
+	mMetricsTime += timeSinceLastFrame;
+	if(mMetricsTime < METRICS_DUMP_INTERVAL){
 		return;
 	}
+	mMetricsTime = 0;
+
+	mSceneNodesMetric->set(countNodes(mSceneMgr->getRootSceneNode()));
+	int entities = 0;
+	Ogre::SceneManager::MovableObjectIterator it = mSceneMgr->getMovableObjectIterator("Entity");
+	while(it.hasMoreElements()){
+		it.getNext();
+		entities++;
+	}
+	mEntitiesMetric->set(entities);
+	mLevelArenaMetric->set(mLevelArena->getLevelUsed());
+	mLevelArenaPeakMetric->set(std::max(mLevelArena->getPeak(), mLevelArena->getUsed()));
 
-	for (int i = 0; i < mCells.size(); ++i){
-		Cell* curCell = mCells[i];
-		OgreBulletCollisions::BoxCollisionShape * cubeShape;
-		OgreBulletDynamics::RigidBody * cubeBody;
-
-		Vector3 size = curCell->getSceneNode()->_getWorldAABB().getSize()/2;
-		Vector3 position = curCell->getPosition();
-		cubeShape =	new OgreBulletCollisions::BoxCollisionShape(size);
-		cubeBody =
-				new OgreBulletDynamics::RigidBody(
-						"cube" + Ogre::StringConverter::toString(time(0))
-		+  Ogre::StringConverter::toString(i),
-		mWorld
-				);
-
-		SceneNode* node = curCell->getSceneNode();
-
-
-
-		cubeBody->setShape(node, //scene node
-				cubeShape, //collision shape
-				0.6f, //restitution
-				0.6f, //friction
-				1.0f, //mass
-				position, //location of the shape
-				Ogre::Quaternion(0, 0, 0, 1) //orientation
-		);
+	mMetrics->writeToFile(METRICS_FILE);
+}
 
-		int x = Ogre::Math::RangeRandom(-1000, 1000);
-		int y = Ogre::Math::RangeRandom(-1000, 1000);
-		int z = Ogre::Math::RangeRandom(-1000, 1000);
+void MineSweeper::deleteBodies(std::vector<btRigidBody *> &bodies){
+	for(int i = 0; i < bodies.size(); i++){
+		delete bodies[i]->getMotionState();
+		delete bodies[i];
+	}
+	bodies.clear();
+}
 
+btBoxShape* MineSweeper::getBoxShape(const Ogre::Vector3 &halfSize){
+	//Every cube of a level has the same extents, so they can all share one shape
+	ShapeKey key(Math::IFloor(halfSize.x * 100 + 0.5f),
+			Math::IFloor(halfSize.y * 100 + 0.5f),
+			Math::IFloor(halfSize.z * 100 + 0.5f));
+	std::map<ShapeKey, btBoxShape*>::iterator it = mShapeCache.find(key);
+	if(it != mShapeCache.end()){
+		return it->second;
+	}
+	btBoxShape* shape = new btBoxShape(btVector3(halfSize.x, halfSize.y, halfSize.z));
+	mShapeCache[key] = shape;
+	return shape;
+}
 
-		cubeBody->setLinearVelocity(Ogre::Vector3(x, y, z));
-		if(curCell->getMineNode() != 0){
-			size = curCell->getMineNode()->_getWorldAABB().getSize()/2;
-			position = curCell->getMineNode()->getPosition();
+btRigidBody* MineSweeper::addPhysicsBody(Ogre::SceneNode* node){
+	Vector3 size = node->_getWorldAABB().getSize()/2;
+	btBoxShape* shape = getBoxShape(size);
+	const Vector3 &position = node->getPosition();
+	//Same orientation as the OgreBullet bodies were given: Quaternion(0, 0, 0, 1)
+	btTransform start(btQuaternion(0, 0, 1, 0), btVector3(position.x, position.y, position.z));
+
+	//Transforms go through the stepper's buffers instead of straight into the scene node
+	BufferedMotionState* state = new BufferedMotionState(mPhysicsStepper, start);
+	btVector3 inertia(0, 0, 0);
+	shape->calculateLocalInertia(1.0f, inertia);
+	btRigidBody::btRigidBodyConstructionInfo info(1.0f, state, shape, inertia);
+	info.m_restitution = 0.6f;
+	info.m_friction = 0.6f;
+	btRigidBody* body = new btRigidBody(info);
+
+	int x = Ogre::Math::RangeRandom(-1000, 1000);
+	int y = Ogre::Math::RangeRandom(-1000, 1000);
+	int z = Ogre::Math::RangeRandom(-1000, 1000);
+
+	body->setLinearVelocity(btVector3(x, y, z));
+	body->setSleepingThresholds(PHYSICS_SLEEP_LINEAR_VELOCITY, PHYSICS_SLEEP_ANGULAR_VELOCITY);
+	mWorld->getBulletDynamicsWorld()->addRigidBody(body);
+
+	mBodies.push_back(body);
+	mBodyNodes.push_back(node);
+	mBodyStates.push_back(state);
+	return body;
+}
 
+void MineSweeper::stepPhysics(Ogre::Real timeSinceLastFrame){
+	if(!mPhysicsStepper){
+		mPhysicsStepper = new PhysicsStepper(PHYSICS_ON_WORKER_THREAD, PHYSICS_SOLVER_THREADS);
+	}
+	//The world can only be changed while it is not being stepped
+	mPhysicsStepper->wait();
+	mPhysicsStepper->swapBuffers();
 
-			cubeShape =	new OgreBulletCollisions::BoxCollisionShape(size);
+	for(int i = 0; i < mBodies.size(); ){
+		if(m_bounds.contains(mBodyNodes[i]->_getDerivedPosition())){
+			i++;
+			continue;
+		}
+		//Out of sight for good: stop simulating it. Nothing is freed mid-explosion,
+		//the body and its motion state go with the others in clearCells
+		mWorld->getBulletDynamicsWorld()->removeRigidBody(mBodies[i]);
+		mCulledBodies.push_back(mBodies[i]);
+		mBodyNodes[i]->setVisible(false);
+		mBodies[i] = mBodies.back();
+		mBodyNodes[i] = mBodyNodes.back();
+		mBodyStates[i] = mBodyStates.back();
+		mBodies.pop_back();
+		mBodyNodes.pop_back();
+		mBodyStates.pop_back();
+	}
+	setupPhysicsObjects();
+
+	//Sleeping bodies are never removed, so the explosion is over once they all sleep
+	//(read while the world is not being stepped)
+	mExplosionTime += timeSinceLastFrame;
+	bool moving = false;
+	for(int i = 0; i < mBodies.size() && !moving; i++){
+		moving = mBodies[i]->isActive();
+	}
+	mExplosionAtRest = mPhysicsInitialized && (!moving || mExplosionTime > PHYSICS_EXPLOSION_TIMEOUT);
 
-			cubeBody =
-					new OgreBulletDynamics::RigidBody(
-							"mine" + Ogre::StringConverter::toString(time(0))
-			+  Ogre::StringConverter::toString(i),
-			mWorld
-					);
+	//Bullet accumulates the frame time and simulates it in fixed steps; time beyond
+	//PHYSICS_MAX_SUBSTEPS steps is dropped so a slow frame cannot make the next one slower
+	mPhysicsStepper->step(mWorld->getBulletDynamicsWorld(), timeSinceLastFrame,
+			PHYSICS_MAX_SUBSTEPS, PHYSICS_TIMESTEP);
 
-			node = curCell->getMineNode();
+	//Only the front buffers are read, the worker writes the back ones
+	btTransform transform;
+	for(int i = 0; i < mBodies.size(); i++){
+		if(mBodyStates[i]->takeFrontTransform(transform)){
+			const btVector3 &origin = transform.getOrigin();
+			btQuaternion rotation = transform.getRotation();
+			mBodyNodes[i]->setPosition(origin.x(), origin.y(), origin.z());
+			mBodyNodes[i]->setOrientation(rotation.w(), rotation.x(), rotation.y(), rotation.z());
+		}
+	}
+}
 
+void MineSweeper::stepDebris(Ogre::Real timeSinceLastFrame){
+	if(!mPhysicsInitialized){
+		mDebris->explode(mCells, mNumCells, BOARD_WIDTH / mDim);
+		mPhysicsInitialized = true;
+	}
+	mDebris->update(timeSinceLastFrame);
+}
 
+void MineSweeper::setupPhysicsObjects(){
+	PROFILE_SCOPE("setupPhysicsObjects");
 
-			cubeBody->setShape(node, //scene node
-					cubeShape, //collision shape
-					0.6f, //restitution
-					0.6f, //friction
-					1.0f, //mass
-					position, //location of the shape
-					Ogre::Quaternion(0, 0, 0, 1) //orientation
-			);
+	if(mPhysicsInitialized){
+		return;
+	}
 
-			int x = Ogre::Math::RangeRandom(-1000, 1000);
-			int y = Ogre::Math::RangeRandom(-1000, 1000);
-			int z = Ogre::Math::RangeRandom(-1000, 1000);
+	//Only a few cells are turned into bodies each frame so the explosion starts without a hitch
+	int last = std::min<int>(mPhysicsSetupIndex + PHYSICS_CELLS_PER_FRAME, mNumCells);
+	if(mPhysicsSetupIndex == 0){
+		mBodies.reserve(mNumCells * 2);
+		mCulledBodies.reserve(mNumCells * 2);
+	}
+	for (int i = mPhysicsSetupIndex; i < last; ++i){
+		Cell* curCell = &mCells[i];
+		addPhysicsBody(curCell->getSceneNode());
 
-			cubeBody->setLinearVelocity(Ogre::Vector3(x, y, z));
-			cubeBody->applyImpulse(Ogre::Vector3(900, 900, 900),Ogre::Vector3(900, 900, 900));
-			mBodies.push_back(cubeBody);
-			mShapes.push_back(cubeShape);
+		if(curCell->getMineNode() != 0){
+			btRigidBody* mineBody = addPhysicsBody(curCell->getMineNode());
+			mineBody->applyImpulse(btVector3(900, 900, 900), btVector3(900, 900, 900));
 		}
 
 		if(curCell->getFlagNode() != 0){
-			size = curCell->getFlagNode()->_getWorldAABB().getSize()/2;
-			position = curCell->getFlagNode()->getPosition();
-
-
-			cubeShape =	new OgreBulletCollisions::BoxCollisionShape(size);
-
-			cubeBody =
-					new OgreBulletDynamics::RigidBody(
-							"flag" + Ogre::StringConverter::toString(time(0))
-			+  Ogre::StringConverter::toString(i),
-			mWorld
-					);
-
-			node = curCell->getFlagNode();
-
-
-
-			cubeBody->setShape(node, //scene node
-					cubeShape, //collision shape
-					0.6f, //restitution
-					0.6f, //friction
-					1.0f, //mass
-					position, //location of the shape
-					Ogre::Quaternion(0, 0, 0, 1) //orientation
-			);
-
-			int x = Ogre::Math::RangeRandom(-1000, 1000);
-			int y = Ogre::Math::RangeRandom(-1000, 1000);
-			int z = Ogre::Math::RangeRandom(-1000, 1000);
-
-			cubeBody->setLinearVelocity(Ogre::Vector3(x, y, z));
-			mBodies.push_back(cubeBody);
-			mShapes.push_back(cubeShape);
-
+			addPhysicsBody(curCell->getFlagNode());
 		}
 
 		if(curCell->getNumberNode() != 0){
-			size = curCell->getNumberNode()->_getWorldAABB().getSize()/2;
-			position = curCell->getNumberNode()->getPosition();
-
-
-			cubeShape =	new OgreBulletCollisions::BoxCollisionShape(size);
-
-			cubeBody =
-					new OgreBulletDynamics::RigidBody(
-							"number" + Ogre::StringConverter::toString(time(0))
-			+  Ogre::StringConverter::toString(i),
-			mWorld
-					);
-
-			node = curCell->getNumberNode();
-
-
-
-			cubeBody->setShape(node, //scene node
-					cubeShape, //collision shape
-					0.6f, //restitution
-					0.6f, //friction
-					1.0f, //mass
-					position, //location of the shape
-					Ogre::Quaternion(0, 0, 0, 1) //orientation
-			);
-
-			int x = Ogre::Math::RangeRandom(-1000, 1000);
-			int y = Ogre::Math::RangeRandom(-1000, 1000);
-			int z = Ogre::Math::RangeRandom(-1000, 1000);
-
-			cubeBody->setLinearVelocity(Ogre::Vector3(x, y, z));
-			mBodies.push_back(cubeBody);
-			mShapes.push_back(cubeShape);
+			addPhysicsBody(curCell->getNumberNode());
 		}
 	}
-	mPhysicsInitialized = true;
+	mPhysicsSetupIndex = last;
+	mPhysicsInitialized = mPhysicsSetupIndex == mNumCells;
 }
 
 
 void MineSweeper::createField(){
+	mCells = mLevelArena->allocate<Cell>(mDim * mDim);
+	mNumCells = 0;
 	for (int i = 0; i < mDim; i++){
 		for (int j = 0; j < mDim; j++){
 
-			Cell* cell = new Cell();
+			Cell* cell = new(mCells + mNumCells) Cell();
 			cell->init(mSceneMgr);
 			//scale to HEIGHT
 			Ogre::AxisAlignedBox box = cell->getEntity()->getBoundingBox();
@@ -461,89 +603,77 @@ void MineSweeper::createField(){
 
 			boxSize = boxSize*scaleAmt;
 			cell->setPosition(Vector3(-BOARD_WIDTH/2 + boxSize/2 + i* boxSize, -50 + boxSize/2, -(BOARD_WIDTH/2) + boxSize/2 + j* boxSize));
-			mCells.push_back(cell);
 			cell->getEntity()->setQueryFlags(REMOVEABLE);
+			//Picking finds the cell from the entity hit, without going through the board
+			cell->getEntity()->getUserObjectBindings().setUserAny(Ogre::Any(mNumCells));
+			mNumCells++;
 		}
 	}
 
 }
 
 
-void MineSweeper::initialize(int cRow, int cCol){
-	mInitialized = true;
-	int row = mDim;
-	int col = row;
-	int mineLocation[row][col];
-	for (int i = 0; i < row; i++){
-		for (int j = 0; j < col; j++){
-			mineLocation[i][j] = 0;
-		}
-	}
-	int nMines = NUM_MINES[mLevel];
-	int i = 0;
-	while (i < nMines){
-		int r = rand() % row;
-		int c = rand() % col;
+//---------------------------------------------------------------------------
+void MineSweeper::createScene(void)
+{
+	newGameSeed();
+	// Set the scene's ambient light
+	mSceneMgr->setAmbientLight(Ogre::ColourValue(1.0f, 1.0f, 1.0f));
+	Ogre::Light* light = mSceneMgr->createLight("MainLight");
+	light->setPosition(200.0f, 800.0f, 500.0f);
 
-		if(mineLocation[r][c] != 1 && !(r == cRow && c == cCol)){
-			mineLocation[r][c] = 1;
-			i++;
-		}
+	BoardAtlas::create();
+	mSimulation = new GameSimulation(mSeed);
+	if(SIMULATION_ON_WORKER_THREAD){
+		mSimulation->start();
+	}
+	showSnapshot(mSimulation->getSnapshot());
+	if(!mArenaScene.empty()){
+		mArenaLoader = new DotSceneLoader(mSceneMgr);
+		mArenaLoader->load(mArenaScene, Ogre::ResourceGroupManager::DEFAULT_RESOURCE_GROUP_NAME);
+	}
+	mCamera->setPosition(0, 600, 300);
+	mCamera->pitch(Ogre::Degree(-65));
 
+	mHighScore = new HighScores("High Scores", NUM_HIGH_SCORES, true);
 
+	if(!mLeaderboardSocket.empty()){
+		//The daemon owns the high score file, the local list is only a cache
+		mLeaderboard = new LeaderboardClient(mLeaderboardSocket, NUM_HIGH_SCORES);
+		mHighScore->setLeaderboard(mLeaderboard);
 	}
-
-	for (int i = 0; i < row; i++){
-		for (int j = 0; j < col; j++){
-			if(mineLocation[i][j]){
-				mCells[getIndex(i, j, row)]->setMine();
-			}
-		}
+	else if(!mHighScore->readFromFile(HIGHSCORE_FILE)){
+		mHighScore->writeToFile(HIGHSCORE_FILE);
 	}
 
-	int minesAround[row][col];
-	for (int i = 0; i < row; i++){
-		for (int j = 0; j < col; j++){
-			int numMines = 0;
-			std::vector<Cell*> neighbors;
-			for(int r = i - 1; r<= i + 1; r++){
-				for(int c = j - 1; c <= j + 1; c++){
-					if((r >=0 && r <row) && (c >=0 && c< col)){
-						if(!(r == i && c == j)){
-							neighbors.push_back(mCells[getIndex(r, c, row)]);
-						}
-						if(mineLocation[r][c] == 1){
-							numMines = numMines + 1;
-						}
-					}
-				}
+	setupMetrics();
 
-			}
-			if (mineLocation[i][j] == 1){
-				numMines = numMines - 1;
-			}
-			minesAround[i][j] = numMines;
-			mCells[getIndex(i, j, row)]->setMinesAround(numMines);
-			mCells[getIndex(i, j, row)]->setNeighbors(neighbors);
-		}
-	}
-	mGuiRoot->getChild("MessageLabel")->setText("Press P to Pause.");
+	mScoreDistribution = new ScoreDistribution(MAX_LEVEL);
+	mScoreDistribution->readFromFile(SCORE_SKETCH_FILE);
+	mGameHistory = new GameHistory(GAME_HISTORY_DIR, MAX_LEVEL);
 
+	setupGUI();
 
+#ifdef MINESWEEPER_PROFILING
+	PROFILE_THREAD("main");
+	Profiler::setFrameBudget(PROFILER_FRAME_BUDGET);
+	Profiler::setTracePrefix(PROFILER_TRACE_PREFIX);
+	mRenderer->setRenderingEnabled(false);
+	mGuiRenderTimer = new GuiRenderTimer();
+	mSceneMgr->addRenderQueueListener(mGuiRenderTimer);
+#endif
 
-}
+	mGuiRoot->getChild("NameWindow")->getChild("NameBox")->activate();
 
-//---------------------------------------------------------------------------
-void MineSweeper::createScene(void)
-{
-	std::srand(time(NULL));
-	// Set the scene's ambient light
-	mSceneMgr->setAmbientLight(Ogre::ColourValue(1.0f, 1.0f, 1.0f));
-	Ogre::Light* light = mSceneMgr->createLight("MainLight");
-	light->setPosition(200.0f, 800.0f, 500.0f);
 
-	createField();
+	mDebris = new DebrisSystem(mSceneMgr, DEBRIS_MAX_PARTICLES);
+
+	//Bullet physics
+	mWorld = new OgreBulletDynamics::DynamicsWorld(mSceneMgr, m_bounds,
+			GRAVITY);
+}
 
+void MineSweeper::createDetector(){
 	Entity* detectorEnt = mSceneMgr->createEntity("Detector.mesh");
 	Entity* headEnt = mSceneMgr->createEntity("sphere.mesh");
 
@@ -563,30 +693,60 @@ void MineSweeper::createScene(void)
 	Ogre::AxisAlignedBox box = detectorNode->getAttachedObject(0)->getBoundingBox();
 	double boxSize = box.getSize().x * mDetector->getScale().x ;
 
-	double length = mCells[0]->getEntity()->getBoundingBox().getSize().x * mCells[0]->getSceneNode()->getScale().x;
+	double length = mCells[0].getEntity()->getBoundingBox().getSize().x * mCells[0].getSceneNode()->getScale().x;
 	double scaleAmt = (length)/boxSize;
 	mDetector->yaw(Degree(-90));
 
 
 	mDetector->scale(scaleAmt, scaleAmt, scaleAmt);
 	mDetectorHead->setVisible(false);
-	mCamera->setPosition(0, 600, 300);
-	mCamera->pitch(Ogre::Degree(-65));
-
-	mHighScore = new HighScores("High Scores", 20, true);
+}
 
-	if(!mHighScore->readFromFile(HIGHSCORE_FILE)){
-		mHighScore->writeToFile(HIGHSCORE_FILE);
+void MineSweeper::loadResources(void){
+	//The board, the numbers and the GUI are all the first frame needs
+	Ogre::ResourceGroupManager &groups = Ogre::ResourceGroupManager::getSingleton();
+	Ogre::StringVector names = groups.getResourceGroups();
+	for(int i = 0; i < names.size(); i++){
+		if(names[i] != DEFERRED_RESOURCE_GROUP && !groups.isResourceGroupInitialised(names[i])){
+			groups.initialiseResourceGroup(names[i]);
+		}
 	}
+	logStartupPhase("initialising the board and GUI resource groups");
+
+	//The rest is loaded in the background, one step at a time so the order holds
+	//whatever the number of worker threads
+	mResourceSteps.push_back(std::make_pair(std::string(Ogre::ResourceGroupManager::DEFAULT_RESOURCE_GROUP_NAME), true));
+	mResourceSteps.push_back(std::make_pair(DEFERRED_RESOURCE_GROUP, false));
+	mResourceSteps.push_back(std::make_pair(DEFERRED_RESOURCE_GROUP, true));
+	queueResourceStep();
+}
 
-	setupGUI();
-
-	mGuiRoot->getChild("NameWindow")->getChild("NameBox")->activate();
-
+void MineSweeper::operationCompleted(Ogre::BackgroundProcessTicket ticket, const Ogre::BackgroundProcessResult& result){
+	if(ticket != mResourceTicket){
+		return;
+	}
+	if(result.error){
+		Ogre::LogManager::getSingleton().logMessage("Background loading failed: " + result.message);
+	}
+	queueResourceStep();
+}
 
-	//Bullet physics
-	mWorld = new OgreBulletDynamics::DynamicsWorld(mSceneMgr, m_bounds,
-			GRAVITY);
+void MineSweeper::queueResourceStep(){
+	Ogre::ResourceBackgroundQueue &queue = Ogre::ResourceBackgroundQueue::getSingleton();
+	while(!mResourceSteps.empty()){
+		std::pair<std::string, bool> step = mResourceSteps.front();
+		mResourceSteps.erase(mResourceSteps.begin());
+		mResourceTicket = step.second ? queue.loadResourceGroup(step.first, this)
+				: queue.initialiseResourceGroup(step.first, this);
+		if(mResourceTicket != 0){
+			//operationCompleted queues the next step
+			return;
+		}
+		//Without thread support the step was done right away
+	}
+	createDetector();
+	mAssetsReady = true;
+	logStartupPhase("loading the detector, mine and flag in the background");
 }
 
 void MineSweeper::createViewports(){
@@ -606,7 +766,9 @@ void MineSweeper::setupGUI(){
 	CEGUI::Scheme::setDefaultResourceGroup("Schemes");
 	CEGUI::WidgetLookManager::setDefaultResourceGroup("LookNFeel");
 	CEGUI::WindowManager::setDefaultResourceGroup("Layouts");
-	CEGUI::SchemeManager::getSingleton().createFromFile("GlossySerpentFHD.scheme");
+	//Fonts are rasterised on the first launch only
+	GuiCache guiCache(GUI_CACHE_DIR);
+	guiCache.loadScheme("GlossySerpentFHD.scheme");
 	CEGUI::System::getSingleton().getDefaultGUIContext().getMouseCursor().setDefaultImage("GlossySerpentFHDCursors/MouseArrow");
 	CEGUI::WindowManager &wmgr = CEGUI::WindowManager::getSingleton();
 	//	load our file
@@ -660,14 +822,16 @@ void MineSweeper::setupGUI(){
 			CEGUI::PushButton::EventClicked,	//which event to call
 			CEGUI::Event::Subscriber(&MineSweeper::quit, //method call
 					this));	//object to call it on
-	mGuiRoot->getChild("HighScoreValue")->setText(std::to_string(mHighScore->getHighestScore()));
+	mGuiRoot->getChild("HighScoreValue")->setText(std::to_string(mHighScore->snapshot()->getHighestScore()));
 	CEGUI::FrameWindow* scoreWindow = static_cast<CEGUI::FrameWindow*>(mGuiRoot->getChild("ScoreWindow"));
 	scoreWindow->setCloseButtonEnabled(true);
 	scoreWindow->getCloseButton()->subscribeEvent(CEGUI::PushButton::EventClicked,
 			CEGUI::Event::Subscriber(&MineSweeper::hideHighScores, this));
 	//Setup HighScore Fonts
-	CEGUI::FontManager::getSingleton().createFreeTypeFont("HighScoreFont-18.font", 18, true, "HighScoreFont.ttf");
-	CEGUI::FontManager::getSingleton().createFreeTypeFont("HighScoreFont-12.font", 12, true, "HighScoreFont.ttf");
+	guiCache.createFreeTypeFont("HighScoreFont-18.font", 18, "HighScoreFont.ttf");
+	guiCache.createFreeTypeFont("HighScoreFont-12.font", 12, "HighScoreFont.ttf");
+	mLeaderboardView = new LeaderboardView(mScoreBox,
+			static_cast<CEGUI::Scrollbar*>(mGuiRoot->getChild("ScoreWindow/ScoresScrollbar")));
 }
 
 
@@ -696,6 +860,8 @@ bool MineSweeper::keyPressed(const OIS::KeyEvent& arg) {
 		if((arg.key == OIS::KC_SPACE && !mGuiRoot->getChild("ScoreWindow")->isVisible()
 				&& ! mGuiRoot->getChild("GameOverWindow")->isVisible()) ){
 			if(mStop & !mGameOver){
+				//Deals the next level if one was completed; until then clicks are refused
+				mSimulation->push(GameCommand::continueLevel());
 				mGuiRoot->getChild("LevelUpWindow")->setVisible(false);
 				mPause = false;
 				mStop = false;
@@ -716,6 +882,22 @@ bool MineSweeper::keyPressed(const OIS::KeyEvent& arg) {
 				}
 			}
 			break;
+		case OIS::KC_E:
+			//Switch the explosion of the next game over between rigid bodies and particles
+			mParticleExplosion = !mParticleExplosion;
+			mGuiRoot->getChild("MessageLabel")->setText(mParticleExplosion ?
+					"Game over explosion: particles." : "Game over explosion: rigid bodies.");
+			break;
+#ifdef MINESWEEPER_PROFILING
+		case OIS::KC_F3:
+			toggleProfilerPanel();
+			break;
+		case OIS::KC_F4:
+			if(Profiler::writeTrace(PROFILER_TRACE_PREFIX + "-manual.json")){
+				mGuiRoot->getChild("MessageLabel")->setText("Trace written to " + PROFILER_TRACE_PREFIX + "-manual.json");
+			}
+			break;
+#endif
 		case OIS::KC_V:
 			//perform ray query
 			cellClicked("Reveal");
@@ -776,6 +958,7 @@ bool MineSweeper::keyReleased(const OIS::KeyEvent& arg) {
 }
 
 void MineSweeper::updateGUI(){
+	PROFILE_SCOPE("updateGUI");
 	if(!mGameOver){
 		mGuiRoot->getChild("LevelValue")->setText(std::to_string(mLevel));
 		int time = (int)mCurTime;
@@ -784,12 +967,18 @@ void MineSweeper::updateGUI(){
 		std::string t = std::to_string(min) + " : " + std::to_string(sec);
 		mGuiRoot->getChild("TimeValue")->setText(t);
 		mGuiRoot->getChild("ScoreValue")->setText(std::to_string(mScore));
-		mGuiRoot->getChild("FlagsValue")->setText(std::to_string(countFlags()) + "/" + std::to_string(NUM_MINES[mLevel]));
-		mGuiRoot->getChild("HighScoreValue")->setText(std::to_string(mHighScore->getHighestScore()));
+		mGuiRoot->getChild("FlagsValue")->setText(std::to_string(mSnapshot->countFlags()) + "/" + std::to_string(NUM_MINES[mLevel]));
+		mGuiRoot->getChild("HighScoreValue")->setText(std::to_string(mHighScore->snapshot()->getHighestScore()));
 	}
 }
 
 void MineSweeper::cellClicked(String action){
+	PROFILE_SCOPE("cellClicked");
+	if(!mAssetsReady){
+		//The detector, mine and flag are still loading
+		return;
+	}
+	mClicksMetric->increment();
 	Vector3 detectorPos = mDetectorHead->_getDerivedPosition();
 	detectorPos.y = detectorPos.y + 100;
 	mRaySceneQuery->setRay(Ray(mDetectorHead->_getDerivedPosition(),
@@ -799,110 +988,244 @@ void MineSweeper::cellClicked(String action){
 	RaySceneQueryResult::iterator it = qResult.begin();
 	//make sure there is something and it is an entity
 	if(it != qResult.end() && it->movable){
-		for(int i = 0; i < mCells.size(); i++){
-
-			// If the first object is ball and second object is the block or vice versa
-			if(	it->movable->getParentSceneNode() ==  mCells[i]->getSceneNode()){
-				if(!mInitialized){
-					initialize(i / mDim, i % mDim);
-					mStop = false;
-					mPause = false;
-				}
-				if(action == "Reveal"){
-					if (!mCells[i]->reveal()){
-						gameOver();
-					}
-					else {
-						mScore += POINTS_PER_REVEAL[mLevel]*getNumRevealed(mCurNumRevealed);
-						updateHighScores();
-						mCurNumRevealed = countRevealed();
-						if(isLevelUp()){
-							levelUp();
-						}
-					}
+		//Only the cubes of the cells carry their cell id
+		const Ogre::Any &id = it->movable->getUserObjectBindings().getUserAny();
+		int i = id.isEmpty() ? -1 : Ogre::any_cast<int>(id);
+		if(i >= 0 && i < mNumCells && it->movable->getParentSceneNode() == mCells[i].getSceneNode()){
+			if(!mSnapshot->initialized){
+				//The mines are placed around the first click
+				mStop = false;
+				mPause = false;
+				mGuiRoot->getChild("MessageLabel")->setText("Press P to Pause.");
+			}
+			//Latency is measured from the moment the button went down
+			mClickTime = getInputTime();
+			mClickTick = mSnapshot->tick;
+			if(action == "Reveal"){
+				mSimulation->push(GameCommand::reveal(i));
+			}
+			else if(action == "Flag"){
+				mSimulation->push(GameCommand::flag(i));
+			}
+			mDeleted = true;
+		}
+	}
+
+}
+
+std::string MineSweeper::recordScoreDistribution(int level){
+	//Rank against the games played before this one
+	int beaten = (int)(100 * mScoreDistribution->getPercentile(level, mScore));
+	long long played = mScoreDistribution->getGamesPlayed(level);
+	mScoreDistribution->addScore(level, mScore);
+	mScoreDistribution->writeToFile(SCORE_SKETCH_FILE);
+	if(played == 0){
+		return "You are the first to play level " + std::to_string(level) + ".";
+	}
+	return "You beat " + std::to_string(beaten) + "% of games at level " + std::to_string(level) + ".";
+}
+
+#ifdef MINESWEEPER_PROFILING
+void MineSweeper::toggleProfilerPanel(){
+	mProfilerPanel = !mProfilerPanel;
+	if(mProfilerPanel){
+		if(mDetailsNames.empty()){
+			mDetailsNames = mDetailsPanel->getAllParamNames();
+		}
+		mTrayMgr->showAll();
+		mTrayMgr->moveWidgetToTray(mDetailsPanel, OgreBites::TL_TOPRIGHT, 0);
+		mDetailsPanel->show();
+	}
+	else {
+		mTrayMgr->removeWidgetFromTray(mDetailsPanel);
+		mDetailsPanel->hide();
+	}
+}
+
+void MineSweeper::updateProfilerPanel(){
+	std::vector<std::pair<std::string, double> > breakdown = Profiler::getBreakdown();
+	Ogre::StringVector names = mDetailsNames;
+	names.push_back("");
+	for(int i = 0; i < breakdown.size(); i++){
+		names.push_back(breakdown[i].first);
+	}
+	if(names != mDetailsPanel->getAllParamNames()){
+		//Setting the names clears the values, so the camera details are put back
+		Ogre::StringVector values = mDetailsPanel->getAllParamValues();
+		mDetailsPanel->setAllParamNames(names);
+		for(int i = 0; i < mDetailsNames.size() && i < values.size(); i++){
+			mDetailsPanel->setParamValue(i, values[i]);
+		}
+	}
+	for(int i = 0; i < breakdown.size(); i++){
+		mDetailsPanel->setParamValue(mDetailsNames.size() + 1 + i,
+				Ogre::StringConverter::toString(Ogre::Real(breakdown[i].second), 3) + " ms");
+	}
+}
+#endif
 
+void MineSweeper::newGameSeed(){
+	mSeed = time(NULL) ^ ((unsigned int)std::rand() << 8);
+	std::srand(mSeed);
+	//Unique across the instances sharing a leaderboard
+	mGameId = ((uint64_t)getpid() << 32) ^ ((uint64_t)time(NULL) << 8) ^ mSeed;
+	mMoves = 0;
+	mLevelTimes.clear();
+}
 
+void MineSweeper::recordGameHistory(){
+	GameRecord record;
+	record.player = mPlayerName.c_str();
+	record.seed = mSeed;
+	record.level = mLevel;
+	record.score = mScore;
+	record.moves = mMoves;
+	record.levelTimes = mLevelTimes;
+	mGameHistory->append(record);
+}
+
+void MineSweeper::updateSimulation(Ogre::Real timeSinceLastFrame){
+	PROFILE_SCOPE("updateSimulation");
+	mSimulation->advance(timeSinceLastFrame);
+	//The snapshot is taken after the events, so it is at least as recent as they are
+	mEvents.clear();
+	mSimulation->pollEvents(mEvents);
+	std::shared_ptr<const GameSnapshot> snapshot = mSimulation->getSnapshot();
+	mMoves = snapshot->moves;
+	for(int i = 0; i < mEvents.size(); i++){
+		const GameEvent &e = mEvents[i];
+		switch(e.type){
+		case GameEvent::CLICK:
+			if(e.flag){
+				mFlagsMetric->increment();
+			}
+			else {
+				mRevealsMetric->increment(e.revealed);
+				if(e.chord){
+					mChordsMetric->increment();
 				}
-				else if(action == "Flag"){
-					mCells[i]->flag();
-					if(isLevelUp()){
-						levelUp();
-					}
+				else if(e.revealed > 1){
+					mFloodsMetric->increment();
+					mFloodCellsMetric->increment(e.revealed);
 				}
-				mDeleted = true;
-				break;
+			}
+			break;
+		case GameEvent::CHORD_FAILED:
+			lightNeighbors(e.cell);
+			break;
+		case GameEvent::GAME_OVER:
+			gameOver(e);
+			break;
+		case GameEvent::LEVEL_UP:
+		case GameEvent::GAME_COMPLETED:
+			levelUp(e);
+			break;
+		}
+	}
+	showSnapshot(snapshot);
+}
+
+void MineSweeper::showSnapshot(const std::shared_ptr<const GameSnapshot> &snapshot){
+	PROFILE_SCOPE("showSnapshot");
+	bool newBoard = !mSnapshot || snapshot->board != mSnapshot->board;
+	if(newBoard){
+		if(mSnapshot){
+			clearCells();
+		}
+		mDim = snapshot->dim;
+		createField();
+	}
+
+	//mCells is empty between a restart and the new board
+	const std::vector<CellState> &cells = *snapshot->cells;
+	mChangedCells.clear();
+	if(newBoard){
+		for(int i = 0; i < cells.size(); i++){
+			if(cells[i] != CellState()){
+				mChangedCells.push_back(i);
 			}
 		}
 	}
+	else if(mNumCells > 0){
+		changedCells(*mSnapshot, *snapshot, mChangedCells);
+	}
+	for(int i = 0; i < mChangedCells.size(); i++){
+		int index = mChangedCells[i];
+		const CellState &cell = cells[index];
+		CellState shown = newBoard ? CellState() : (*mSnapshot->cells)[index];
+		if(cell.revealed && !shown.revealed){
+			mCells[index].showRevealed(cell.mine, cell.minesAround);
+		}
+		if(cell.flagged != shown.flagged){
+			mCells[index].showFlag(cell.flagged);
+		}
+	}
 
+	bool scoreChanged = mSnapshot && snapshot->score != mSnapshot->score;
+	mLevel = snapshot->level;
+	mScore = snapshot->score;
+	mCurTime = snapshot->timeAt(std::chrono::steady_clock::now());
+	mSnapshot = snapshot;
+	if(scoreChanged && mScore != 0){
+		updateHighScores();
+	}
+}
+
+void MineSweeper::lightNeighbors(int cell){
+	if(cell >= mNumCells){
+		return;
+	}
+	int neighbors[8];
+	int count = GameRules::getNeighbors(mDim, cell, neighbors);
+	for(int i = 0; i < count; i++){
+		if(!(*mSnapshot->cells)[neighbors[i]].flagged){
+			mCells[neighbors[i]].light();
+		}
+	}
 }
 
-void MineSweeper::gameOver(){
-	revealAll();
+void MineSweeper::gameOver(const GameEvent &e){
+	mGameOversMetric->increment();
+	mLevel = e.level;
+	mScore = e.score;
+	mGameOverRank = recordScoreDistribution(mLevel);
+	recordGameHistory();
 	mGameOver = true;
-	mGameOverTime = mCurTime;
+	mGameOverTime = e.time;
 	mStop = true;
 	mPause = true;
 	mPhysicsInitialized = false;
-}
-int MineSweeper::countRevealed(){
-	int count = 0;
-	for(Cell* c: mCells){
-		if(c->isRevelead()){
-			++count;
-		}
-	}
-	return count;
-
+	mPhysicsSetupIndex = 0;
+	mExplosionAtRest = false;
+	mExplosionTime = 0;
+	mExplodingParticles = mParticleExplosion;
 }
 
-void MineSweeper::levelUp(){
+void MineSweeper::levelUp(const GameEvent &e){
+	mLevelUpsMetric->increment();
 	mPause = true;
 	mStop = true;
-	for(int i = 0; i < mCells.size(); ++i){
-		mCells[i]->reveal();
-	}
-	if(mLevel < MAX_LEVEL){
-
-		if(mCurTime < MAX_BONUS_TIME[mLevel]){
-			//award bonus points
-			mScore += 2*(MAX_BONUS_TIME[mLevel] - mCurTime);
-		}
-		mLevel = mLevel + 1;
-		mDim = LEVEL_DIM[mLevel];
-		mGuiRoot->getChild("LevelValue")->setText(std::to_string(mLevel));
+	mLevel = e.level;
+	mScore = e.score;
+	std::string rank = recordScoreDistribution(mLevel);
+	mLevelTimes.push_back(e.time);
+	if(e.type == GameEvent::LEVEL_UP){
+		//The completed board stays until Space is pressed, the simulation deals the next one then
+		int nextLevel = mLevel + 1;
 		mGuiRoot->getChild("LevelUpWindow")->getChild("LevelUpPrompt")->setText("Congratulations " + mPlayerName + " !!! You have reached Level "
-				+ std::to_string(mLevel) + ". Please press Space to continue to next Level." );
+				+ std::to_string(nextLevel) + ". " + rank + " Please press Space to continue to next Level." );
 		mGuiRoot->getChild("LevelUpWindow")->setVisible(true);
 		mGuiRoot->getChild("MessageLabel")->setText("Congratulations " + mPlayerName + " !!! \n You have reached Level "
-				+ std::to_string(mLevel) + ". Please press Space to continue to next Level.");
+				+ std::to_string(nextLevel) + ". Please press Space to continue to next Level.");
 		showButtons(true);
 		mGuiRoot->getChild("ResumeButton")->setVisible(false);
-
-		clearCells();
-		createField();
-		mInitialized = false;
-		mCurNumRevealed = 0;
-		mCurTime = 0;
 	}
 	else {
-		mGuiRoot->getChild("GameOverWindow")->getChild("GameOverPrompt")->setText("Congratulations " + mPlayerName + " !!! You have completed the Game."  );
+		recordGameHistory();
+		mGuiRoot->getChild("GameOverWindow")->getChild("GameOverPrompt")->setText("Congratulations " + mPlayerName + " !!! You have completed the Game. " + rank);
 		mGuiRoot->getChild("MessageLabel")->setText("Congratulations " + mPlayerName + " !!! You have completed the Game."  );
 		mGuiRoot->getChild("GameOverWindow")->setVisible(true);
 	}
-
-}
-
-bool MineSweeper::isLevelUp(){
-	int countFlagged = 0;
-	for (int i = 0; i < mCells.size(); ++i){
-		Cell* cur = mCells[i];
-		if(cur->isMine() & cur->isFlagged()){
-			++countFlagged;
-		}
-	}
-	int revealCells = mDim*mDim - NUM_MINES[mLevel];
-	return countRevealed() == revealCells || countFlagged == NUM_MINES[mLevel];
 }
 
 
@@ -916,7 +1239,9 @@ bool MineSweeper::mouseMoved(const OIS::MouseEvent& arg) {
 		Ogre::Real zPct = ((Ogre::Real)arg.state.Y.abs)/mViewport->getActualHeight();
 		int newX = 2*DETECTOR_MAX_X*xPct -DETECTOR_MAX_X;
 		int newZ = 2*DETECTOR_MAX_Z*(1-zPct) - DETECTOR_MAX_Z;
-		mDetector->setPosition(Ogre::Vector3(newX, DETECTOR_Y[mLevel], -newZ));
+		if(mDetector){
+			mDetector->setPosition(Ogre::Vector3(newX, DETECTOR_Y[mLevel], -newZ));
+		}
 	}
 	else {
 		CEGUI::System::getSingleton().getDefaultGUIContext().getMouseCursor().show();
@@ -957,8 +1282,8 @@ bool MineSweeper::mousePressed(const OIS::MouseEvent& arg,
 bool MineSweeper::mouseReleased(const OIS::MouseEvent& arg,
 		OIS::MouseButtonID id) {
 	CEGUI::System::getSingleton().getDefaultGUIContext().injectMouseButtonUp(convertButton(id));
-	for(int i = 0; i < mCells.size(); ++i){
-		mCells[i]->light(false);
+	for(int i = 0; i < mNumCells; ++i){
+		mCells[i].light(false);
 	}
 	return true;
 }
@@ -980,9 +1305,57 @@ INT WINAPI WinMain(HINSTANCE hInst, HINSTANCE, LPSTR strCmdLine, INT)
 int main(int argc, char *argv[])
 #endif
 {
+#if OGRE_PLATFORM != OGRE_PLATFORM_WIN32
+	// The modes without a window come first, so they never pay for the game's threads
+	if(argc > 1 && strcmp(argv[1], "--bench-physics") == 0){
+		// Measure the game over explosion without a window
+		return PhysicsBenchmark::main(argc - 2, argv + 2);
+	}
+	if(argc > 1 && strcmp(argv[1], "--cook-assets") == 0){
+		// Optimise the meshes offline
+		return AssetCooker::main(argc - 2, argv + 2);
+	}
+	if(argc > 1 && strcmp(argv[1], "--headless") == 0){
+		// Play without a window, over stdin/stdout or a socket
+		return HeadlessServer::main(argc - 2, argv + 2);
+	}
+	if(argc > 1 && strcmp(argv[1], "--session-host") == 0){
+		// Host the games of the tournament back end
+		return SessionHost::main(argc - 2, argv + 2);
+	}
+	for(int i = 1; i + 1 < argc; i++){
+		if(strcmp(argv[i], "--leaderboard-daemon") == 0){
+			// Serve the shared high scores instead of playing
+			LeaderboardServer server(argv[i + 1], HIGHSCORE_FILE, NUM_HIGH_SCORES);
+			return server.run() ? 0 : 1;
+		}
+	}
+#endif
+
 	// Create application object
 	MineSweeper app;
 
+#if OGRE_PLATFORM != OGRE_PLATFORM_WIN32
+	for(int i = 1; i < argc; i++){
+		if(strcmp(argv[i], "--production") == 0){
+			// Load only the plugins and resources the game uses
+			app.setProductionProfile(true);
+		}
+	}
+	for(int i = 1; i + 1 < argc; i++){
+		if(strcmp(argv[i], "--leaderboard") == 0){
+			app.setLeaderboardSocket(argv[i + 1]);
+		}
+		if(strcmp(argv[i], "--metrics-port") == 0){
+			app.setMetricsPort(atoi(argv[i + 1]));
+		}
+		if(strcmp(argv[i], "--arena") == 0){
+			// Decorate the board with a DotScene file
+			app.setArenaScene(argv[i + 1]);
+		}
+	}
+#endif
+
 	try {
 		app.go();
 	} catch(Ogre::Exception& e)  {
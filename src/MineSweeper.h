@@ -10,20 +10,55 @@
 
 #include "BaseApplication.h"
 #include "HighScores.h"
+#include "ScoreDistribution.h"
+#include "GameHistory.h"
+#include "LeaderboardView.h"
+#include "PhysicsStepper.h"
+#include "DebrisSystem.h"
+#include "Metrics.h"
+#include "DotSceneLoader.h"
+#include "GameSimulation.h"
+#include "LevelArena.h"
 #include <vector>
+#include <map>
+#include <tuple>
 #include "Cell.h"
 #include <CEGUI/CEGUI.h>
 #include <CEGUI/RendererModules/Ogre/Renderer.h>
-#include <OgreBulletDynamicsRigidBody.h>
+#include <OgreBulletDynamicsWorld.h>
+#include <OgreResourceBackgroundQueue.h>
 
 //---------------------------------------------------------------------------
 
-class MineSweeper : public BaseApplication
+class MineSweeper : public BaseApplication, public Ogre::ResourceBackgroundQueue::Listener
 {
 public:
 
 	MineSweeper(void);
 	virtual ~MineSweeper(void);
+
+	/**
+	 * Shares the high scores with other instances through the leaderboard daemon
+	 * listening on the given UNIX domain socket (must be called before go)
+	 */
+	void setLeaderboardSocket(const std::string &socketPath){
+		mLeaderboardSocket = socketPath;
+	}
+
+	/**
+	 * Also serves the metrics over HTTP on the given localhost port (must be called before go)
+	 */
+	void setMetricsPort(int port){
+		mMetricsPort = port;
+	}
+
+	/**
+	 * Decorates the surroundings of the board with a DotScene file of the General
+	 * resource group, streamed in while the game starts (must be called before go)
+	 */
+	void setArenaScene(const std::string &sceneName){
+		mArenaScene = sceneName;
+	}
 protected:
 
 	/**
@@ -39,6 +74,8 @@ protected:
 	virtual void createScene(void);
 	virtual void createFrameListener(void);
 	virtual bool frameRenderingQueued(const Ogre::FrameEvent& evt);
+	virtual bool frameEnded(const Ogre::FrameEvent& evt);
+	virtual bool isAnimating(void);
 	virtual bool keyPressed(const OIS::KeyEvent &arg);
 	virtual bool keyReleased(const OIS::KeyEvent &arg);
 
@@ -48,12 +85,37 @@ protected:
 	virtual bool mousePressed(const OIS::MouseEvent &arg, OIS::MouseButtonID id);
 	virtual bool mouseReleased(const OIS::MouseEvent &arg, OIS::MouseButtonID id);
 	virtual void createViewports(void);
+	virtual void loadResources(void);
+
+	/**
+	 * Called on the main thread every time a background loading step completes
+	 */
+	virtual void operationCompleted(Ogre::BackgroundProcessTicket ticket, const Ogre::BackgroundProcessResult& result);
+
+	/**
+	 * Queues the next background loading step, or creates the detector if there is none left
+	 */
+	void queueResourceStep();
+
+	/**
+	 * Creates the metal detector once its meshes are loaded
+	 */
+	void createDetector();
 	void createField();
-	void initialize(int cRow, int cCol);
 
 	void setupGUI();
-	std::vector<Cell*> mCells;
-	Cell** mCellPointers;
+	/**
+	 * Scene objects of the cells of the board shown, indexed by cell id (row * mDim +
+	 * column), in mLevelArena; the state of the cells is in mSnapshot
+	 */
+	Cell* mCells;
+	int mNumCells;
+
+	/**
+	 * Memory of the game state of the board shown (the cells), given back at once
+	 * when the next board is dealt
+	 */
+	LevelArena* mLevelArena;
 
 	/**
 	 * quit: Closes the game (called when Quit button is clicked)
@@ -111,50 +173,109 @@ protected:
 	void clearCells();
 
 	/**
-	 * Reveals all of the cells
+	 * Sets up the physics objects for the game over animation at the end.
+	 * At most PHYSICS_CELLS_PER_FRAME cells are set up per call; it is called
+	 * every frame until mPhysicsInitialized is true.
 	 */
-	void revealAll();
+	void setupPhysicsObjects();
 
 	/**
-	 * Sets up the physics objects for the game over animation at the end
+	 * Creates a rigid body for the scene node and launches it in a random direction
 	 */
-	void setupPhysicsObjects();
+	btRigidBody* addPhysicsBody(Ogre::SceneNode* node);
 
 	/**
-	 * Counts the number of flagged cells
+	 * Returns the shared box shape with the given half extents, creating it if needed
 	 */
-	int countFlags();
+	btBoxShape* getBoxShape(const Ogre::Vector3 &halfSize);
 
 	/**
-	 * Counts and returns the number of cells already revealed by the player
+	 * Frees the bodies, already out of the world, with their motion states
+	 * (the shapes stay in mShapeCache)
 	 */
-	int getNumRevealed(int prevReveal);
+	void deleteBodies(std::vector<btRigidBody *> &bodies);
 
 	/**
-	 * Returns whether or not the player has completed the current level and needs to level up
+	 * Advances the game over explosion by the frame time in fixed steps, removes the
+	 * bodies that have left the world bounds and moves the nodes to the latest transforms.
+	 * With PHYSICS_ON_WORKER_THREAD the step runs while the next frame is drawn.
 	 */
-	bool isLevelUp();
+	void stepPhysics(Ogre::Real timeSinceLastFrame);
 
 	/**
-	 * Starts the next level
+	 * Advances the particle explosion, hiding the cells the first time it is called
 	 */
-	void levelUp();
+	void stepDebris(Ogre::Real timeSinceLastFrame);
 
 	/**
-	 * End the game when the player hits a mine
+	 * Runs the simulation ticks due this frame, reacts to their events and
+	 * shows the latest snapshot
 	 */
-	void gameOver();
+	void updateSimulation(Ogre::Real timeSinceLastFrame);
 
 	/**
-	 * Counts the number of revealed cells
+	 * Brings the board in the scene up to date with the snapshot, creating a new
+	 * field when the simulation has dealt a new board
 	 */
-	int countRevealed();
+	void showSnapshot(const std::shared_ptr<const GameSnapshot> &snapshot);
+
+	/**
+	 * Lights the unflagged cells around a revealed cell whose mines are not all flagged
+	 */
+	void lightNeighbors(int cell);
+
+	/**
+	 * Shows the next level, or the end of the game, once the simulation has moved on
+	 */
+	void levelUp(const GameEvent &e);
+
+	/**
+	 * End the game when the player hits a mine
+	 */
+	void gameOver(const GameEvent &e);
 
 	/**
 	 * Updates the stats in the GUI as well as the state of GUI elements
 	 */
 	void updateGUI();
 
+	/**
+	 * Records the current score in the score distribution of the given level
+	 * and returns a message telling the player how many games they beat
+	 */
+	std::string recordScoreDistribution(int level);
+
+	/**
+	 * Appends the current game to the game history log
+	 */
+	void recordGameHistory();
+
+	/**
+	 * Picks a new random seed for the next game
+	 */
+	void newGameSeed();
+
+	/**
+	 * Registers the metrics of the game and starts the HTTP endpoint if a port was given
+	 */
+	void setupMetrics();
+
+	/**
+	 * Updates the gauges and writes the metrics file once every METRICS_DUMP_INTERVAL
+	 */
+	void updateMetrics(Ogre::Real timeSinceLastFrame);
+
+#ifdef MINESWEEPER_PROFILING
+	/**
+	 * Shows or hides the time spent per subsystem in the details panel (F3)
+	 */
+	void toggleProfilerPanel();
+
+	/**
+	 * Writes the latest profiler breakdown into the details panel
+	 */
+	void updateProfilerPanel();
+#endif
 
 private:
 	/**
@@ -185,11 +306,6 @@ private:
 	//TODO: Do I need this item
 	bool mDeleted = false;
 
-	/**
-	 * Has the matrix been generated for the current level?
-	 */
-	bool mInitialized = false;
-
 	/**
 	 * Is the game over?
 	 */
@@ -200,6 +316,17 @@ private:
 	 */
 	bool mPhysicsInitialized = false;
 
+	/**
+	 * Has every body of the explosion come to rest (or the explosion timed out)?
+	 * Resting bodies stay in the world, so the explosion is not over when none is left.
+	 */
+	bool mExplosionAtRest = false;
+
+	/**
+	 * Time (seconds) the bodies of the explosion have been simulated
+	 */
+	Ogre::Real mExplosionTime = 0;
+
 	/**
 	 * World for the physics
 	 */
@@ -226,11 +353,61 @@ private:
 	 */
 	HighScores* mHighScore;
 
+	/**
+	 * Path of the leaderboard daemon's socket, empty if the high scores are local
+	 */
+	std::string mLeaderboardSocket;
+
+	/**
+	 * Connection to the leaderboard daemon, 0 if the high scores are local
+	 */
+	LeaderboardClient* mLeaderboard;
+
+	/**
+	 * Id of the current game on the leaderboard
+	 */
+	uint64_t mGameId;
+
+	/**
+	 * Distribution of the scores of every game played, per level
+	 */
+	ScoreDistribution* mScoreDistribution;
+
+	/**
+	 * Message shown in the game over window with the rank of the final score
+	 */
+	std::string mGameOverRank;
+
+	/**
+	 * Log of every finished game
+	 */
+	GameHistory* mGameHistory;
+
+	/**
+	 * Seed of the random number generator for the current game
+	 */
+	unsigned int mSeed;
+
+	/**
+	 * Number of reveals and flags in the current game
+	 */
+	unsigned int mMoves;
+
+	/**
+	 * Time spent on each completed level of the current game
+	 */
+	std::vector<float> mLevelTimes;
+
 	/**
 	 * Multi column List for Dispalying high scores
 	 */
 	CEGUI::MultiColumnList* mScoreBox;
 
+	/**
+	 * Rows of the high score list, only the visible ones are created
+	 */
+	LeaderboardView* mLeaderboardView;
+
 	/**
 	 * Position of current score in the high score table
 	 * -1 if the score is not yet in th high score list
@@ -248,14 +425,25 @@ private:
 	int mScore;
 
 	/**
-	 * Number of cells currently revealed
+	 * Dimension of the matrix. Note that the matrix is a square
+	 */
+	int mDim;
+
+	/**
+	 * Rules of the game, ticking on their own thread if SIMULATION_ON_WORKER_THREAD
 	 */
-	int mCurNumRevealed;
+	GameSimulation* mSimulation;
 
 	/**
-	 * Dimension of the matrix. Note that the matrix is a square
+	 * Snapshot of the simulation the scene shows
 	 */
-	int mDim;
+	std::shared_ptr<const GameSnapshot> mSnapshot;
+
+	/**
+	 * Events of the simulation and changed cells, kept to reuse their storage
+	 */
+	std::vector<GameEvent> mEvents;
+	std::vector<int> mChangedCells;
 
 	/**
 	 * Ray scene query used to detect the object under the metal detector
@@ -267,6 +455,21 @@ private:
 	 */
 	int mLevel;
 
+	/**
+	 * Resource groups still to be initialised (false) or loaded (true) in the background, in order
+	 */
+	std::vector<std::pair<std::string, bool> > mResourceSteps;
+
+	/**
+	 * Ticket of the background step in progress
+	 */
+	Ogre::BackgroundProcessTicket mResourceTicket;
+
+	/**
+	 * Have the detector, mine and flag been loaded? Clicks are ignored until then
+	 */
+	bool mAssetsReady;
+
 	/**
 	 * Scene node for the metal detector
 	 */
@@ -284,14 +487,127 @@ private:
 	Ogre::Viewport* mViewport;
 
 	/**
-	 * List of  rigid body for the cells
+	 * List of  rigid body for the cells. They are plain Bullet bodies: OgreBullet's
+	 * RigidBody deletes its shape, which would free a shared shape with every body.
+	 */
+	std::vector<btRigidBody *> mBodies;
+
+	/**
+	 * Scene node moved by each rigid body (same index as mBodies)
+	 */
+	std::vector<Ogre::SceneNode *> mBodyNodes;
+
+	/**
+	 * Motion state receiving the transforms of each rigid body (same index as mBodies)
+	 */
+	std::vector<BufferedMotionState *> mBodyStates;
+
+	/**
+	 * Bodies that left the world bounds: out of the world, freed in clearCells
+	 */
+	std::vector<btRigidBody *> mCulledBodies;
+
+	/**
+	 * Steps the physics world, on a worker thread if PHYSICS_ON_WORKER_THREAD
+	 * (0 until the first game over)
+	 */
+	PhysicsStepper* mPhysicsStepper;
+
+	/**
+	 * Box extents in hundredths, used to find a shared shape
+	 */
+	typedef std::tuple<int, int, int> ShapeKey;
+
+	/**
+	 * Box shapes shared by every body of the same size, kept across games
+	 */
+	std::map<ShapeKey, btBoxShape*> mShapeCache;
+
+	/**
+	 * Index of the next cell to be given a physics body
+	 */
+	int mPhysicsSetupIndex;
+
+	/**
+	 * Particles replacing the rigid bodies when the explosion uses particles
+	 */
+	DebrisSystem* mDebris;
+
+	/**
+	 * Will the next game over explode into particles? (toggled with E)
+	 */
+	bool mParticleExplosion;
+
+	/**
+	 * Does the current game over explode into particles?
+	 */
+	bool mExplodingParticles;
+
+	/**
+	 * Metrics of the game, written to METRICS_FILE
+	 */
+	Metrics* mMetrics;
+
+	/**
+	 * Port of the HTTP metrics endpoint, 0 if it is not served
+	 */
+	int mMetricsPort;
+
+	/**
+	 * DotScene file decorating the board, and the loader streaming it in
+	 */
+	std::string mArenaScene;
+	DotSceneLoader* mArenaLoader;
+
+	/**
+	 * Time since the metrics were last written
+	 */
+	Ogre::Real mMetricsTime;
+
+	/**
+	 * Time (microseconds) the last click changed the board, 0 once its frame has been shown
+	 */
+	unsigned long mClickTime;
+
+	/**
+	 * Simulation tick shown when the last click happened
+	 */
+	uint64_t mClickTick;
+
+	/**
+	 * Metrics recorded by the game, owned by mMetrics
+	 */
+	MetricCounter* mClicksMetric;
+	MetricCounter* mRevealsMetric;
+	MetricCounter* mFloodsMetric;
+	MetricCounter* mFloodCellsMetric;
+	MetricCounter* mChordsMetric;
+	MetricCounter* mFlagsMetric;
+	MetricCounter* mLevelUpsMetric;
+	MetricCounter* mGameOversMetric;
+	MetricHistogram* mClickLatencyMetric;
+	MetricHistogram* mFrameTimeMetric;
+	MetricGauge* mSceneNodesMetric;
+	MetricGauge* mEntitiesMetric;
+	MetricGauge* mLevelArenaMetric;
+	MetricGauge* mLevelArenaPeakMetric;
+
+#ifdef MINESWEEPER_PROFILING
+	/**
+	 * Is the profiler breakdown shown in the details panel?
+	 */
+	bool mProfilerPanel;
+
+	/**
+	 * Names the details panel was created with, the breakdown is listed after them
 	 */
-	std::vector<OgreBulletDynamics::RigidBody *> mBodies;
+	Ogre::StringVector mDetailsNames;
 
 	/**
-	 * List of shapes for the cells
+	 * Renders CEGUI itself so the rendering can be timed
 	 */
-	std::vector<OgreBulletCollisions::CollisionShape *> mShapes;
+	Ogre::RenderQueueListener* mGuiRenderTimer;
+#endif
 
 
 };
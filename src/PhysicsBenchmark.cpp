@@ -0,0 +1,261 @@
+//============================================================================
+// Name        : PhysicsBenchmark.cpp
+// Author      : Amrit Dhakal
+// Version     : 1.0
+// Copyright   : © Amrit Dhakal 2015. All right reserved. :D
+// Description : Headless benchmark of the game over explosion
+//============================================================================
+
+#include "PhysicsBenchmark.h"
+
+#include <OgreVector3.h>
+#include <OgreAxisAlignedBox.h>
+#include "Constants.h"
+#include "IslandSolver.h"
+#include <btBulletDynamicsCommon.h>
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <thread>
+
+using namespace std;
+
+//Edge of cube.mesh, which every cell is scaled from
+static const float CUBE_MESH_SIZE = 100;
+
+//Frame time the explosion is stepped with
+static const float FRAME_TIME = 1.0f / 60.0f;
+
+/**
+ * Returns the resident memory of the process in kilobytes
+ */
+static long residentMemory(){
+	long pages = 0, resident = 0;
+	FILE *statm = fopen("/proc/self/statm", "r");
+	if(statm){
+		if(fscanf(statm, "%ld %ld", &pages, &resident) != 2){
+			resident = 0;
+		}
+		fclose(statm);
+	}
+	return resident * (sysconf(_SC_PAGESIZE) / 1024);
+}
+
+PhysicsBenchmark::PhysicsBenchmark(int level, double seconds, double revealed):
+					mLevel(level),
+					mSeconds(seconds),
+					mRevealed(revealed)
+{
+}
+
+int PhysicsBenchmark::main(int argc, char *argv[]){
+	int level = argc > 0 ? atoi(argv[0]) : MAX_LEVEL;
+	double seconds = argc > 1 ? atof(argv[1]) : 10;
+	double revealed = argc > 2 ? atof(argv[2]) : 0.5;
+	if(level < 1 || level > MAX_LEVEL || seconds < FRAME_TIME || revealed < 0 || revealed > 1){
+		cerr << "Usage: --bench-physics [level 1-" << MAX_LEVEL << "] [seconds, at least one frame] [revealed 0-1]" << endl;
+		return 1;
+	}
+	PhysicsBenchmark benchmark(level, seconds, revealed);
+	benchmark.run();
+	return 0;
+}
+
+void PhysicsBenchmark::buildBoxes(){
+	//Same layout as MineSweeper::createField
+	int dim = LEVEL_DIM[mLevel];
+	float cellSize = (BOARD_WIDTH / dim);
+	float cellHeight = CUBE_MESH_SIZE * 0.2f;
+	srand(mLevel);
+
+	vector<bool> mines(dim * dim, false);
+	for(int placed = 0; placed < NUM_MINES[mLevel]; ){
+		int i = rand() % (dim * dim);
+		if(!mines[i]){
+			mines[i] = true;
+			placed++;
+		}
+	}
+
+	mBoxes.clear();
+	for(int i = 0; i < dim; i++){
+		for(int j = 0; j < dim; j++){
+			BoxSpec cell;
+			cell.halfX = cellSize / 2;
+			cell.halfY = cellHeight / 2;
+			cell.halfZ = cellSize / 2;
+			cell.x = -BOARD_WIDTH/2 + cellSize/2 + i * cellSize;
+			cell.y = -50 + cellSize/2;
+			cell.z = -(BOARD_WIDTH/2) + cellSize/2 + j * cellSize;
+			cell.isMine = false;
+			mBoxes.push_back(cell);
+
+			//At game over every mine is revealed, and revealed cells show their number
+			if(mines[i * dim + j]){
+				BoxSpec mine = cell;
+				mine.halfY = cellSize / 2;
+				mine.isMine = true;
+				mBoxes.push_back(mine);
+			}
+			else if(rand() < mRevealed * RAND_MAX){
+				BoxSpec number = cell;
+				number.halfX = number.halfZ = cellSize / 4;
+				number.halfY = cellHeight / 4;
+				mBoxes.push_back(number);
+			}
+		}
+	}
+}
+
+void PhysicsBenchmark::run(){
+	buildBoxes();
+	printf("Level %d (%dx%d), %d bodies, %.1f simulated seconds\n",
+			mLevel, LEVEL_DIM[mLevel], LEVEL_DIM[mLevel], (int)mBoxes.size(), mSeconds);
+	printf("%-16s %7s %9s %9s %9s %9s %10s %10s %10s\n",
+			"broadphase", "threads", "p50 ms", "p90 ms", "p99 ms", "max ms", "avg pairs", "max pairs", "peak KB");
+	int cores = max(1, (int)thread::hardware_concurrency());
+	for(int threads = 1; ; threads = min(threads * 2, cores)){
+		runInChild(DBVT, threads);
+		runInChild(SWEEP_AND_PRUNE, threads);
+		if(threads == cores){
+			break;
+		}
+	}
+}
+
+void PhysicsBenchmark::runInChild(Broadphase broadphase, int threads){
+	//Memory freed by a run stays with the process and would hide what the next run
+	//needs, so every run gets a process of its own
+	fflush(stdout);
+	pid_t child = fork();
+	if(child < 0){
+		cerr << "Could not fork, running in this process." << endl;
+		runWith(broadphase, threads);
+		return;
+	}
+	if(child == 0){
+		runWith(broadphase, threads);
+		fflush(stdout);
+		_exit(0);
+	}
+	int status;
+	waitpid(child, &status, 0);
+}
+
+void PhysicsBenchmark::runWith(Broadphase broadphaseType, int threads){
+	//What the process holds before the run (the boxes, the libraries) is not counted.
+	//ru_maxrss cannot be used: a forked child starts with the peak of its parent.
+	long startMemory = residentMemory();
+	long peakMemory = startMemory;
+	btDefaultCollisionConfiguration configuration;
+	btCollisionDispatcher dispatcher(&configuration);
+	btBroadphaseInterface* broadphase;
+	Ogre::Vector3 boundsMin = PHYSICS_WORLD_BOUNDS.getMinimum();
+	Ogre::Vector3 boundsMax = PHYSICS_WORLD_BOUNDS.getMaximum();
+	if(broadphaseType == DBVT){
+		broadphase = new btDbvtBroadphase();
+	}
+	else {
+		//What OgreBullet's DynamicsWorld uses
+		broadphase = new btAxisSweep3(btVector3(boundsMin.x, boundsMin.y, boundsMin.z), btVector3(boundsMax.x, boundsMax.y, boundsMax.z));
+	}
+	btConstraintSolver* solver;
+	if(threads > 1){
+		//What the PhysicsStepper of the game installs
+		solver = new IslandSolver(threads);
+	}
+	else {
+		solver = new btSequentialImpulseConstraintSolver();
+	}
+	btDiscreteDynamicsWorld world(&dispatcher, broadphase, solver, &configuration);
+	world.setGravity(btVector3(GRAVITY.x, GRAVITY.y, GRAVITY.z));
+
+	//Same shape sharing, launch velocities and sleeping as the game
+	srand(mLevel);
+	vector<btBoxShape*> shapes;
+	vector<btRigidBody*> bodies;
+	for(int i = 0; i < mBoxes.size(); i++){
+		const BoxSpec &box = mBoxes[i];
+		btVector3 halfExtents(box.halfX, box.halfY, box.halfZ);
+		btBoxShape* shape = 0;
+		for(int s = 0; s < shapes.size() && !shape; s++){
+			if(shapes[s]->getHalfExtentsWithMargin() == halfExtents){
+				shape = shapes[s];
+			}
+		}
+		if(!shape){
+			shape = new btBoxShape(halfExtents);
+			shapes.push_back(shape);
+		}
+		btVector3 inertia(0, 0, 0);
+		shape->calculateLocalInertia(1.0f, inertia);
+		btRigidBody::btRigidBodyConstructionInfo info(1.0f, 0, shape, inertia);
+		info.m_startWorldTransform.setOrigin(btVector3(box.x, box.y, box.z));
+		info.m_restitution = 0.6f;
+		info.m_friction = 0.6f;
+		btRigidBody* body = new btRigidBody(info);
+		body->setLinearVelocity(btVector3(rand() % 2001 - 1000, rand() % 2001 - 1000, rand() % 2001 - 1000));
+		if(box.isMine){
+			body->applyImpulse(btVector3(900, 900, 900), btVector3(900, 900, 900));
+		}
+		body->setSleepingThresholds(PHYSICS_SLEEP_LINEAR_VELOCITY, PHYSICS_SLEEP_ANGULAR_VELOCITY);
+		world.addRigidBody(body);
+		bodies.push_back(body);
+	}
+
+	int frames = mSeconds / FRAME_TIME;
+	vector<double> stepTimes;
+	stepTimes.reserve(frames);
+	double totalPairs = 0;
+	int maxPairs = 0;
+	for(int frame = 0; frame < frames; frame++){
+		chrono::steady_clock::time_point start = chrono::steady_clock::now();
+		world.stepSimulation(FRAME_TIME, PHYSICS_MAX_SUBSTEPS, PHYSICS_TIMESTEP);
+
+		//Bodies that left the world bounds are removed, as in MineSweeper::stepPhysics
+		for(int i = 0; i < bodies.size(); ){
+			const btVector3 &origin = bodies[i]->getWorldTransform().getOrigin();
+			if(PHYSICS_WORLD_BOUNDS.contains(Ogre::Vector3(origin.x(), origin.y(), origin.z()))){
+				i++;
+				continue;
+			}
+			world.removeRigidBody(bodies[i]);
+			delete bodies[i];
+			bodies[i] = bodies.back();
+			bodies.pop_back();
+		}
+		stepTimes.push_back(chrono::duration<double, milli>(chrono::steady_clock::now() - start).count());
+		peakMemory = std::max(peakMemory, residentMemory());
+
+		int pairs = broadphase->getOverlappingPairCache()->getNumOverlappingPairs();
+		totalPairs += pairs;
+		maxPairs = std::max(maxPairs, pairs);
+	}
+	long memory = peakMemory - startMemory;
+
+	sort(stepTimes.begin(), stepTimes.end());
+	printf("%-16s %7d %9.3f %9.3f %9.3f %9.3f %10.1f %10d %10ld\n",
+			broadphaseType == DBVT ? "dbvt" : "sweep-and-prune",
+			threads,
+			stepTimes[stepTimes.size() / 2],
+			stepTimes[stepTimes.size() * 9 / 10],
+			stepTimes[stepTimes.size() * 99 / 100],
+			stepTimes.back(),
+			totalPairs / frames,
+			maxPairs,
+			memory);
+
+	for(int i = 0; i < bodies.size(); i++){
+		world.removeRigidBody(bodies[i]);
+		delete bodies[i];
+	}
+	for(int i = 0; i < shapes.size(); i++){
+		delete shapes[i];
+	}
+	delete solver;
+	delete broadphase;
+}
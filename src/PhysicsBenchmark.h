@@ -0,0 +1,97 @@
+//============================================================================
+// Name        : PhysicsBenchmark.h
+// Author      : Amrit Dhakal
+// Version     : 1.0
+// Copyright   : © Amrit Dhakal 2015. All right reserved. :D
+// Description : Headless benchmark of the game over explosion
+//============================================================================
+
+#ifndef PHYSICSBENCHMARK_H_
+#define PHYSICSBENCHMARK_H_
+
+#include <string>
+#include <vector>
+
+/**
+ * Class PhysicsBenchmark builds the bodies setupPhysicsObjects builds for a board,
+ * without any renderer, steps them the way the game does and reports the step
+ * times, the broadphase pair counts and the memory used, once per broadphase and
+ * number of threads solving the islands (1, 2, 4... up to one per core; 1 is the
+ * plain Bullet solver), which shows how the step time scales with the cores.
+ * Every run is made in a process of its own, so the peak memory reported is that
+ * of the run: the most it added to the resident memory it started with, sampled
+ * after every frame.
+ *
+ * Run with: MineSweeper --bench-physics [level] [seconds] [revealed]
+ * 		level: the level whose board is exploded (default MAX_LEVEL)
+ * 		seconds: simulated time (default 10)
+ * 		revealed: fraction of the safe cells revealed at game over (default 0.5)
+ */
+class PhysicsBenchmark {
+public:
+	enum Broadphase {
+		DBVT,
+		SWEEP_AND_PRUNE
+	};
+
+	/**
+	 * Constructor:
+	 * 		parameter:
+	 * 			level: the level whose board is exploded
+	 * 			seconds: simulated time
+	 * 			revealed: fraction of the safe cells revealed at game over
+	 */
+	PhysicsBenchmark(int level, double seconds, double revealed);
+
+	/**
+	 * run: runs the benchmark with every broadphase and prints the results
+	 */
+	void run();
+
+	/**
+	 * main: parses the command line arguments following --bench-physics and runs the benchmark
+	 * 		return: the exit code of the program
+	 */
+	static int main(int argc, char *argv[]);
+
+protected:
+
+	/**
+	 * A box to be simulated
+	 */
+	struct BoxSpec {
+		float halfX, halfY, halfZ;
+		float x, y, z;
+		bool isMine;
+	};
+
+	/**
+	 * Builds the boxes of the board at game over
+	 */
+	void buildBoxes();
+
+	/**
+	 * Runs runWith in a child process, so its peak memory is its own
+	 */
+	void runInChild(Broadphase broadphase, int threads);
+
+	/**
+	 * Simulates the boxes with the broadphase and threads solving the islands, and
+	 * prints the results
+	 */
+	void runWith(Broadphase broadphase, int threads);
+
+	//Level of the board
+	int mLevel;
+
+	//Simulated time
+	double mSeconds;
+
+	//Fraction of the safe cells revealed
+	double mRevealed;
+
+	//Boxes of the board
+	std::vector<BoxSpec> mBoxes;
+};
+
+#endif /* PHYSICSBENCHMARK_H_ */
@@ -0,0 +1,124 @@
+//============================================================================
+// Name        : PhysicsStepper.cpp
+// Author      : Amrit Dhakal
+// Version     : 1.0
+// Copyright   : © Amrit Dhakal 2015. All right reserved. :D
+// Description : Steps a Bullet world on a worker thread
+//============================================================================
+
+#include "PhysicsStepper.h"
+#include "Profiler.h"
+
+using namespace std;
+
+PhysicsStepper::PhysicsStepper(bool threaded, int solverThreads):
+					mThreaded(threaded),
+					mSolver(solverThreads != 1 ? new IslandSolver(solverThreads) : 0),
+					mFront(0),
+					mWorld(0),
+					mElapsedTime(0),
+					mMaxSubSteps(1),
+					mFixedTimeStep(1.0 / 60.0),
+					mBusy(false),
+					mStop(false)
+{
+	if(mThreaded){
+		mThread = thread(&PhysicsStepper::run, this);
+	}
+}
+
+PhysicsStepper::~PhysicsStepper() {
+	wait();
+	if(mThreaded){
+		{
+			lock_guard<mutex> lock(mMutex);
+			mStop = true;
+		}
+		mStepRequested.notify_one();
+		mThread.join();
+	}
+	delete mSolver;
+}
+
+void PhysicsStepper::step(btDynamicsWorld* world, btScalar elapsedTime, int maxSubSteps, btScalar fixedTimeStep){
+	//The world is made again for every game
+	if(mSolver && world->getConstraintSolver() != mSolver){
+		world->setConstraintSolver(mSolver);
+	}
+	if(!mThreaded){
+		//The results are readable right away
+		PROFILE_SCOPE("stepSimulation");
+		world->stepSimulation(elapsedTime, maxSubSteps, fixedTimeStep);
+		mFront = 1 - mFront;
+		return;
+	}
+	{
+		lock_guard<mutex> lock(mMutex);
+		mWorld = world;
+		mElapsedTime = elapsedTime;
+		mMaxSubSteps = maxSubSteps;
+		mFixedTimeStep = fixedTimeStep;
+		mBusy = true;
+	}
+	mStepRequested.notify_one();
+}
+
+void PhysicsStepper::wait(){
+	if(!mThreaded){
+		return;
+	}
+	unique_lock<mutex> lock(mMutex);
+	mStepDone.wait(lock, [this]{ return !mBusy; });
+}
+
+void PhysicsStepper::run(){
+	PROFILE_THREAD("physics");
+	unique_lock<mutex> lock(mMutex);
+	while(true){
+		mStepRequested.wait(lock, [this]{ return mBusy || mStop; });
+		if(mStop){
+			return;
+		}
+		lock.unlock();
+		{
+			PROFILE_SCOPE("stepSimulation");
+			mWorld->stepSimulation(mElapsedTime, mMaxSubSteps, mFixedTimeStep);
+		}
+		lock.lock();
+		mBusy = false;
+		mStepDone.notify_one();
+	}
+}
+
+BufferedMotionState::BufferedMotionState(const PhysicsStepper* stepper, const btTransform &start):
+					mStepper(stepper)
+{
+	mTransforms[0] = start;
+	mTransforms[1] = start;
+	mWritten[0] = false;
+	mWritten[1] = false;
+}
+
+BufferedMotionState::~BufferedMotionState() {
+}
+
+void BufferedMotionState::getWorldTransform(btTransform &worldTrans) const{
+	//Called by the worker, so it reads the buffer the worker writes
+	worldTrans = mTransforms[1 - mStepper->getFrontBuffer()];
+}
+
+void BufferedMotionState::setWorldTransform(const btTransform &worldTrans){
+	int back = 1 - mStepper->getFrontBuffer();
+	mTransforms[back] = worldTrans;
+	mWritten[back] = true;
+}
+
+bool BufferedMotionState::takeFrontTransform(btTransform &transform){
+	int front = mStepper->getFrontBuffer();
+	if(!mWritten[front]){
+		return false;
+	}
+	mWritten[front] = false;
+	transform = mTransforms[front];
+	return true;
+}
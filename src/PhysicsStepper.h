@@ -0,0 +1,164 @@
+//============================================================================
+// Name        : PhysicsStepper.h
+// Author      : Amrit Dhakal
+// Version     : 1.0
+// Copyright   : © Amrit Dhakal 2015. All right reserved. :D
+// Description : Steps a Bullet world on a worker thread
+//============================================================================
+
+#ifndef PHYSICSSTEPPER_H_
+#define PHYSICSSTEPPER_H_
+
+#include <btBulletDynamicsCommon.h>
+#include "IslandSolver.h"
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+/**
+ * Class PhysicsStepper steps a Bullet world on its own thread while the render
+ * thread draws the frame. The bodies of the world use BufferedMotionStates, which
+ * write the transforms of a step into a back buffer; the render thread reads the
+ * front buffer, which holds the transforms of the previous step. Bullet already
+ * hands the motion states transforms interpolated between fixed steps.
+ *
+ * The render thread calls, every frame:
+ * 		wait(), swapBuffers(), then change the world (add or remove bodies),
+ * 		step(), then read the front buffers
+ *
+ * The world must not be touched between step() and wait().
+ *
+ * The constraints of a step are solved island by island on a pool of threads (see
+ * IslandSolver), so the step gets shorter the more cores there are.
+ */
+class PhysicsStepper {
+public:
+
+	/**
+	 * Constructor:
+	 * 		parameter:
+	 * 			threaded: true to step on a worker thread, false to step in step() itself
+	 * 			solverThreads: threads solving the islands of a step, 0 for one per core,
+	 * 				1 to keep the solver of the world
+	 */
+	PhysicsStepper(bool threaded, int solverThreads);
+
+	/**
+	 * Destructor: waits for the current step and stops the worker thread
+	 */
+	virtual ~PhysicsStepper();
+
+	/**
+	 * step: starts simulating the elapsed time in fixed steps
+	 * 		parameter:
+	 * 			world: the world to be stepped
+	 * 			elapsedTime: time since the last step (seconds)
+	 * 			maxSubSteps: maximum number of fixed steps
+	 * 			fixedTimeStep: length of one fixed step (seconds)
+	 */
+	void step(btDynamicsWorld* world, btScalar elapsedTime, int maxSubSteps, btScalar fixedTimeStep);
+
+	/**
+	 * wait: waits until the step started by step() is done
+	 */
+	void wait();
+
+	/**
+	 * swapBuffers: makes the transforms of the last step readable (call after wait).
+	 * Without a worker thread step() does this itself.
+	 */
+	void swapBuffers(){
+		if(mThreaded){
+			mFront = 1 - mFront;
+		}
+	}
+
+	/**
+	 * getFrontBuffer: returns the index of the buffer the render thread reads
+	 */
+	int getFrontBuffer() const {
+		return mFront;
+	}
+
+	/**
+	 * isThreaded: returns true if the world is stepped on a worker thread
+	 */
+	bool isThreaded() const {
+		return mThreaded;
+	}
+
+protected:
+
+	/**
+	 * Body of the worker thread
+	 */
+	void run();
+
+	//Is the world stepped on the worker thread?
+	bool mThreaded;
+
+	//Solver installed in the stepped worlds, 0 to keep their own
+	IslandSolver* mSolver;
+
+	//Buffer read by the render thread (the worker writes the other one)
+	int mFront;
+
+	//Step to be done by the worker
+	btDynamicsWorld* mWorld;
+	btScalar mElapsedTime;
+	int mMaxSubSteps;
+	btScalar mFixedTimeStep;
+
+	//Is a step requested or running?
+	bool mBusy;
+
+	//Should the worker stop?
+	bool mStop;
+
+	std::mutex mMutex;
+	std::condition_variable mStepRequested;
+	std::condition_variable mStepDone;
+	std::thread mThread;
+};
+
+/**
+ * Class BufferedMotionState receives the transforms of a body from Bullet into the
+ * back buffer of the PhysicsStepper, so the render thread can read the front buffer
+ * while the next step runs.
+ */
+class BufferedMotionState : public btMotionState {
+public:
+
+	/**
+	 * Constructor:
+	 * 		parameter:
+	 * 			stepper: the stepper of the body's world
+	 * 			start: the initial transform of the body
+	 */
+	BufferedMotionState(const PhysicsStepper* stepper, const btTransform &start);
+
+	virtual ~BufferedMotionState();
+
+	virtual void getWorldTransform(btTransform &worldTrans) const;
+
+	virtual void setWorldTransform(const btTransform &worldTrans);
+
+	/**
+	 * takeFrontTransform: reads the transform of the last finished step
+	 * 		parameter:
+	 * 			transform: set to the transform if the body moved in the last step
+	 * 		return: true if the body moved in the last step
+	 */
+	bool takeFrontTransform(btTransform &transform);
+
+protected:
+	const PhysicsStepper* mStepper;
+
+	//Transform written to each buffer
+	btTransform mTransforms[2];
+
+	//Has the buffer been written since it was last read?
+	bool mWritten[2];
+};
+
+#endif /* PHYSICSSTEPPER_H_ */
@@ -0,0 +1,213 @@
+//============================================================================
+// Name        : Profiler.cpp
+// Author      : Amrit Dhakal
+// Version     : 1.0
+// Copyright   : © Amrit Dhakal 2015. All right reserved. :D
+// Description : Scoped timers for the hot paths of the game
+//============================================================================
+
+#include "Profiler.h"
+
+#ifdef MINESWEEPER_PROFILING
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+
+using namespace std;
+
+//Least time between two traces written because of a slow frame
+static const uint64_t TRACE_INTERVAL = 5000000000ULL;
+
+//Time over which the breakdown is averaged
+static const uint64_t BREAKDOWN_INTERVAL = 1000000000ULL;
+
+static const chrono::steady_clock::time_point sEpoch = chrono::steady_clock::now();
+
+static thread_local ProfileBuffer* tBuffer = 0;
+
+mutex Profiler::sMutex;
+vector<ProfileBuffer*> Profiler::sBuffers;
+vector<uint64_t> Profiler::sCursors;
+vector<pair<const char*, uint64_t> > Profiler::sTotals;
+vector<pair<string, double> > Profiler::sBreakdown;
+uint64_t Profiler::sFrameStart = 0;
+uint64_t Profiler::sBreakdownStart = 0;
+uint64_t Profiler::sLastTrace = 0;
+int Profiler::sFrames = 0;
+uint64_t Profiler::sBudget = 0;
+string Profiler::sTracePrefix = "profile";
+int Profiler::sNumTraces = 0;
+
+ProfileBuffer::ProfileBuffer(int threadId):
+					mSlots(CAPACITY),
+					mHead(0),
+					mThreadId(threadId),
+					mThreadName("thread " + to_string(threadId))
+{
+}
+
+void ProfileBuffer::read(uint64_t &cursor, vector<Sample> &out) const{
+	uint64_t head = mHead.load(memory_order_acquire);
+	uint64_t first = max(cursor, head > CAPACITY ? head - CAPACITY : 0);
+	size_t begin = out.size();
+	for(uint64_t i = first; i < head; i++){
+		const Slot &slot = mSlots[i & (CAPACITY - 1)];
+		Sample sample;
+		sample.name = slot.name.load(memory_order_relaxed);
+		sample.start = slot.start.load(memory_order_relaxed);
+		sample.end = slot.end.load(memory_order_relaxed);
+		out.push_back(sample);
+	}
+	//Slots the writer reached while they were copied hold newer samples: drop them
+	atomic_thread_fence(memory_order_acquire);
+	uint64_t newHead = mHead.load(memory_order_relaxed);
+	if(newHead > first + CAPACITY){
+		uint64_t lost = min(newHead - CAPACITY - first, head - first);
+		out.erase(out.begin() + begin, out.begin() + begin + lost);
+	}
+	cursor = head;
+}
+
+uint64_t Profiler::now(){
+	return chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - sEpoch).count();
+}
+
+ProfileBuffer* Profiler::threadBuffer(){
+	if(!tBuffer){
+		//Once per thread; the buffers live as long as the program
+		lock_guard<mutex> lock(sMutex);
+		tBuffer = new ProfileBuffer(sBuffers.size());
+		sBuffers.push_back(tBuffer);
+		sCursors.push_back(0);
+	}
+	return tBuffer;
+}
+
+void Profiler::setThreadName(const char* name){
+	ProfileBuffer* buffer = threadBuffer();
+	lock_guard<mutex> lock(sMutex);
+	buffer->setThreadName(name);
+}
+
+void Profiler::setFrameBudget(double seconds){
+	sBudget = seconds * 1e9;
+}
+
+void Profiler::setTracePrefix(const string &prefix){
+	sTracePrefix = prefix;
+}
+
+/**
+ * Orders the samples of a thread by start, outer scopes before the ones they contain
+ */
+static bool startsBefore(const ProfileBuffer::Sample &a, const ProfileBuffer::Sample &b){
+	return a.start < b.start || (a.start == b.start && a.end > b.end);
+}
+
+string Profiler::frame(){
+	threadBuffer();
+	uint64_t frameEnd = now();
+	uint64_t frameTime = frameEnd - sFrameStart;
+
+	vector<ProfileBuffer::Sample> samples;
+	vector<pair<const char*, uint64_t> > lastEnds;
+	{
+		lock_guard<mutex> lock(sMutex);
+		for(int b = 0; b < sBuffers.size(); b++){
+			samples.clear();
+			sBuffers[b]->read(sCursors[b], samples);
+			sort(samples.begin(), samples.end(), startsBefore);
+
+			//A sample inside an earlier one of the same name is a recursive call
+			lastEnds.clear();
+			for(int i = 0; i < samples.size(); i++){
+				const ProfileBuffer::Sample &sample = samples[i];
+				int n = 0;
+				while(n < lastEnds.size() && lastEnds[n].first != sample.name){
+					n++;
+				}
+				if(n == lastEnds.size()){
+					lastEnds.push_back(make_pair(sample.name, 0));
+				}
+				if(sample.start < lastEnds[n].second){
+					continue;
+				}
+				lastEnds[n].second = sample.end;
+
+				int t = 0;
+				while(t < sTotals.size() && sTotals[t].first != sample.name){
+					t++;
+				}
+				if(t == sTotals.size()){
+					sTotals.push_back(make_pair(sample.name, 0));
+				}
+				sTotals[t].second += sample.end - sample.start;
+			}
+		}
+	}
+	sFrames++;
+
+	if(frameEnd - sBreakdownStart >= BREAKDOWN_INTERVAL){
+		sBreakdown.clear();
+		for(int t = 0; t < sTotals.size(); t++){
+			sBreakdown.push_back(make_pair(string(sTotals[t].first), sTotals[t].second / 1e6 / sFrames));
+		}
+		sort(sBreakdown.begin(), sBreakdown.end());
+		sTotals.clear();
+		sFrames = 0;
+		sBreakdownStart = frameEnd;
+	}
+
+	string filename;
+	if(sBudget > 0 && sFrameStart > 0 && frameTime > sBudget
+			&& (sLastTrace == 0 || frameEnd - sLastTrace >= TRACE_INTERVAL)){
+		filename = sTracePrefix + "-" + to_string(sNumTraces++) + ".json";
+		if(!writeTrace(filename)){
+			filename = "";
+		}
+		//The trace is written inside this frame, so the next frame starts after it
+		frameEnd = now();
+		sLastTrace = frameEnd;
+	}
+	sFrameStart = frameEnd;
+	return filename;
+}
+
+bool Profiler::writeTrace(const string &filename){
+	ofstream out(filename.c_str());
+	if(!out.is_open()){
+		cerr << "File " << filename << " could not be opened." << endl;
+		return false;
+	}
+	out << fixed << setprecision(3);
+	out << "{\"traceEvents\":[\n";
+	bool first = true;
+	vector<ProfileBuffer::Sample> samples;
+	lock_guard<mutex> lock(sMutex);
+	for(int b = 0; b < sBuffers.size(); b++){
+		const ProfileBuffer* buffer = sBuffers[b];
+		out << (first ? "" : ",\n") << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":"
+				<< buffer->getThreadId() << ",\"args\":{\"name\":\"" << buffer->getThreadName() << "\"}}";
+		first = false;
+
+		uint64_t cursor = 0;
+		samples.clear();
+		buffer->read(cursor, samples);
+		for(int i = 0; i < samples.size(); i++){
+			out << ",\n{\"name\":\"" << samples[i].name << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << buffer->getThreadId()
+					<< ",\"ts\":" << samples[i].start / 1000.0
+					<< ",\"dur\":" << (samples[i].end - samples[i].start) / 1000.0 << "}";
+		}
+	}
+	out << "\n]}\n";
+	return out.good();
+}
+
+vector<pair<string, double> > Profiler::getBreakdown(){
+	return sBreakdown;
+}
+
+#endif /* MINESWEEPER_PROFILING */
@@ -0,0 +1,195 @@
+//============================================================================
+// Name        : Profiler.h
+// Author      : Amrit Dhakal
+// Version     : 1.0
+// Copyright   : © Amrit Dhakal 2015. All right reserved. :D
+// Description : Scoped timers for the hot paths of the game
+//============================================================================
+
+#ifndef PROFILER_H_
+#define PROFILER_H_
+
+/**
+ * The profiler is compiled in only when MINESWEEPER_PROFILING is defined
+ * (add -DMINESWEEPER_PROFILING to the compiler flags); otherwise every
+ * PROFILE_ macro expands to nothing and none of the code below is built.
+ *
+ * 		PROFILE_SCOPE("name"): times the rest of the enclosing block
+ * 		PROFILE_THREAD("name"): names the calling thread in the trace
+ *
+ * The name must be a string literal, only its pointer is stored.
+ */
+#ifdef MINESWEEPER_PROFILING
+
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+#include <stdint.h>
+
+#define PROFILE_CONCAT_(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_(a, b)
+#define PROFILE_SCOPE(name) ProfileScope PROFILE_CONCAT(profileScope, __LINE__)(name)
+#define PROFILE_THREAD(name) Profiler::setThreadName(name)
+
+/**
+ * Ring buffer of the samples of one thread. Only the owning thread writes it,
+ * any thread may read it; a reader detects the samples overwritten while it was
+ * copying them by reading the head again and drops them.
+ */
+class ProfileBuffer {
+public:
+	//Number of samples kept, a power of two
+	static const uint64_t CAPACITY = 1 << 16;
+
+	ProfileBuffer(int threadId);
+
+	/**
+	 * push: records a sample (owning thread only)
+	 */
+	void push(const char* name, uint64_t start, uint64_t end){
+		uint64_t head = mHead.load(std::memory_order_relaxed);
+		Slot &slot = mSlots[head & (CAPACITY - 1)];
+		slot.name.store(name, std::memory_order_relaxed);
+		slot.start.store(start, std::memory_order_relaxed);
+		slot.end.store(end, std::memory_order_relaxed);
+		mHead.store(head + 1, std::memory_order_release);
+	}
+
+	/**
+	 * read: copies the samples pushed since cursor into out and moves cursor past them
+	 */
+	struct Sample {
+		const char* name;
+		uint64_t start;
+		uint64_t end;
+	};
+	void read(uint64_t &cursor, std::vector<Sample> &out) const;
+
+	int getThreadId() const {
+		return mThreadId;
+	}
+
+	const std::string &getThreadName() const {
+		return mThreadName;
+	}
+
+	void setThreadName(const std::string &name){
+		mThreadName = name;
+	}
+
+private:
+	struct Slot {
+		std::atomic<const char*> name;
+		std::atomic<uint64_t> start;
+		std::atomic<uint64_t> end;
+	};
+
+	std::vector<Slot> mSlots;
+	std::atomic<uint64_t> mHead;
+	int mThreadId;
+	std::string mThreadName;
+};
+
+/**
+ * Class Profiler collects the samples of every thread, keeps the time spent in
+ * each scope per frame for the overlay and writes Chrome trace files
+ * (load them in chrome://tracing or https://ui.perfetto.dev).
+ */
+class Profiler {
+public:
+
+	/**
+	 * now: returns the time in nanoseconds since the profiler started
+	 */
+	static uint64_t now();
+
+	/**
+	 * record: adds a sample to the calling thread's buffer
+	 */
+	static void record(const char* name, uint64_t start, uint64_t end){
+		threadBuffer()->push(name, start, end);
+	}
+
+	/**
+	 * setThreadName: names the calling thread in the traces
+	 */
+	static void setThreadName(const char* name);
+
+	/**
+	 * frame: marks the start of a frame (main thread only). The samples of the
+	 * previous frame are added to the breakdown, and if that frame took longer than
+	 * the budget a trace is written, at most once every few seconds.
+	 * 		return: the file the trace was written to, empty if none was written
+	 */
+	static std::string frame();
+
+	/**
+	 * setFrameBudget: sets the frame time in seconds above which a trace is written,
+	 * 0 to never write one automatically
+	 */
+	static void setFrameBudget(double seconds);
+
+	/**
+	 * setTracePrefix: sets the start of the names of the trace files
+	 */
+	static void setTracePrefix(const std::string &prefix);
+
+	/**
+	 * writeTrace: writes every sample still in the buffers to a Chrome trace file
+	 * 		return: true if the file was written
+	 */
+	static bool writeTrace(const std::string &filename);
+
+	/**
+	 * getBreakdown: returns the average milliseconds per frame spent in each scope
+	 * over the last second, by scope name. Recursive calls are counted once.
+	 */
+	static std::vector<std::pair<std::string, double> > getBreakdown();
+
+private:
+	static ProfileBuffer* threadBuffer();
+
+	static std::mutex sMutex;
+	static std::vector<ProfileBuffer*> sBuffers;
+	static std::vector<uint64_t> sCursors;
+	static std::vector<std::pair<const char*, uint64_t> > sTotals;
+	static std::vector<std::pair<std::string, double> > sBreakdown;
+	static uint64_t sFrameStart;
+	static uint64_t sBreakdownStart;
+	static uint64_t sLastTrace;
+	static int sFrames;
+	static uint64_t sBudget;
+	static std::string sTracePrefix;
+	static int sNumTraces;
+};
+
+/**
+ * Times its own lifetime
+ */
+class ProfileScope {
+public:
+	ProfileScope(const char* name):
+		mName(name),
+		mStart(Profiler::now())
+	{
+	}
+
+	~ProfileScope(){
+		Profiler::record(mName, mStart, Profiler::now());
+	}
+
+private:
+	const char* mName;
+	uint64_t mStart;
+};
+
+#else
+
+#define PROFILE_SCOPE(name)
+#define PROFILE_THREAD(name)
+
+#endif /* MINESWEEPER_PROFILING */
+
+#endif /* PROFILER_H_ */
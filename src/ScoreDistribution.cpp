@@ -0,0 +1,110 @@
+//============================================================================
+// Name        : ScoreDistribution.cpp
+// Author      : Amrit Dhakal
+// Version     : 1.0
+// Copyright   : © Amrit Dhakal 2015. All right reserved. :D
+// Description : Per level score distributions stored in score sketches
+//============================================================================
+
+#include "ScoreDistribution.h"
+
+#include <fstream>
+
+using namespace std;
+
+ScoreDistribution::ScoreDistribution(int numLevels):
+					m_sketches(numLevels + 1)
+{
+}
+
+ScoreDistribution::~ScoreDistribution() {
+}
+
+bool ScoreDistribution::isValidLevel(int level) const{
+	return level > 0 && level < (int)m_sketches.size();
+}
+
+void ScoreDistribution::addScore(int level, int score){
+	if(isValidLevel(level)){
+		m_sketches[level].add(score);
+	}
+}
+
+double ScoreDistribution::getPercentile(int level, int score) const{
+	if(!isValidLevel(level)){
+		return 0;
+	}
+	return m_sketches[level].getPercentile(score);
+}
+
+long long ScoreDistribution::getGamesPlayed(int level) const{
+	if(!isValidLevel(level)){
+		return 0;
+	}
+	return m_sketches[level].getCount();
+}
+
+const ScoreSketch& ScoreDistribution::getSketch(int level) const{
+	return m_sketches.at(level);
+}
+
+void ScoreDistribution::clear(){
+	for(int i = 0; i < m_sketches.size(); i++){
+		m_sketches[i].clear();
+	}
+}
+
+bool ScoreDistribution::readFromFile(const string &filename){
+	clear();
+	return mergeFromFile(filename);
+}
+
+bool ScoreDistribution::mergeFromFile(const string &filename){
+	ifstream in(filename.c_str(), ios::in);
+	if(!in){
+		cerr << "File " << filename << " could not be opened." << endl;
+		return false;
+	}
+	int numLevels;
+	if(!(in >> numLevels)){
+		return false;
+	}
+	//The file is merged only once all of it is read, a bad file changes nothing
+	vector<ScoreSketch> sketches(m_sketches.size());
+	for(int i = 0; i < numLevels; i++){
+		int level;
+		if(!(in >> level)){
+			return false;
+		}
+		//Levels this version does not know about are read and thrown away
+		ScoreSketch sketch;
+		if(!sketch.read(in)){
+			cerr << "File " << filename << " is not a valid score distribution." << endl;
+			return false;
+		}
+		if(isValidLevel(level)){
+			sketches[level].merge(sketch);
+		}
+	}
+	in.close();
+	for(int level = 0; level < m_sketches.size(); level++){
+		m_sketches[level].merge(sketches[level]);
+	}
+	return true;
+}
+
+void ScoreDistribution::writeToFile(const string &filename) const{
+	ofstream out(filename.c_str(), ios::out);
+
+	if(!out){
+		cerr << "File " << filename << " could not be opened for writing." << endl;
+		return;
+	}
+
+	out << m_sketches.size() - 1 << endl;
+	for(int level = 1; level < m_sketches.size(); level++){
+		out << level << endl;
+		m_sketches[level].write(out);
+	}
+	out.close();
+}
@@ -0,0 +1,97 @@
+//============================================================================
+// Name        : ScoreDistribution.h
+// Author      : Amrit Dhakal
+// Version     : 1.0
+// Copyright   : © Amrit Dhakal 2015. All right reserved. :D
+// Description : Per level score distributions stored in score sketches
+//============================================================================
+
+#ifndef SCOREDISTRIBUTION_H_
+#define SCOREDISTRIBUTION_H_
+
+#include "ScoreSketch.h"
+#include <string>
+#include <vector>
+
+/**
+ * Class ScoreDistribution keeps one ScoreSketch per level so that a score can be
+ * ranked against every game that reached the same level.
+ */
+class ScoreDistribution {
+public:
+
+	/**
+	 * Constructor:
+	 * 		parameter:
+	 * 			numLevels: the highest level of the game
+	 */
+	ScoreDistribution(int numLevels);
+
+	virtual ~ScoreDistribution();
+
+	/**
+	 * addScore: records the score of a game at the given level
+	 * 		parameter:
+	 * 			level: the level the game was at
+	 * 			score: the score of the game
+	 */
+	void addScore(int level, int score);
+
+	/**
+	 * getPercentile: returns the fraction of games at the given level with lower score
+	 * 		parameter:
+	 * 			level: the level to rank the score in
+	 * 			score: the score to be ranked
+	 * 		return: a number between 0 and 1
+	 */
+	double getPercentile(int level, int score) const;
+
+	/**
+	 * getGamesPlayed: returns the number of games recorded at the given level
+	 */
+	long long getGamesPlayed(int level) const;
+
+	/**
+	 * getSketch: returns the sketch of the given level
+	 */
+	const ScoreSketch& getSketch(int level) const;
+
+	/**
+	 * clear: removes every recorded score
+	 */
+	void clear();
+
+	/**
+	 * readFromFile: replaces the distributions with the ones stored in the file
+	 * 		return:
+	 * 			true: the file was successfully opened and read
+	 * 			false: the file open or read failed.
+	 */
+	bool readFromFile(const std::string &filename);
+
+	/**
+	 * mergeFromFile: adds the distributions stored in the file (e.g. copied from
+	 * another machine) to the current distributions, unless the file cannot be read
+	 * 		return:
+	 * 			true: the file was successfully opened and read
+	 * 			false: the file open or read failed.
+	 */
+	bool mergeFromFile(const std::string &filename);
+
+	/**
+	 * writeToFile: writes the distributions to the file
+	 */
+	void writeToFile(const std::string &filename) const;
+
+protected:
+
+	/**
+	 * Returns true if the level has a sketch
+	 */
+	bool isValidLevel(int level) const;
+
+	//Sketch for each level, index 0 is unused so that the level can be used as index
+	std::vector<ScoreSketch> m_sketches;
+};
+
+#endif /* SCOREDISTRIBUTION_H_ */
@@ -0,0 +1,125 @@
+//============================================================================
+// Name        : ScoreSketch.cpp
+// Author      : Amrit Dhakal
+// Version     : 1.0
+// Copyright   : © Amrit Dhakal 2015. All right reserved. :D
+// Description : Constant memory, mergeable sketch of a score distribution
+//============================================================================
+
+#include "ScoreSketch.h"
+
+#include <math.h>
+#include <string.h>
+#include <limits.h>
+
+using namespace std;
+
+const double ScoreSketch::GAMMA = 1.02;
+
+//1/log(GAMMA) so that bucketIndex needs a single log and a multiplication
+static const double INV_LOG_GAMMA = 1.0 / log(ScoreSketch::GAMMA);
+
+ScoreSketch::ScoreSketch(){
+	clear();
+}
+
+void ScoreSketch::clear(){
+	memset(m_buckets, 0, sizeof(m_buckets));
+	m_count = 0;
+}
+
+int ScoreSketch::bucketIndex(int score){
+	if(score <= 0){
+		return 0;
+	}
+	//Bucket i (i >= 1) holds the scores in [GAMMA^(i-1), GAMMA^i)
+	int index = 1 + (int)(log((double)score) * INV_LOG_GAMMA);
+	if(index >= NUM_BUCKETS){
+		index = NUM_BUCKETS - 1;
+	}
+	return index;
+}
+
+int ScoreSketch::bucketValue(int index){
+	if(index <= 0){
+		return 0;
+	}
+	//Geometric middle of the bucket keeps the relative error symmetric
+	double value = pow(GAMMA, index - 0.5) + 0.5;
+	return value >= INT_MAX ? INT_MAX : (int)value;
+}
+
+void ScoreSketch::add(int score){
+	++m_buckets[bucketIndex(score)];
+	++m_count;
+}
+
+void ScoreSketch::merge(const ScoreSketch &other){
+	for(int i = 0; i < NUM_BUCKETS; i++){
+		m_buckets[i] += other.m_buckets[i];
+	}
+	m_count += other.m_count;
+}
+
+double ScoreSketch::getPercentile(int score) const{
+	if(m_count == 0){
+		return 0;
+	}
+	int index = bucketIndex(score);
+	long long below = 0;
+	for(int i = 0; i < index; i++){
+		below += m_buckets[i];
+	}
+	//Scores in the same bucket are considered half below and half above
+	return (below + m_buckets[index] / 2.0) / m_count;
+}
+
+int ScoreSketch::getQuantile(double q) const{
+	if(m_count == 0){
+		return 0;
+	}
+	long long rank = (long long)(q * (m_count - 1));
+	long long seen = 0;
+	for(int i = 0; i < NUM_BUCKETS; i++){
+		seen += m_buckets[i];
+		if(seen > rank){
+			return bucketValue(i);
+		}
+	}
+	return bucketValue(NUM_BUCKETS - 1);
+}
+
+void ScoreSketch::write(ostream &out) const{
+	int nonEmpty = 0;
+	for(int i = 0; i < NUM_BUCKETS; i++){
+		if(m_buckets[i] != 0){
+			nonEmpty++;
+		}
+	}
+	out << nonEmpty << endl;
+	for(int i = 0; i < NUM_BUCKETS; i++){
+		if(m_buckets[i] != 0){
+			out << i << " " << m_buckets[i] << endl;
+		}
+	}
+}
+
+bool ScoreSketch::read(istream &in){
+	int nonEmpty;
+	if(!(in >> nonEmpty)){
+		return false;
+	}
+	//Merged only once the whole sketch is read
+	ScoreSketch sketch;
+	for(int i = 0; i < nonEmpty; i++){
+		int index;
+		unsigned int count;
+		if(!(in >> index >> count) || index < 0 || index >= NUM_BUCKETS){
+			return false;
+		}
+		sketch.m_buckets[index] += count;
+		sketch.m_count += count;
+	}
+	merge(sketch);
+	return true;
+}
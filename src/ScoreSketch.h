@@ -0,0 +1,110 @@
+//============================================================================
+// Name        : ScoreSketch.h
+// Author      : Amrit Dhakal
+// Version     : 1.0
+// Copyright   : © Amrit Dhakal 2015. All right reserved. :D
+// Description : Constant memory, mergeable sketch of a score distribution
+//============================================================================
+
+#ifndef SCORESKETCH_H_
+#define SCORESKETCH_H_
+
+#include <iostream>
+
+/**
+ * Class ScoreSketch keeps an approximate distribution of every score ever added
+ * in a fixed number of logarithmically sized buckets. Each bucket covers scores
+ * that are within 2% of each other, so the score returned for a quantile is within
+ * about 1% of the true score at that quantile, no matter how many scores are added.
+ * The error is relative to the score, not to the rank: ranks are only as exact as the
+ * buckets are narrow. Two sketches can be merged by adding their buckets.
+ */
+class ScoreSketch {
+public:
+	//Number of buckets (covers every score up to ~2^31 with GAMMA below)
+	static const int NUM_BUCKETS = 1100;
+
+	//Ratio between the upper and lower bound of a bucket
+	static const double GAMMA;
+
+	/**
+	 * Default constructor: creates an empty sketch
+	 */
+	ScoreSketch();
+
+	/**
+	 * add: records a score in the sketch
+	 * 		parameter:
+	 * 			score: the score to be recorded (negative scores are recorded as 0)
+	 */
+	void add(int score);
+
+	/**
+	 * merge: adds all the scores recorded in the other sketch to this sketch
+	 * 		parameter:
+	 * 			other: the sketch to be merged into this one
+	 */
+	void merge(const ScoreSketch &other);
+
+	/**
+	 * getPercentile: returns the fraction of recorded scores that are lower than the given score
+	 * 		parameter:
+	 * 			score: the score to be ranked
+	 * 		return: a number between 0 and 1 (0 if the sketch is empty)
+	 */
+	double getPercentile(int score) const;
+
+	/**
+	 * getQuantile: returns the approximate score at the given quantile
+	 * 		parameter:
+	 * 			q: the quantile between 0 and 1 (0.5 being the median)
+	 * 		return: the score at the given quantile (0 if the sketch is empty)
+	 */
+	int getQuantile(double q) const;
+
+	/**
+	 * getCount: returns the number of scores recorded in the sketch
+	 */
+	long long getCount() const {
+		return m_count;
+	}
+
+	/**
+	 * clear: removes every recorded score
+	 */
+	void clear();
+
+	/**
+	 * write: writes the non empty buckets of the sketch to the stream
+	 */
+	void write(std::ostream &out) const;
+
+	/**
+	 * read: reads a sketch written by write and merges it into this sketch
+	 * 		return:
+	 * 			true: if the sketch was read successfully
+	 * 			false: if the stream does not contain a valid sketch, nothing is merged then
+	 */
+	bool read(std::istream &in);
+
+protected:
+
+	/**
+	 * bucketIndex: returns the index of the bucket the score belongs to
+	 */
+	static int bucketIndex(int score);
+
+	/**
+	 * bucketValue: returns the score that represents the bucket at the given index
+	 * (the last buckets lie beyond INT_MAX, they are represented by INT_MAX)
+	 */
+	static int bucketValue(int index);
+
+	//Number of scores in each bucket
+	unsigned int m_buckets[NUM_BUCKETS];
+
+	//Total number of scores recorded
+	long long m_count;
+};
+
+#endif /* SCORESKETCH_H_ */
@@ -0,0 +1,48 @@
+//============================================================================
+// Name        : ScoreSource.h
+// Author      : Amrit Dhakal
+// Version     : 1.0
+// Copyright   : © Amrit Dhakal 2015. All right reserved. :D
+// Description : Interface for reading a ranked score list page by page
+//============================================================================
+
+#ifndef SCORESOURCE_H_
+#define SCORESOURCE_H_
+
+#include <string>
+#include <vector>
+#include <utility>
+
+typedef std::pair<std::string, int> ScorePair;
+
+/**
+ * Class ScoreSource is a ranked list of scores that can be read one page at a
+ * time, so that a view only ever copies the rows it shows.
+ */
+class ScoreSource {
+public:
+	virtual ~ScoreSource() {
+	}
+
+	/**
+	 * getNumScores: returns the number of scores in the list
+	 */
+	virtual int getNumScores() const = 0;
+
+	/**
+	 * getScores: copies a page of the list, best score first
+	 * 		parameter:
+	 * 			first: rank of the first score of the page (0 being the best)
+	 * 			count: maximum number of scores to copy
+	 * 			page: filled with the scores (fewer than count at the end of the list)
+	 */
+	virtual void getScores(int first, int count, std::vector<ScorePair> &page) const = 0;
+
+	/**
+	 * getVersion: returns a number that changes whenever the list changes, so a view
+	 * can tell that its page is out of date
+	 */
+	virtual unsigned long getVersion() const = 0;
+};
+
+#endif /* SCORESOURCE_H_ */
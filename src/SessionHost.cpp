@@ -0,0 +1,561 @@
+//============================================================================
+// Name        : SessionHost.cpp
+// Author      : Amrit Dhakal
+// Version     : 1.0
+// Copyright   : © Amrit Dhakal 2015. All right reserved. :D
+// Description : Thousands of games at once, played over the headless protocol
+//============================================================================
+
+#include "SessionHost.h"
+#include "GameConstants.h"
+#include "Profiler.h"
+
+#include <iostream>
+#include <thread>
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <signal.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <stdint.h>
+#include <limits.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+
+using namespace std;
+
+//Set by the signal handler to stop the host
+static volatile sig_atomic_t stopRequested = 0;
+
+static void requestStop(int){
+	stopRequested = 1;
+}
+
+static bool setNonBlocking(int fd){
+	int flags = fcntl(fd, F_GETFL, 0);
+	return flags >= 0 && fcntl(fd, F_SETFL, flags | O_NONBLOCK) == 0;
+}
+
+/**
+ * Resident memory of the process (bytes), 0 where /proc is missing
+ */
+static size_t residentMemory(){
+	FILE *statm = fopen("/proc/self/statm", "r");
+	if(!statm){
+		return 0;
+	}
+	unsigned long size = 0, resident = 0;
+	int read = fscanf(statm, "%lu %lu", &size, &resident);
+	fclose(statm);
+	return read == 2 ? resident * sysconf(_SC_PAGESIZE) : 0;
+}
+
+SessionHost::Session::Session(long long id, const shared_ptr<Connection> &connection):
+					rules(0),
+					id(id),
+					shownBoard(rules.getBoard()),
+					lastCommand(chrono::steady_clock::now()),
+					connection(connection),
+					scheduled(false)
+{
+}
+
+SessionHost::Connection::Connection(int fd):
+					fd(fd),
+					closed(false),
+					closing(false),
+					unanswered(0),
+					flushQueued(false)
+{
+}
+
+SessionHost::Worker::Worker():
+					commands(0)
+{
+}
+
+SessionHost::SessionArena::SessionArena():
+					mLive(0)
+{
+}
+
+SessionHost::SessionArena::~SessionArena(){
+	for(int i = 0; i < mChunks.size(); i++){
+		delete[] mChunks[i];
+	}
+}
+
+SessionHost::Session* SessionHost::SessionArena::allocate(long long id, const shared_ptr<Connection> &connection){
+	Slot *slot;
+	{
+		lock_guard<mutex> lock(mMutex);
+		if(mFree.empty()){
+			Slot *chunk = new Slot[SESSION_ARENA_CHUNK];
+			mChunks.push_back(chunk);
+			//Handed out from the start of the chunk
+			for(int i = SESSION_ARENA_CHUNK - 1; i >= 0; i--){
+				mFree.push_back(chunk + i);
+			}
+		}
+		slot = mFree.back();
+		mFree.pop_back();
+		mLive++;
+	}
+	return new(slot) Session(id, connection);
+}
+
+void SessionHost::SessionArena::release(Session *session){
+	session->~Session();
+	lock_guard<mutex> lock(mMutex);
+	mFree.push_back(reinterpret_cast<Slot*>(session));
+	mLive--;
+}
+
+size_t SessionHost::SessionArena::getLive() const {
+	lock_guard<mutex> lock(mMutex);
+	return mLive;
+}
+
+size_t SessionHost::SessionArena::getReserved() const {
+	lock_guard<mutex> lock(mMutex);
+	return mChunks.size() * SESSION_ARENA_CHUNK * sizeof(Slot);
+}
+
+SessionHost::SessionHost(const string &socketPath, int workers):
+					m_socketPath(socketPath),
+					m_listenFd(-1),
+					m_epollFd(-1),
+					m_wakeFd(-1),
+					m_nextSession(1)
+{
+	if(workers <= 0){
+		workers = max(1, (int)thread::hardware_concurrency());
+	}
+	for(int i = 0; i < workers; i++){
+		m_workers.push_back(unique_ptr<Worker>(new Worker()));
+	}
+	m_executor.reset(new WorkStealingExecutor(workers));
+}
+
+SessionHost::~SessionHost() {
+	while(!m_connections.empty()){
+		disconnect(m_connections.begin()->first);
+	}
+	//Plays the closes queued, which frees every game
+	m_executor.reset();
+	if(m_listenFd >= 0){
+		close(m_listenFd);
+		unlink(m_socketPath.c_str());
+	}
+	if(m_epollFd >= 0){
+		close(m_epollFd);
+	}
+	if(m_wakeFd >= 0){
+		close(m_wakeFd);
+	}
+}
+
+void SessionHost::enqueue(Session *session, const Pending &pending){
+	bool schedule;
+	{
+		lock_guard<mutex> lock(session->mutex);
+		session->inbox.push_back(pending);
+		schedule = !session->scheduled;
+		session->scheduled = true;
+	}
+	if(schedule){
+		m_executor->submit([this, session](int worker){
+			runSession(session, worker);
+		});
+	}
+}
+
+void SessionHost::runSession(Session *session, int index){
+	PROFILE_SCOPE("SessionHost::runSession");
+	Worker &worker = *m_workers[index];
+	worker.batch.clear();
+	{
+		lock_guard<mutex> lock(session->mutex);
+		worker.batch.swap(session->inbox);
+	}
+
+	worker.out.clear();
+	bool closed = false;
+	for(int i = 0; i < worker.batch.size(); i++){
+		const GameRequest &request = worker.batch[i].request;
+		if(request.cmd == "close"){
+			//Nothing is queued after a close, the IO thread forgot the game first
+			worker.out += "{";
+			if(!request.id.empty()){
+				worker.out += "\"id\":" + request.id + ",";
+			}
+			worker.out += "\"session\":";
+			GameProtocol::appendInt(worker.out, session->id);
+			worker.out += ",\"closed\":true}\n";
+			closed = true;
+			break;
+		}
+		handleRequest(*session, request, worker);
+	}
+	chrono::steady_clock::time_point answered = chrono::steady_clock::now();
+	shared_ptr<Connection> connection = session->connection;
+	respond(connection, worker.out, worker.batch.size());
+	{
+		lock_guard<mutex> lock(worker.mutex);
+		for(int i = 0; i < worker.batch.size(); i++){
+			long long nanoseconds = chrono::duration_cast<chrono::nanoseconds>(answered - worker.batch[i].received).count();
+			worker.latency.add((int)min(nanoseconds, (long long)INT_MAX));
+		}
+		worker.commands += worker.batch.size();
+	}
+
+	if(closed){
+		m_arena.release(session);
+		return;
+	}
+	bool more;
+	{
+		lock_guard<mutex> lock(session->mutex);
+		more = !session->inbox.empty();
+		session->scheduled = more;
+	}
+	if(more){
+		//Back in the queue rather than played on, so a busy game does not hold up the others
+		m_executor->submit([this, session](int worker){
+			runSession(session, worker);
+		});
+	}
+}
+
+void SessionHost::handleRequest(Session &session, const GameRequest &request, Worker &worker){
+	worker.events.clear();
+	worker.changed.clear();
+	if(request.cmd != "state"){
+		GameCommand command;
+		const char *invalid = GameProtocol::toCommand(request, session.rules.getDim(), command);
+		if(invalid){
+			GameProtocol::appendError(worker.out, request, invalid);
+			return;
+		}
+		chrono::steady_clock::time_point now = chrono::steady_clock::now();
+		session.rules.advanceTime(chrono::duration<double>(now - session.lastCommand).count());
+		session.rules.apply(command, worker.events, worker.changed);
+		session.lastCommand = now;
+	}
+
+	bool newBoard = session.rules.getBoard() != session.shownBoard;
+	GameProtocol::appendResponse(worker.out, request, session.rules, newBoard, worker.changed, worker.events);
+	session.shownBoard = session.rules.getBoard();
+}
+
+void SessionHost::routeRequest(const shared_ptr<Connection> &connection, const char *begin, const char *end){
+	Pending pending;
+	GameRequest &request = pending.request;
+	string error;
+	if(!GameProtocol::parseRequest(begin, end, request, error)){
+		GameProtocol::appendError(connection->sending, request, error.c_str());
+		return;
+	}
+	pending.received = chrono::steady_clock::now();
+
+	Session *target;
+	if(request.cmd == "new" && request.session < 0){
+		request.session = m_nextSession++;
+		target = m_arena.allocate(request.session, connection);
+		connection->sessions[request.session] = target;
+	}
+	else {
+		unordered_map<long long, Session*>::iterator session = connection->sessions.find(request.session);
+		if(session == connection->sessions.end()){
+			GameProtocol::appendError(connection->sending, request, request.session < 0 ? "missing session" : "no such session");
+			return;
+		}
+		target = session->second;
+		if(request.cmd == "close"){
+			connection->sessions.erase(session);
+		}
+	}
+	{
+		lock_guard<mutex> lock(connection->mutex);
+		connection->unanswered++;
+	}
+	enqueue(target, pending);
+}
+
+void SessionHost::routeLines(const shared_ptr<Connection> &connection){
+	string &in = connection->in;
+	size_t offset = 0;
+	size_t newline;
+	while((newline = in.find('\n', offset)) != string::npos){
+		const char *begin = in.data() + offset;
+		const char *end = in.data() + newline;
+		if(!GameProtocol::isBlank(begin, end)){
+			routeRequest(connection, begin, end);
+		}
+		offset = newline + 1;
+	}
+	in.erase(0, offset);
+}
+
+void SessionHost::respond(const shared_ptr<Connection> &connection, const string &out, int answered){
+	if((out.empty() && answered == 0) || connection->closed){
+		return;
+	}
+	{
+		lock_guard<mutex> lock(connection->mutex);
+		connection->out += out;
+		connection->unanswered -= answered;
+	}
+	bool wake;
+	{
+		lock_guard<mutex> lock(m_flushMutex);
+		if(connection->flushQueued){
+			return;
+		}
+		connection->flushQueued = true;
+		//The IO thread is woken once for everything answered since it last looked
+		wake = m_flushing.empty();
+		m_flushing.push_back(connection);
+	}
+	if(wake){
+		uint64_t one = 1;
+		ssize_t written = write(m_wakeFd, &one, sizeof(one));
+		(void)written;
+	}
+}
+
+void SessionHost::flushQueued(){
+	uint64_t count;
+	ssize_t received = read(m_wakeFd, &count, sizeof(count));
+	(void)received;
+	vector<shared_ptr<Connection> > flushing;
+	{
+		lock_guard<mutex> lock(m_flushMutex);
+		flushing.swap(m_flushing);
+		for(int i = 0; i < flushing.size(); i++){
+			flushing[i]->flushQueued = false;
+		}
+	}
+	for(int i = 0; i < flushing.size(); i++){
+		Connection &connection = *flushing[i];
+		if(!connection.closed && !flushClient(connection)){
+			disconnect(connection.fd);
+		}
+	}
+}
+
+void SessionHost::report(double elapsed){
+	ScoreSketch latency;
+	long long commands = 0;
+	for(int i = 0; i < m_workers.size(); i++){
+		Worker &worker = *m_workers[i];
+		lock_guard<mutex> lock(worker.mutex);
+		latency.merge(worker.latency);
+		commands += worker.commands;
+		worker.latency.clear();
+		worker.commands = 0;
+	}
+	size_t sessions = m_arena.getLive();
+	size_t arena = m_arena.getReserved();
+	size_t resident = residentMemory();
+	char line[256];
+	int length = snprintf(line, sizeof(line), "sessions %zu (%.1f per core), %.0f commands/s, p99 latency %.1f us",
+			sessions, (double)sessions / m_workers.size(), commands / elapsed, latency.getQuantile(0.99) / 1000.0);
+	if(sessions > 0){
+		snprintf(line + length, sizeof(line) - length, ", memory per session %zu bytes (arena %zu, resident %zu)",
+				sizeof(Session), arena / sessions, resident / sessions);
+	}
+	cout << line << endl;
+}
+
+bool SessionHost::run(){
+	signal(SIGINT, requestStop);
+	signal(SIGTERM, requestStop);
+	signal(SIGPIPE, SIG_IGN);
+	if(!listen()){
+		return false;
+	}
+	cout << "Session host listening on " << m_socketPath << " with "
+			<< m_workers.size() << " workers" << endl;
+
+	const int MAX_EVENTS = 64;
+	struct epoll_event events[MAX_EVENTS];
+	chrono::steady_clock::time_point lastReport = chrono::steady_clock::now();
+	while(!stopRequested){
+		int count = epoll_wait(m_epollFd, events, MAX_EVENTS, 1000);
+		for(int i = 0; i < count; i++){
+			int fd = events[i].data.fd;
+			if(fd == m_listenFd){
+				acceptClients();
+				continue;
+			}
+			if(fd == m_wakeFd){
+				flushQueued();
+				continue;
+			}
+			map<int, shared_ptr<Connection> >::iterator connection = m_connections.find(fd);
+			if(connection == m_connections.end()){
+				continue;
+			}
+			bool alive = !(events[i].events & (EPOLLERR | EPOLLHUP));
+			if(alive && (events[i].events & (EPOLLIN | EPOLLRDHUP))){
+				alive = readClient(connection->second);
+			}
+			if(alive && (events[i].events & EPOLLOUT)){
+				alive = flushClient(*connection->second);
+			}
+			if(!alive){
+				disconnect(fd);
+			}
+		}
+
+		chrono::steady_clock::time_point now = chrono::steady_clock::now();
+		double elapsed = chrono::duration<double>(now - lastReport).count();
+		if(elapsed >= SESSION_HOST_REPORT_INTERVAL){
+			report(elapsed);
+			lastReport = now;
+		}
+	}
+	return true;
+}
+
+bool SessionHost::listen(){
+	m_listenFd = socket(AF_UNIX, SOCK_STREAM, 0);
+	if(m_listenFd < 0){
+		cerr << "Session host socket could not be created: " << strerror(errno) << endl;
+		return false;
+	}
+	struct sockaddr_un address;
+	memset(&address, 0, sizeof(address));
+	address.sun_family = AF_UNIX;
+	strncpy(address.sun_path, m_socketPath.c_str(), sizeof(address.sun_path) - 1);
+	unlink(m_socketPath.c_str());
+	if(bind(m_listenFd, (struct sockaddr*)&address, sizeof(address)) != 0
+			|| ::listen(m_listenFd, SOMAXCONN) != 0 || !setNonBlocking(m_listenFd)){
+		cerr << "Session host socket " << m_socketPath << " could not be opened: " << strerror(errno) << endl;
+		return false;
+	}
+	m_epollFd = epoll_create1(0);
+	m_wakeFd = eventfd(0, EFD_NONBLOCK);
+	if(m_epollFd < 0 || m_wakeFd < 0){
+		return false;
+	}
+	struct epoll_event event;
+	memset(&event, 0, sizeof(event));
+	event.events = EPOLLIN;
+	event.data.fd = m_listenFd;
+	if(epoll_ctl(m_epollFd, EPOLL_CTL_ADD, m_listenFd, &event) != 0){
+		return false;
+	}
+	event.data.fd = m_wakeFd;
+	return epoll_ctl(m_epollFd, EPOLL_CTL_ADD, m_wakeFd, &event) == 0;
+}
+
+void SessionHost::acceptClients(){
+	int fd;
+	while((fd = accept(m_listenFd, 0, 0)) >= 0){
+		struct epoll_event event;
+		memset(&event, 0, sizeof(event));
+		event.events = EPOLLIN | EPOLLRDHUP;
+		event.data.fd = fd;
+		if(!setNonBlocking(fd) || epoll_ctl(m_epollFd, EPOLL_CTL_ADD, fd, &event) != 0){
+			close(fd);
+			continue;
+		}
+		m_connections[fd] = make_shared<Connection>(fd);
+	}
+}
+
+void SessionHost::disconnect(int fd){
+	map<int, shared_ptr<Connection> >::iterator found = m_connections.find(fd);
+	if(found == m_connections.end()){
+		return;
+	}
+	shared_ptr<Connection> connection = found->second;
+	m_connections.erase(found);
+	connection->closed = true;
+	epoll_ctl(m_epollFd, EPOLL_CTL_DEL, fd, 0);
+	close(fd);
+
+	//The games end on their workers, after the requests already queued for them
+	Pending pending;
+	pending.request.cmd = "close";
+	pending.received = chrono::steady_clock::now();
+	for(unordered_map<long long, Session*>::iterator session = connection->sessions.begin();
+			session != connection->sessions.end(); ++session){
+		enqueue(session->second, pending);
+	}
+	connection->sessions.clear();
+}
+
+bool SessionHost::readClient(const shared_ptr<Connection> &connection){
+	char buffer[64 * 1024];
+	ssize_t received;
+	while((received = recv(connection->fd, buffer, sizeof(buffer), 0)) > 0){
+		connection->in.append(buffer, received);
+		//Requests sent just before the client closed the connection are still answered
+		routeLines(connection);
+		if(connection->in.size() > GameProtocol::MAX_LINE){
+			return false;
+		}
+	}
+	if(received < 0 && errno != EAGAIN && errno != EWOULDBLOCK){
+		return false;
+	}
+	//After a half-close the games still answer what was queued, and it is sent
+	//before the connection goes
+	connection->closing = received == 0;
+	return flushClient(*connection);
+}
+
+bool SessionHost::flushClient(Connection &connection){
+	bool answered;
+	{
+		lock_guard<mutex> lock(connection.mutex);
+		connection.sending += connection.out;
+		connection.out.clear();
+		//Read with the output, so no answer can be left behind in out
+		answered = connection.unanswered == 0;
+	}
+	string &sending = connection.sending;
+	size_t sentTotal = 0;
+	while(sentTotal < sending.size()){
+		ssize_t sent = send(connection.fd, sending.data() + sentTotal, sending.size() - sentTotal, MSG_NOSIGNAL);
+		if(sent < 0){
+			if(errno != EAGAIN && errno != EWOULDBLOCK){
+				return false;
+			}
+			break;
+		}
+		sentTotal += sent;
+	}
+	sending.erase(0, sentTotal);
+	if(sending.size() > GameProtocol::MAX_PENDING_OUTPUT){
+		//The client sends requests without reading the responses
+		return false;
+	}
+	if(connection.closing && answered && sending.empty()){
+		return false;
+	}
+	//Wait for the socket to be writable only while there is something left to send,
+	//and no longer for input once the client has nothing more to send (the workers
+	//wake the IO thread with the remaining answers)
+	struct epoll_event event;
+	memset(&event, 0, sizeof(event));
+	event.events = (connection.closing ? 0 : EPOLLIN | EPOLLRDHUP) | (sending.empty() ? 0 : EPOLLOUT);
+	event.data.fd = connection.fd;
+	return epoll_ctl(m_epollFd, EPOLL_CTL_MOD, connection.fd, &event) == 0;
+}
+
+int SessionHost::main(int argc, char *argv[]){
+	if(argc < 1){
+		cerr << "Usage: MineSweeper --session-host socket [workers]" << endl;
+		return 1;
+	}
+	SessionHost host(argv[0], argc > 1 ? atoi(argv[1]) : 0);
+	return host.run() ? 0 : 1;
+}
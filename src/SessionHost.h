@@ -0,0 +1,279 @@
+//============================================================================
+// Name        : SessionHost.h
+// Author      : Amrit Dhakal
+// Version     : 1.0
+// Copyright   : © Amrit Dhakal 2015. All right reserved. :D
+// Description : Thousands of games at once, played over the headless protocol
+//============================================================================
+
+#ifndef SESSIONHOST_H_
+#define SESSIONHOST_H_
+
+#include "GameProtocol.h"
+#include "WorkStealingExecutor.h"
+#include "ScoreSketch.h"
+#include <string>
+#include <vector>
+#include <map>
+#include <unordered_map>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <type_traits>
+
+/**
+ * Class SessionHost holds thousands of independent games in one process, for the
+ * tournament back end. It speaks the protocol of HeadlessServer on a UNIX domain
+ * socket, but a connection (a front end) plays any number of games, told apart by
+ * "session":
+ * 		{"id":1,"cmd":"new","seed":7}			opens a game, the response holds its "session"
+ * 		{"id":2,"session":4,"cmd":"reveal","cell":12}
+ * 		{"id":3,"session":4,"cmd":"close"}		ends the game: {"id":3,"session":4,"closed":true}
+ * The games of a connection end with it. Responses to the requests of one game come
+ * in order, those of different games in any order.
+ *
+ * One thread reads the requests and routes them to their game; the games are played
+ * by a WorkStealingExecutor, one worker at a time per game so its commands keep their
+ * order. Every game lives in a slot of the SessionArena, its cells inline.
+ *
+ * Every SESSION_HOST_REPORT_INTERVAL seconds the sessions per core, the commands per
+ * second, the 99th percentile command latency (from the request being read to its
+ * response being ready) and the memory per session are printed.
+ *
+ * Run with: MineSweeper --session-host socket [workers]
+ */
+class SessionHost {
+public:
+
+	/**
+	 * Constructor:
+	 * 		parameter:
+	 * 			socketPath: UNIX domain socket to listen on
+	 * 			workers: number of threads playing the games, 0 for one a core
+	 */
+	SessionHost(const std::string &socketPath, int workers);
+
+	/**
+	 * Destructor: ends every game, closes every socket and removes the socket file
+	 */
+	virtual ~SessionHost();
+
+	/**
+	 * run: serves requests until SIGINT or SIGTERM is received
+	 * 		return: false if the socket could not be opened
+	 */
+	bool run();
+
+	/**
+	 * main: parses the command line arguments following --session-host and runs the host
+	 * 		return: the exit code of the program
+	 */
+	static int main(int argc, char *argv[]);
+
+protected:
+	struct Connection;
+
+	/**
+	 * A request waiting for its game, with when it was read
+	 */
+	struct Pending {
+		GameRequest request;
+		std::chrono::steady_clock::time_point received;
+	};
+
+	/**
+	 * A game being played
+	 */
+	struct Session {
+		Session(long long id, const std::shared_ptr<Connection> &connection);
+
+		GameRules rules;
+		long long id;
+		unsigned int shownBoard;
+		std::chrono::steady_clock::time_point lastCommand;
+		std::shared_ptr<Connection> connection;
+
+		/**
+		 * Guards the requests not played yet, and whether the game is given to a
+		 * worker; it is given to at most one at a time
+		 */
+		std::mutex mutex;
+		std::vector<Pending> inbox;
+		bool scheduled;
+	};
+
+	/**
+	 * A front end connected to the host
+	 */
+	struct Connection {
+		Connection(int fd);
+
+		int fd;
+		std::atomic<bool> closed;
+
+		//Read and routed by the IO thread only
+		std::string in;
+		std::unordered_map<long long, Session*> sessions;
+
+		//The client is done sending; it is disconnected once every request is
+		//answered and sent (IO thread only)
+		bool closing;
+
+		//Responses ready, appended by the workers
+		std::mutex mutex;
+		std::string out;
+
+		//Requests queued for the games and not answered yet, guarded by mutex
+		int unanswered;
+
+		//Responses being sent by the IO thread
+		std::string sending;
+
+		//Waiting in m_flushing, guarded by m_flushMutex
+		bool flushQueued;
+	};
+
+	/**
+	 * Class SessionArena keeps the games in chunks of SESSION_ARENA_CHUNK slots.
+	 * Slots are reused through a free list, so opening and closing games costs no
+	 * allocation once the host has seen its busiest moment, and the games sit next to
+	 * each other rather than all over the heap.
+	 */
+	class SessionArena {
+	public:
+		SessionArena();
+		virtual ~SessionArena();
+
+		/**
+		 * allocate: opens a game in a free slot (any thread)
+		 */
+		Session* allocate(long long id, const std::shared_ptr<Connection> &connection);
+
+		/**
+		 * release: ends the game and frees its slot (any thread)
+		 */
+		void release(Session *session);
+
+		/**
+		 * getLive: returns the number of games open
+		 */
+		size_t getLive() const;
+
+		/**
+		 * getReserved: returns the bytes taken by the chunks
+		 */
+		size_t getReserved() const;
+
+	private:
+		typedef std::aligned_storage<sizeof(Session), alignof(Session)>::type Slot;
+
+		mutable std::mutex mMutex;
+		std::vector<Slot*> mChunks;
+		std::vector<Slot*> mFree;
+		size_t mLive;
+	};
+
+	/**
+	 * What a worker plays the games with, and what it measured since the last report
+	 */
+	struct Worker {
+		Worker();
+
+		std::vector<Pending> batch;
+		std::vector<GameEvent> events;
+		std::vector<int> changed;
+		std::string out;
+
+		//Guards the measures, read by the IO thread for the reports
+		std::mutex mutex;
+		ScoreSketch latency;	//nanoseconds
+		long long commands;
+	};
+
+	/**
+	 * Queues a request for its game, giving the game to a worker if none has it
+	 */
+	void enqueue(Session *session, const Pending &pending);
+
+	/**
+	 * Plays the requests queued for the game (on a worker)
+	 */
+	void runSession(Session *session, int worker);
+
+	/**
+	 * Answers one request of a game into the worker's output
+	 */
+	void handleRequest(Session &session, const GameRequest &request, Worker &worker);
+
+	/**
+	 * Reads the requests of the connection's input and routes them to their games
+	 */
+	void routeLines(const std::shared_ptr<Connection> &connection);
+
+	/**
+	 * Routes one request line to its game, answering errors at once
+	 */
+	void routeRequest(const std::shared_ptr<Connection> &connection, const char *begin, const char *end);
+
+	/**
+	 * Appends the responses to a number of requests to the connection's responses
+	 * and has the IO thread send them (any thread)
+	 */
+	void respond(const std::shared_ptr<Connection> &connection, const std::string &out, int answered);
+
+	/**
+	 * Sends the responses of the connections the workers answered for
+	 */
+	void flushQueued();
+
+	/**
+	 * Prints the report and clears the measures
+	 */
+	void report(double elapsed);
+
+	bool listen();
+	void acceptClients();
+
+	/**
+	 * Reads everything available from the client and routes its requests
+	 * 		return: false if the client has to be disconnected
+	 */
+	bool readClient(const std::shared_ptr<Connection> &connection);
+
+	/**
+	 * Sends as much of the responses as the socket accepts
+	 * 		return: false if the client has to be disconnected (a closing client
+	 * 		once everything is answered and sent)
+	 */
+	bool flushClient(Connection &connection);
+
+	/**
+	 * Closes the connection to the client and ends its games
+	 */
+	void disconnect(int fd);
+
+	//Path of the socket
+	std::string m_socketPath;
+
+	//Listening socket, epoll instance and the eventfd the workers wake the IO thread with
+	int m_listenFd;
+	int m_epollFd;
+	int m_wakeFd;
+
+	//Connections by socket
+	std::map<int, std::shared_ptr<Connection> > m_connections;
+
+	//Id of the next game
+	long long m_nextSession;
+
+	//Connections with responses to send
+	std::mutex m_flushMutex;
+	std::vector<std::shared_ptr<Connection> > m_flushing;
+
+	SessionArena m_arena;
+	std::vector<std::unique_ptr<Worker> > m_workers;
+	std::unique_ptr<WorkStealingExecutor> m_executor;
+};
+
+#endif /* SESSIONHOST_H_ */
@@ -0,0 +1,200 @@
+//============================================================================
+// Name        : VertexCache.cpp
+// Author      : Amrit Dhakal
+// Version     : 1.0
+// Copyright   : © Amrit Dhakal 2015. All right reserved. :D
+// Description : Triangle ordering for the post-transform vertex cache
+//============================================================================
+
+#include "VertexCache.h"
+
+#include <algorithm>
+#include <deque>
+#include <math.h>
+
+using namespace std;
+
+//Size of the cache the scores are tuned for
+static const int CACHE_SIZE = 32;
+
+//Score of the vertices of the last triangle, whatever their order
+static const float LAST_TRIANGLE_SCORE = 0.75f;
+static const float CACHE_DECAY_POWER = 1.5f;
+static const float VALENCE_BOOST_SCALE = 2.0f;
+static const float VALENCE_BOOST_POWER = 0.5f;
+
+/**
+ * Returns how much emitting a triangle using the vertex is worth
+ * 		parameter:
+ * 			cachePosition: position of the vertex in the cache, -1 if not in it
+ * 			remaining: number of triangles not yet emitted that use the vertex
+ */
+static float vertexScore(int cachePosition, uint32_t remaining){
+	if(remaining == 0){
+		return -1;
+	}
+	float score = 0;
+	if(cachePosition >= 0){
+		if(cachePosition < 3){
+			score = LAST_TRIANGLE_SCORE;
+		}
+		else {
+			float scale = 1.0f / (CACHE_SIZE - 3);
+			score = powf(1.0f - (cachePosition - 3) * scale, CACHE_DECAY_POWER);
+		}
+	}
+	//Vertices with few triangles left are finished first so they can leave the cache
+	return score + VALENCE_BOOST_SCALE * powf(remaining, -VALENCE_BOOST_POWER);
+}
+
+void optimizeVertexCache(vector<uint32_t> &indices, uint32_t numVertices){
+	uint32_t numTriangles = indices.size() / 3;
+	if(numTriangles == 0){
+		return;
+	}
+
+	//Triangles of each vertex: mTriangles[mFirst[v] .. mFirst[v] + remaining[v])
+	vector<uint32_t> remaining(numVertices, 0);
+	for(int i = 0; i < numTriangles * 3; i++){
+		remaining[indices[i]]++;
+	}
+	vector<uint32_t> first(numVertices + 1, 0);
+	for(uint32_t v = 0; v < numVertices; v++){
+		first[v + 1] = first[v] + remaining[v];
+	}
+	vector<uint32_t> triangles(numTriangles * 3);
+	vector<uint32_t> filled(first.begin(), first.end() - 1);
+	for(uint32_t t = 0; t < numTriangles; t++){
+		for(int k = 0; k < 3; k++){
+			uint32_t v = indices[t * 3 + k];
+			triangles[filled[v]++] = t;
+		}
+	}
+
+	vector<int> cachePosition(numVertices, -1);
+	vector<float> score(numVertices);
+	for(uint32_t v = 0; v < numVertices; v++){
+		score[v] = vertexScore(-1, remaining[v]);
+	}
+	vector<float> triangleScore(numTriangles);
+	vector<bool> emitted(numTriangles, false);
+	for(uint32_t t = 0; t < numTriangles; t++){
+		triangleScore[t] = score[indices[t * 3]] + score[indices[t * 3 + 1]] + score[indices[t * 3 + 2]];
+	}
+
+	vector<uint32_t> out;
+	out.reserve(numTriangles * 3);
+	vector<uint32_t> cache;
+	vector<uint32_t> newCache;
+	uint32_t scanFrom = 0;
+	int best = -1;
+
+	for(uint32_t emittedCount = 0; emittedCount < numTriangles; emittedCount++){
+		if(best < 0){
+			//Nothing in the cache is worth anything: take the best triangle left
+			float bestScore = -1e30f;
+			for(uint32_t t = scanFrom; t < numTriangles; t++){
+				if(!emitted[t] && triangleScore[t] > bestScore){
+					bestScore = triangleScore[t];
+					best = t;
+				}
+			}
+			while(scanFrom < numTriangles && emitted[scanFrom]){
+				scanFrom++;
+			}
+		}
+
+		//Emit the triangle and take it out of its vertices' lists
+		emitted[best] = true;
+		newCache.clear();
+		for(int k = 0; k < 3; k++){
+			uint32_t v = indices[best * 3 + k];
+			out.push_back(v);
+			newCache.push_back(v);
+			uint32_t* list = &triangles[first[v]];
+			uint32_t* end = list + remaining[v];
+			uint32_t* found = find(list, end, (uint32_t)best);
+			*found = *(end - 1);
+			remaining[v]--;
+		}
+
+		//Its vertices go to the front of the cache
+		for(int i = 0; i < cache.size(); i++){
+			uint32_t v = cache[i];
+			if(v != newCache[0] && v != newCache[1] && v != newCache[2]){
+				newCache.push_back(v);
+			}
+		}
+		for(int i = CACHE_SIZE; i < newCache.size(); i++){
+			cachePosition[newCache[i]] = -1;
+		}
+		if(newCache.size() > CACHE_SIZE){
+			//The vertices that fell out still need their scores updated below
+			cache.assign(newCache.begin() + CACHE_SIZE, newCache.end());
+			newCache.resize(CACHE_SIZE);
+		}
+		else {
+			cache.clear();
+		}
+		for(int i = 0; i < newCache.size(); i++){
+			cachePosition[newCache[i]] = i;
+		}
+
+		//Rescore the vertices whose position changed and the triangles using them
+		best = -1;
+		float bestScore = -1;
+		for(int pass = 0; pass < 2; pass++){
+			const vector<uint32_t> &vertices = pass == 0 ? cache : newCache;
+			for(int i = 0; i < vertices.size(); i++){
+				uint32_t v = vertices[i];
+				float newScore = vertexScore(cachePosition[v], remaining[v]);
+				float delta = newScore - score[v];
+				score[v] = newScore;
+				for(uint32_t j = 0; j < remaining[v]; j++){
+					uint32_t t = triangles[first[v] + j];
+					triangleScore[t] += delta;
+					if(pass == 1 && triangleScore[t] > bestScore){
+						bestScore = triangleScore[t];
+						best = t;
+					}
+				}
+			}
+		}
+		cache.swap(newCache);
+	}
+	indices.swap(out);
+}
+
+vector<uint32_t> optimizeVertexFetch(vector<uint32_t> &indices, uint32_t numVertices){
+	const uint32_t UNUSED = 0xffffffff;
+	vector<uint32_t> remap(numVertices, UNUSED);
+	vector<uint32_t> order;
+	for(int i = 0; i < indices.size(); i++){
+		uint32_t &index = indices[i];
+		if(remap[index] == UNUSED){
+			remap[index] = order.size();
+			order.push_back(index);
+		}
+		index = remap[index];
+	}
+	return order;
+}
+
+double averageCacheMissRatio(const vector<uint32_t> &indices, int cacheSize){
+	if(indices.size() < 3){
+		return 0;
+	}
+	deque<uint32_t> cache;
+	int misses = 0;
+	for(int i = 0; i < indices.size(); i++){
+		if(find(cache.begin(), cache.end(), indices[i]) != cache.end()){
+			continue;
+		}
+		misses++;
+		cache.push_back(indices[i]);
+		if(cache.size() > cacheSize){
+			cache.pop_front();
+		}
+	}
+	return misses / (indices.size() / 3.0);
+}
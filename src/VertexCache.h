@@ -0,0 +1,42 @@
+//============================================================================
+// Name        : VertexCache.h
+// Author      : Amrit Dhakal
+// Version     : 1.0
+// Copyright   : © Amrit Dhakal 2015. All right reserved. :D
+// Description : Triangle ordering for the post-transform vertex cache
+//============================================================================
+
+#ifndef VERTEXCACHE_H_
+#define VERTEXCACHE_H_
+
+#include <vector>
+#include <stdint.h>
+
+/**
+ * optimizeVertexCache: reorders the triangles of an indexed triangle list so
+ * that vertices are reused while still in the post-transform cache
+ * (Tom Forsyth's linear-speed vertex cache optimisation)
+ * 		parameter:
+ * 			indices: three indices per triangle, reordered in place
+ * 			numVertices: number of vertices the indices refer to
+ */
+void optimizeVertexCache(std::vector<uint32_t> &indices, uint32_t numVertices);
+
+/**
+ * optimizeVertexFetch: renumbers the vertices in the order the triangles first use
+ * them, so the vertex buffer is read front to back
+ * 		parameter:
+ * 			indices: three indices per triangle, renumbered in place
+ * 			numVertices: number of vertices the indices refer to
+ * 		return: for each new vertex, the old vertex it is copied from. Vertices no
+ * 			triangle uses are dropped.
+ */
+std::vector<uint32_t> optimizeVertexFetch(std::vector<uint32_t> &indices, uint32_t numVertices);
+
+/**
+ * averageCacheMissRatio: returns the number of vertices transformed per triangle
+ * with a FIFO cache of the given size (1 is good, 3 is the worst)
+ */
+double averageCacheMissRatio(const std::vector<uint32_t> &indices, int cacheSize);
+
+#endif /* VERTEXCACHE_H_ */
@@ -0,0 +1,106 @@
+//============================================================================
+// Name        : WorkStealingExecutor.cpp
+// Author      : Amrit Dhakal
+// Version     : 1.0
+// Copyright   : © Amrit Dhakal 2015. All right reserved. :D
+// Description : Pool of worker threads which steal each other's tasks
+//============================================================================
+
+#include "WorkStealingExecutor.h"
+#include "Profiler.h"
+
+//Executor and index of the worker running on this thread
+static thread_local const WorkStealingExecutor *currentExecutor = 0;
+static thread_local int currentIndex = -1;
+
+WorkStealingExecutor::WorkStealingExecutor(int workers)
+	: mPending(0), mNext(0), mRunning(true)
+{
+	if(workers < 1){
+		workers = 1;
+	}
+	for(int i = 0; i < workers; i++){
+		mQueues.push_back(std::unique_ptr<Queue>(new Queue()));
+	}
+	for(int i = 0; i < workers; i++){
+		mThreads.push_back(std::thread(&WorkStealingExecutor::run, this, i));
+	}
+}
+
+WorkStealingExecutor::~WorkStealingExecutor(){
+	{
+		std::lock_guard<std::mutex> lock(mSleepMutex);
+		mRunning = false;
+	}
+	mWake.notify_all();
+	for(int i = 0; i < mThreads.size(); i++){
+		mThreads[i].join();
+	}
+}
+
+int WorkStealingExecutor::currentWorker() const {
+	return currentExecutor == this ? currentIndex : -1;
+}
+
+void WorkStealingExecutor::submit(const Task &task){
+	int worker = currentWorker();
+	if(worker < 0){
+		worker = mNext++ % mQueues.size();
+	}
+	{
+		std::lock_guard<std::mutex> lock(mQueues[worker]->mutex);
+		mQueues[worker]->tasks.push_back(task);
+	}
+	mPending++;
+	//Taken under the lock the workers check mPending with, so none goes to sleep
+	//between seeing no task and waiting
+	std::lock_guard<std::mutex> lock(mSleepMutex);
+	mWake.notify_one();
+}
+
+bool WorkStealingExecutor::take(int worker, Task &task){
+	{
+		//Own queue, oldest first: a task waits behind no more than what was queued before it
+		Queue &queue = *mQueues[worker];
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		if(!queue.tasks.empty()){
+			task.swap(queue.tasks.front());
+			queue.tasks.pop_front();
+			mPending--;
+			return true;
+		}
+	}
+	//Steal from the back of the others, away from where their owners take from
+	int numQueues = mQueues.size();
+	for(int i = 1; i < numQueues; i++){
+		Queue &victim = *mQueues[(worker + i) % numQueues];
+		std::lock_guard<std::mutex> lock(victim.mutex);
+		if(!victim.tasks.empty()){
+			task.swap(victim.tasks.back());
+			victim.tasks.pop_back();
+			mPending--;
+			return true;
+		}
+	}
+	return false;
+}
+
+void WorkStealingExecutor::run(int worker){
+	PROFILE_THREAD("worker");
+	currentExecutor = this;
+	currentIndex = worker;
+	Task task;
+	while(true){
+		if(take(worker, task)){
+			task(worker);
+			task = Task();
+			continue;
+		}
+		std::unique_lock<std::mutex> lock(mSleepMutex);
+		if(!mRunning){
+			return;
+		}
+		//A task submitted since the queues were looked at leaves mPending up, it is taken at once
+		mWake.wait(lock, [this]{ return mPending > 0 || !mRunning; });
+	}
+}
@@ -0,0 +1,102 @@
+//============================================================================
+// Name        : WorkStealingExecutor.h
+// Author      : Amrit Dhakal
+// Version     : 1.0
+// Copyright   : © Amrit Dhakal 2015. All right reserved. :D
+// Description : Pool of worker threads which steal each other's tasks
+//============================================================================
+
+#ifndef WORKSTEALINGEXECUTOR_H_
+#define WORKSTEALINGEXECUTOR_H_
+
+#include <functional>
+#include <deque>
+#include <vector>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+
+/**
+ * Class WorkStealingExecutor runs tasks on a fixed number of worker threads. Every
+ * worker has a queue of its own: a task submitted by a worker goes to that worker's
+ * queue, which keeps its data in the worker's cache, one submitted from outside is
+ * spread over the queues. A worker whose queue runs dry takes tasks from the others,
+ * so one busy queue never holds the rest of the cores idle.
+ *
+ * Tasks run in no particular order; callers needing an order (SessionHost runs the
+ * commands of a game in order) have to keep at most one task per ordered stream.
+ */
+class WorkStealingExecutor {
+public:
+
+	/**
+	 * A task, given the index of the worker running it
+	 */
+	typedef std::function<void(int)> Task;
+
+	/**
+	 * Constructor: starts the workers
+	 * 		parameter:
+	 * 			workers: number of worker threads, at least 1
+	 */
+	WorkStealingExecutor(int workers);
+
+	/**
+	 * Destructor: stops the workers once every task queued, and every task those
+	 * tasks queue, has run
+	 */
+	virtual ~WorkStealingExecutor();
+
+	/**
+	 * submit: queues a task (any thread)
+	 */
+	void submit(const Task &task);
+
+	/**
+	 * getNumWorkers: returns the number of worker threads
+	 */
+	int getNumWorkers() const {
+		return mQueues.size();
+	}
+
+	/**
+	 * currentWorker: returns the index of the worker of this executor running the
+	 * calling thread, -1 on any other thread
+	 */
+	int currentWorker() const;
+
+private:
+	struct Queue {
+		std::mutex mutex;
+		std::deque<Task> tasks;
+	};
+
+	/**
+	 * take: takes the next task of the worker, from its own queue or stolen
+	 * 		return: false if every queue is empty
+	 */
+	bool take(int worker, Task &task);
+
+	/**
+	 * run: body of a worker thread
+	 */
+	void run(int worker);
+
+	std::vector<std::unique_ptr<Queue> > mQueues;
+	std::vector<std::thread> mThreads;
+
+	/**
+	 * Tasks queued and not taken yet; idle workers sleep on mWake until there are some
+	 */
+	std::atomic<int> mPending;
+	std::mutex mSleepMutex;
+	std::condition_variable mWake;
+
+	//Queue the next task from outside goes to
+	std::atomic<unsigned int> mNext;
+	std::atomic<bool> mRunning;
+};
+
+#endif /* WORKSTEALINGEXECUTOR_H_ */